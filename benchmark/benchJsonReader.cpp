@@ -0,0 +1,117 @@
+
+#include "anyrpc/anyrpc.h"
+#include "anyrpc/internal/time.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace anyrpc;
+
+// Measure the JsonReader on a large bulk insert request.
+// The documents are parsed to a handler that only counts the values so the parser
+// dominates, and to a Document as the server does.
+//
+// A two-stage reader that first built an index of the structural characters with
+// SSE2 bit masks was tried against this benchmark.  The index was built at about
+// 2.5 GB/s, but the whole reader only reached 330 MB/s to the JsonReader's 565 MB/s
+// (Document: 178 vs 232 MB/s) since the scalars were still decoded a character at
+// a time and walking the index added a second pass.  It would need the number and
+// string decoding to use the index as well before it could be faster.
+
+static double MilliSeconds(struct timeval& start, struct timeval& end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+//! Handler that counts the values without storing them
+class CountHandler : public Handler
+{
+public:
+    CountHandler() : count_(0) {}
+
+    virtual void Null() { count_++; }
+    virtual void BoolTrue() { count_++; }
+    virtual void BoolFalse() { count_++; }
+    virtual void DateTime(time_t) { count_++; }
+    virtual void String(const char*, size_t, bool) { count_++; }
+    virtual void Binary(const unsigned char*, size_t, bool) { count_++; }
+    virtual void Int(int) { count_++; }
+    virtual void Uint(unsigned) { count_++; }
+    virtual void Int64(int64_t) { count_++; }
+    virtual void Uint64(uint64_t) { count_++; }
+    virtual void Double(double) { count_++; }
+    virtual void StartMap() {}
+    virtual void Key(const char*, size_t, bool) {}
+    virtual void EndMap(size_t) { count_++; }
+    virtual void StartArray() {}
+    virtual void EndArray(size_t) { count_++; }
+
+    size_t count_;
+};
+
+static void TimeParse(const char* name, WriteStringStream& strStream, Handler* handler, int iterations)
+{
+    size_t jsonLength = strStream.Length();
+    char* json = static_cast<char*>(malloc(jsonLength + 1));
+    double parseTime = 0;
+    for (int n=0; n<iterations; n++)
+    {
+        memcpy(json, strStream.GetBuffer(), jsonLength + 1);
+        Document doc;
+        struct timeval start, end;
+        gettimeofday(&start, 0);
+        InSituStringStream sstream(json, jsonLength);
+        JsonReader reader(sstream);
+        if (handler)
+            reader >> *handler;
+        else
+            reader >> doc;
+        gettimeofday(&end, 0);
+        parseTime += MilliSeconds(start, end);
+        if (reader.HasParseError())
+        {
+            cout << "Parse error: " << reader.GetParseErrorStr() << endl;
+            exit(1);
+        }
+    }
+    free(json);
+
+    double msParse = parseTime / iterations;
+    cout << setw(24) << left << name << fixed << setprecision(2) << msParse << " ms, " << (jsonLength / 1000.0) / msParse << " MB/s" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 50000;
+    int iterations = (argc > 2) ? atoi(argv[2]) : 10;
+
+    // generate a bulk insert request with a mix of strings and numbers
+    WriteStringStream strStream;
+    {
+        Value request;
+        request["jsonrpc"] = "2.0";
+        request["method"] = "insert";
+        request["id"] = 1;
+        Value& rows = request["params"];
+        rows.SetArray();
+        for (size_t i=0; i<count; i++)
+        {
+            Value row;
+            row["id"] = static_cast<int>(i);
+            row["name"] = "sensor reading with a description";
+            row["unit"] = "kPa";
+            row["value"] = i * 0.125;
+            row["valid"] = ((i % 3) != 0);
+            rows.PushBack(row);
+        }
+        JsonWriter writer(strStream);
+        writer << request;
+    }
+    cout << "Bulk insert of " << count << " rows, " << strStream.Length() << " bytes of json" << endl;
+
+    CountHandler countHandler;
+    TimeParse("JsonReader events:", strStream, &countHandler, iterations);
+    TimeParse("JsonReader document:", strStream, 0, iterations);
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+
+#include "anyrpc/anyrpc.h"
+#include "anyrpc/internal/time.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace anyrpc;
+
+// Compare the memory and parse speed of large arrays of doubles.
+// Build with and without BUILD_WITH_PACKED_VALUE to compare the Value layouts.
+// The array is also parsed with Document::ConvertTypedArrays to compare the typed array.
+
+static double MilliSeconds(struct timeval& start, struct timeval& end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+//! Average time to parse the json, with the memory used by the elements of the array
+static double TimeParse(WriteStringStream& strStream, int iterations, bool convertTypedArrays, size_t& arrayBytes)
+{
+    size_t jsonLength = strStream.Length();
+    char* json = static_cast<char*>(malloc(jsonLength + 1));
+    double parseTime = 0;
+    arrayBytes = 0;
+    for (int n=0; n<iterations; n++)
+    {
+        memcpy(json, strStream.GetBuffer(), jsonLength + 1);
+        Document doc;
+        doc.ConvertTypedArrays(convertTypedArrays);
+        struct timeval start, end;
+        gettimeofday(&start, 0);
+        InSituStringStream sstream(json, jsonLength);
+        JsonReader reader(sstream);
+        reader >> doc;
+        gettimeofday(&end, 0);
+        parseTime += MilliSeconds(start, end);
+        if (reader.HasParseError())
+        {
+            cout << "Parse error: " << reader.GetParseErrorStr() << endl;
+            exit(1);
+        }
+        Value& array = doc.GetValue();
+        if (array.IsTypedArray())
+            arrayBytes = array.Capacity() * Value::TypedArrayElementSize(array.GetTypedArrayType());
+        else
+            arrayBytes = array.Capacity() * sizeof(Value);
+    }
+    free(json);
+    return parseTime / iterations;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = (argc > 1) ? atol(argv[1]) : 1000000;
+    int iterations = (argc > 2) ? atoi(argv[2]) : 10;
+
+#if defined(ANYRPC_PACKED_VALUE)
+    cout << "Layout: packed" << endl;
+#else
+    cout << "Layout: standard" << endl;
+#endif
+    cout << "sizeof(Value): " << sizeof(Value) << " bytes" << endl;
+
+    // generate the telemetry style array of doubles, none of them whole numbers that would be parsed as integers
+    WriteStringStream strStream;
+    {
+        Value array;
+        array.SetArray();
+        for (size_t i=0; i<count; i++)
+        {
+            Value element(i * 0.001 + 0.0005);
+            array.PushBack(element);
+        }
+        JsonWriter writer(strStream);
+        writer << array;
+    }
+    size_t jsonLength = strStream.Length();
+    cout << "Array of " << count << " doubles, " << jsonLength << " bytes of json" << endl;
+
+    // time the building of an array
+    struct timeval start, end;
+    gettimeofday(&start, 0);
+    for (int n=0; n<iterations; n++)
+    {
+        Value array;
+        array.SetArray();
+        for (size_t i=0; i<count; i++)
+        {
+            Value element(i * 0.001);
+            array.PushBack(element);
+        }
+    }
+    gettimeofday(&end, 0);
+    cout << "Build: " << fixed << setprecision(2) << MilliSeconds(start, end) / iterations << " ms" << endl;
+
+    // time the parsing and measure the memory used by the elements, then again packing the typed array
+    for (int typed=0; typed<2; typed++)
+    {
+        size_t arrayBytes;
+        double msParse = TimeParse(strStream, iterations, (typed != 0), arrayBytes);
+        cout << (typed ? "Parse typed: " : "Parse: ") << fixed << setprecision(2) << msParse << " ms, " << (jsonLength / 1000.0) / msParse << " MB/s" << endl;
+        cout << "Element memory: " << arrayBytes << " bytes, " << static_cast<double>(arrayBytes) / count << " bytes per double, "
+             << setprecision(0) << 100.0 * (arrayBytes - count * sizeof(double)) / (count * sizeof(double)) << "% overhead" << endl;
+    }
+
+    return 0;
+}
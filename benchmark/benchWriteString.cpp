@@ -0,0 +1,99 @@
+
+#include "anyrpc/anyrpc.h"
+#include "anyrpc/internal/time.h"
+#include "anyrpc/internal/strscan.h"
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+using namespace anyrpc;
+
+// Measure the string output of the JsonWriter and XmlWriter for representative strings.
+// Responses are mostly long log and text fields that don't need any escapes, so the
+// time is dominated by finding the characters that do.
+
+static double MilliSeconds(struct timeval& start, struct timeval& end)
+{
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+enum WriterType { JsonUtf8, JsonAscii, Xml };
+
+static void TimeWrite(const char* name, WriterType type, const vector<string>& strings, int iterations)
+{
+    WriteStringStream os(1024*1024);
+    size_t inputLength = 0;
+    for (size_t i=0; i<strings.size(); i++)
+        inputLength += strings[i].length();
+
+    struct timeval start, end;
+    gettimeofday(&start, 0);
+    for (int n=0; n<iterations; n++)
+    {
+        os.Clear();
+        for (size_t i=0; i<strings.size(); i++)
+        {
+            const string& str = strings[i];
+            if (type == Xml)
+            {
+                XmlWriter writer(os);
+                writer.String(str.c_str(), str.length());
+            }
+            else
+            {
+                JsonWriter writer(os, (type == JsonAscii) ? ASCII : UTF8);
+                writer.String(str.c_str(), str.length());
+            }
+        }
+    }
+    gettimeofday(&end, 0);
+
+    double ms = MilliSeconds(start, end) / iterations;
+    cout << "  " << setw(12) << left << name << fixed << setprecision(3) << ms << " ms, "
+         << setprecision(0) << (inputLength / 1000.0) / ms << " MB/s" << endl;
+}
+
+static void TimeStrings(const char* description, const vector<string>& strings, int iterations)
+{
+    cout << description << endl;
+    TimeWrite("json utf8:", JsonUtf8, strings, iterations);
+    TimeWrite("json ascii:", JsonAscii, strings, iterations);
+    TimeWrite("xml:", Xml, strings, iterations);
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+
+    cout << "String scan method: " << internal::ScanStringMethod() << endl;
+
+    const char* logLine = "2015-10-19 12:34:56.789 INFO  [server.worker.3] Processed request id=1234567 "
+                          "method=getSensorReadings client=10.1.2.3:51234 elapsed=1.234ms status=OK";
+
+    vector<string> keys;
+    for (int i=0; i<10000; i++)
+        keys.push_back((i % 2) ? "name" : "timestamp");
+    TimeStrings("Short keys (4-9 bytes)", keys, iterations);
+
+    vector<string> logLines(2000, logLine);
+    TimeStrings("Log lines (160 bytes, no escapes)", logLines, iterations);
+
+    // text fields with a line break every few lines of the log
+    string text;
+    for (int i=0; i<32; i++)
+    {
+        text += logLine;
+        if ((i % 4) == 3)
+            text += '\n';
+    }
+    vector<string> texts(100, text);
+    TimeStrings("Text fields (5 KB, a newline every 640 bytes)", texts, iterations);
+
+    string utf8;
+    for (int i=0; i<100; i++)
+        utf8 += "Temp\xc3\xa9rature \xe2\x84\x83 ";
+    vector<string> utf8Texts(200, utf8);
+    TimeStrings("Utf8 text (1.7 KB, non-ascii every 10 bytes)", utf8Texts, iterations);
+
+    return 0;
+}
@@ -26,18 +26,27 @@
 #include "api.h"
 #include "logger.h"
 #include "error.h"
+#include "arena.h"
+#include "keytable.h"
 #include "value.h"
+#include "sharedvalue.h"
 #include "stream.h"
 #include "handler.h"
+#include "structbinding.h"
 #include "document.h"
 #include "reader.h"
+#include "paramschema.h"
 #include "method.h"
 #include "socket.h"
 #include "connection.h"
 #include "server.h"
+#include "cache.h"
 #include "client.h"
+#include "balancedclient.h"
 #include "json/jsonwriter.h"
 #include "json/jsonreader.h"
+#include "json/jsonpushparser.h"
+#include "json/jsonlazyvalue.h"
 #include "json/jsonserver.h"
 #include "json/jsonclient.h"
 #include "messagepack/messagepackwriter.h"
@@ -40,6 +40,7 @@
 #include <cassert>
 #include <time.h>
 #include <iterator>
+#include <utility>
 #include <cmath>
 #include <cctype>
 
@@ -179,6 +180,61 @@ typedef int socklen_t;
 # endif
 #endif // ANYRPC_64BIT
 
+///////////////////////////////////////////////////////////////////////////////
+// ANYRPC_PACKED_VALUE
+
+//! Whether Value uses the packed 16-byte layout
+/*!
+    The packed layout only applies to 64-bit architectures where it stores the
+    map and array pointers in 48 bits.  32-bit architectures already use 16 bytes.
+*/
+#if defined(ANYRPC_PACKED_VALUE) && !ANYRPC_64BIT
+# undef ANYRPC_PACKED_VALUE
+#endif // ANYRPC_PACKED_VALUE
+
+///////////////////////////////////////////////////////////////////////////////
+// ANYRPC_HAS_RVALUE_REFS
+
+//! Whether the compiler supports rvalue references for move semantics
+#if !defined(ANYRPC_HAS_RVALUE_REFS)
+# if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1900))
+#  define ANYRPC_HAS_RVALUE_REFS 1
+# else
+#  define ANYRPC_HAS_RVALUE_REFS 0
+# endif
+#endif // ANYRPC_HAS_RVALUE_REFS
+
+///////////////////////////////////////////////////////////////////////////////
+// ANYRPC_HAS_VARIADIC_TEMPLATES
+
+//! Whether the compiler supports variadic templates for the typed method functions
+#if !defined(ANYRPC_HAS_VARIADIC_TEMPLATES)
+# if (__cplusplus >= 201103L) || (defined(_MSC_VER) && (_MSC_VER >= 1800))
+#  define ANYRPC_HAS_VARIADIC_TEMPLATES 1
+#  include <type_traits>
+# else
+#  define ANYRPC_HAS_VARIADIC_TEMPLATES 0
+# endif
+#endif // ANYRPC_HAS_VARIADIC_TEMPLATES
+
+///////////////////////////////////////////////////////////////////////////////
+// ANYRPC_THREAD_LOCAL
+
+//! Storage class for data that is specific to each thread.
+/*!
+    Only plain data types can be used.  The compiler specific keywords are used
+    since thread_local is not available with all of the supported compilers.
+*/
+#if !defined(ANYRPC_THREAD_LOCAL)
+# if !defined(ANYRPC_THREADING)
+#  define ANYRPC_THREAD_LOCAL
+# elif defined(_MSC_VER)
+#  define ANYRPC_THREAD_LOCAL __declspec(thread)
+# else
+#  define ANYRPC_THREAD_LOCAL __thread
+# endif
+#endif // ANYRPC_THREAD_LOCAL
+
 ///////////////////////////////////////////////////////////////////////////////
 // ANYRPC_UINT64_C2
 
@@ -196,6 +252,11 @@ typedef int socklen_t;
 #define ANYRPC_DATETIME_STRING "AnyRpcDateTime"
 #define ANYRPC_BASE64_STRING "AnyRpcBase64"
 
+//! HTTP header field with the number of milliseconds the client will wait for the response
+#define ANYRPC_TIMEOUT_HEADER "X-AnyRpc-Timeout"
+//! Timeout header field as it is matched after the received header keys are converted to lowercase
+#define ANYRPC_TIMEOUT_HEADER_KEY "x-anyrpc-timeout"
+
 namespace anyrpc
 {
 //! Encoding type of data.  This is currently not widely supported in the library since UTF-8 most commonly used
@@ -0,0 +1,111 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_ARENA_H_
+#define ANYRPC_ARENA_H_
+
+namespace anyrpc
+{
+
+//! Monotonic allocator for the data of Value trees
+/*!
+ *  Allocations are taken sequentially from large blocks and are never freed
+ *  individually.  All of the space is recovered at once with Reset, so the
+ *  arena is well suited to data that has the lifetime of a single request.
+ *
+ *  Value uses the arena that is current for the thread when it allocates the
+ *  space for maps, arrays, and copied strings.  The destructor of a Value
+ *  doesn't free this space, so any Value built while an arena is current must
+ *  be destroyed before the arena is Reset.
+ *
+ *  When Reset is called after more than one block was needed, the blocks are
+ *  replaced with a single block large enough for all of the data so later
+ *  requests of the same size only use one block.
+ */
+class ANYRPC_API MemoryArena
+{
+public:
+    MemoryArena(std::size_t blockSize = DefaultBlockSize);
+    ~MemoryArena();
+
+    //! Allocate space from the arena
+    void* Malloc(std::size_t size);
+    //! Resize an allocation.  The last allocation is extended in place when there is space.
+    void* Realloc(void* ptr, std::size_t oldSize, std::size_t newSize);
+    //! Release all of the allocations at once
+    void Reset();
+
+    //! Number of bytes allocated since the last Reset
+    std::size_t GetUsed() const { return used_; }
+    //! Total number of bytes in the blocks
+    std::size_t GetCapacity() const { return capacity_; }
+
+    //! Get the arena used by Value on this thread, 0 for none
+    static MemoryArena* GetCurrent();
+    //! Set the arena used by Value on this thread, 0 to use malloc/free
+    static void SetCurrent(MemoryArena* arena);
+
+    static const std::size_t DefaultBlockSize = 64*1024;
+
+private:
+    log_define("AnyRPC.MemoryArena");
+
+    MemoryArena(const MemoryArena&);
+    MemoryArena& operator=(const MemoryArena&);
+
+    struct Block
+    {
+        Block* next;            //!< Previously filled block
+        std::size_t size;       //!< Number of bytes of data following the header
+    };
+
+    //! Add a block that has space for at least size bytes
+    void AddBlock(std::size_t size);
+    //! Round the size up to keep allocations aligned
+    static std::size_t Align(std::size_t size) { return (size + Alignment - 1) & ~(Alignment - 1); }
+
+    static const std::size_t Alignment = 8;
+
+    Block* head_;               //!< Block currently used for allocations
+    char* ptr_;                 //!< Next free byte in the current block
+    char* end_;                 //!< End of the current block
+    char* last_;                //!< Start of the last allocation - can be extended in place
+    std::size_t blockSize_;     //!< Minimum size of a new block
+    std::size_t used_;          //!< Bytes allocated since the last Reset
+    std::size_t capacity_;      //!< Bytes in all of the blocks
+};
+
+//! Make an arena current for the lifetime of the scope and then restore the previous one
+class ANYRPC_API ArenaScope
+{
+public:
+    ArenaScope(MemoryArena* arena) : previous_(MemoryArena::GetCurrent()) { MemoryArena::SetCurrent(arena); }
+    ~ArenaScope() { MemoryArena::SetCurrent(previous_); }
+
+private:
+    ArenaScope(const ArenaScope&);
+    ArenaScope& operator=(const ArenaScope&);
+
+    MemoryArena* previous_;
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_ARENA_H_
@@ -0,0 +1,155 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_BALANCEDCLIENT_H_
+#define ANYRPC_BALANCEDCLIENT_H_
+
+#if defined(ANYRPC_THREADING)
+# if defined(__MINGW32__)
+#  include <mutex>
+#  include "internal/mingw.mutex.h"
+# else
+#  include <mutex>
+# endif //defined(__MINGW32__)
+#endif //defined(ANYRPC_THREADING)
+
+namespace anyrpc
+{
+
+//! Policy used to select the endpoint for the next call
+enum BalancePolicy
+{
+    BalanceRoundRobin,                  //!< Step through the endpoints in order
+    BalanceLeastOutstanding,            //!< Endpoint with the fewest calls in progress
+    BalancePowerOfTwoChoices,           //!< Lower latency of two randomly chosen endpoints
+};
+
+//! Client that distributes calls across a set of server endpoints
+/*!
+ *  Each endpoint keeps a pool of idle clients so that the connections can be
+ *  reused between calls.  A client is taken from the pool for the duration of
+ *  a call so the BalancedClient can be shared by multiple threads when threading
+ *  is enabled.
+ *
+ *  An endpoint is ejected from the selection after a number of consecutive
+ *  calls that ended with ProcessResponseErrorClose.  It is considered again once
+ *  the ejection time has expired.  If all endpoints are ejected, then the one
+ *  whose ejection expires first is used rather than failing the call.
+ *
+ *  Hedged requests can be enabled to reduce the tail latency of Call.  If the first
+ *  endpoint hasn't responded within a percentile of the recent call times, the
+ *  same request is sent to a second endpoint and the first response is used.  The
+ *  slower connection is closed so its response is discarded.  Only use hedging
+ *  for methods that are safe to execute twice.
+ *
+ *  A BalancedClient for a particular protocol will provide the CreateClient function.
+ *  The endpoint selection can be changed by overriding SelectEndpoint.
+ */
+class ANYRPC_API BalancedClient
+{
+public:
+    BalancedClient();
+    virtual ~BalancedClient();
+
+    //! Add a server endpoint to the set
+    void AddEndpoint(const char* host, int port);
+    //! Get the number of endpoints in the set
+    std::size_t GetEndpointCount() const { return endpoints_.size(); }
+    //! Set the policy used to select the endpoint for each call
+    void SetPolicy(BalancePolicy policy) { policy_ = policy; }
+    //! Set timeout for each client to respond to a request
+    void SetTimeout(unsigned msTime) { timeout_ = msTime; }
+    //! Set the number of consecutive failures to eject an endpoint and how long it stays ejected
+    void SetEjection(unsigned consecutiveErrors, unsigned msTime) { ejectErrors_ = consecutiveErrors; ejectTime_ = msTime; }
+    //! Set the maximum number of idle clients kept for each endpoint
+    void SetMaxIdleClients(std::size_t maxIdle) { maxIdleClients_ = maxIdle; }
+    //! Enable hedged calls that are sent after the given percentile of the recent call times
+    void SetHedging(bool enable, unsigned percentile=95) { hedging_ = enable; hedgePercentile_ = std::min(percentile, 100u); }
+    //! Close all of the idle connections
+    void Close();
+
+    virtual bool Call(const char* method, Value& params, Value& result);
+    virtual bool Notify(const char* method, Value& params, Value& result);
+
+protected:
+    log_define("AnyRPC.BalancedClient");
+
+    //! Per endpoint information for the selection and the pool of idle clients
+    struct Endpoint
+    {
+        Endpoint(const char* host, int port) :
+            host_(host), port_(port), outstanding_(0), latency_(0), consecutiveErrors_(0) { ejectUntil_.tv_sec = 0; ejectUntil_.tv_usec = 0; }
+
+        std::string host_;                  //!< Connection host name/IP address
+        int port_;                          //!< Connection port
+        unsigned outstanding_;              //!< Number of calls in progress
+        int64_t latency_;                   //!< Moving average of the call time in microseconds
+        unsigned consecutiveErrors_;        //!< Number of calls in a row that closed the connection
+        struct timeval ejectUntil_;         //!< Time when an ejected endpoint can be used again
+        std::vector<Client*> idle_;         //!< Clients available for the next call
+    };
+
+    static const std::size_t NoEndpoint = static_cast<std::size_t>(-1);  //!< Index that doesn't match any endpoint
+    static const std::size_t HedgeSamples = 128;                          //!< Number of call times kept for the hedge delay
+    static const std::size_t HedgeMinSamples = 16;                        //!< Number of call times required before hedging
+
+    //! Create a client for the protocol connected to the given endpoint
+    virtual Client* CreateClient(const char* host, int port) = 0;
+    //! Select the index of the endpoint for the next call from the available list
+    virtual std::size_t SelectEndpoint(std::vector<std::size_t>& available);
+
+    //! Send the request to a second endpoint if the first doesn't respond in time
+    bool HedgedCall(const char* method, Value& params, Value& result, int hedgeDelay);
+    //! Get the milliseconds to wait before sending a hedged request, negative if not enough history
+    int GetHedgeDelay();
+
+    //! Take a client from the pool of the selected endpoint, skipping the excluded endpoint
+    Client* Acquire(std::size_t& index, std::size_t exclude=NoEndpoint);
+    //! Return the client to the pool and update the endpoint statistics if the call completed
+    void Release(std::size_t index, Client* client, struct timeval& startTime, bool completed=true);
+    //! Produce the next pseudo-random number for the selection
+    unsigned NextRandom();
+
+    std::vector<Endpoint> endpoints_;       //!< Set of server endpoints
+    BalancePolicy policy_;                  //!< Policy used to select the endpoint
+    std::size_t nextIndex_;                 //!< Next position for round robin selection
+    unsigned timeout_;                      //!< Timeout value in milliseconds
+    unsigned ejectErrors_;                  //!< Number of consecutive errors to eject an endpoint
+    unsigned ejectTime_;                    //!< Milliseconds that an endpoint stays ejected
+    std::size_t maxIdleClients_;            //!< Maximum number of idle clients for an endpoint
+    unsigned randomState_;                  //!< State for the pseudo-random selection
+    bool hedging_;                          //!< Send hedged requests for Call
+    unsigned hedgePercentile_;              //!< Percentile of the call times to wait before hedging
+    std::vector<int64_t> callTimes_;        //!< Recent successful call times in microseconds
+    std::size_t nextCallTime_;              //!< Position to store the next call time
+
+#if defined(ANYRPC_THREADING)
+    std::mutex mutex_;                      //!< Access mutex for the endpoints
+#endif // defined(ANYRPC_THREADING)
+
+private:
+    // Prohibit copy constructor & assignment operator.
+    BalancedClient(const BalancedClient&);
+    BalancedClient& operator=(const BalancedClient&);
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_BALANCEDCLIENT_H_
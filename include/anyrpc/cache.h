@@ -0,0 +1,118 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_CACHE_H_
+#define ANYRPC_CACHE_H_
+
+#if defined(ANYRPC_THREADING)
+# if defined(__MINGW32__)
+#  include <mutex>
+#  include "internal/mingw.mutex.h"
+#  include "internal/mingw.condition_variable.h"
+# else
+#  include <condition_variable>
+#  include <mutex>
+# endif //defined(__MINGW32__)
+#endif //defined(ANYRPC_THREADING)
+
+namespace anyrpc
+{
+
+//! Cache of the results from idempotent methods
+/*!
+ *  Only the methods that are added to the cache are stored.  The results are
+ *  kept for the time specified when the method was added.  When the capacity is
+ *  reached, the least recently used result is removed.
+ *
+ *  A result is found using the endpoint, the method name, and the params.  The
+ *  params are converted to a canonical form where the map members are sorted
+ *  so the order that members were added doesn't matter.
+ *
+ *  The cache can be shared by multiple clients.  When threading is enabled and
+ *  several threads make the same call at the same time, only the first thread
+ *  sends the request and the others wait for the result.
+ *
+ *  Only successful results are cached.
+ */
+class ANYRPC_API ResponseCache
+{
+public:
+    ResponseCache(std::size_t capacity=1000) : capacity_(capacity) {}
+
+    //! Cache the results of the method for the given number of milliseconds
+    void AddMethod(std::string const& method, unsigned msTime);
+    //! Stop caching the results of the method and remove the current results
+    void RemoveMethod(std::string const& method);
+    //! Set the maximum number of results to keep
+    void SetCapacity(std::size_t capacity);
+    //! Get the number of results in the cache
+    std::size_t GetSize();
+    //! Remove all of the results
+    void Clear();
+
+    //! Look for the result of the call.
+    /*!
+     *  Returns true with the result if it is in the cache.  Otherwise the cacheKey is set
+     *  if the method is cached and the caller must follow with Complete.
+     */
+    bool Lookup(std::string const& host, int port, const char* method, Value& params, Value& result, std::string& cacheKey);
+    //! Provide the result for the call after Lookup returned false with a cacheKey
+    void Complete(std::string const& cacheKey, Value& result, bool success);
+
+protected:
+    log_define("AnyRPC.ResponseCache");
+
+    //! Cached result of a call
+    struct Entry
+    {
+        Entry() : pending_(true) { expires_.tv_sec = 0; expires_.tv_usec = 0; }
+
+        Value result_;                                  //!< Copy of the call result
+        struct timeval expires_;                        //!< Time when the result is no longer valid
+        bool pending_;                                  //!< A call for the result is in progress
+        std::list<std::string>::iterator lruPosition_;  //!< Position in the least recently used list
+    };
+
+    //! Generate the canonical form of the value for the cache key
+    static void AppendCanonical(Value& value, std::string& key);
+    //! Remove the entry from the cache
+    void Erase(std::map<std::string, Entry>::iterator it);
+    //! Remove least recently used results while over capacity
+    void Trim();
+
+    std::map<std::string, unsigned> methods_;       //!< Methods that are cached with the time to keep the results
+    std::map<std::string, Entry> entries_;          //!< Results using the cache key
+    std::list<std::string> lru_;                    //!< Keys of the completed results from the most recently used
+    std::size_t capacity_;                          //!< Maximum number of results
+
+#if defined(ANYRPC_THREADING)
+    std::mutex mutex_;                              //!< Access mutex for the cache
+    std::condition_variable pendingDone_;           //!< Signal waiting threads that a pending call completed
+#endif // defined(ANYRPC_THREADING)
+
+private:
+    // Prohibit copy constructor & assignment operator.
+    ResponseCache(const ResponseCache&);
+    ResponseCache& operator=(const ResponseCache&);
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_CACHE_H_
@@ -30,6 +30,8 @@
 namespace anyrpc
 {
 
+class ResponseCache;
+
 //! Return results from processing an RPC response
 enum ProcessResponseEnum
 {
@@ -38,6 +40,87 @@ enum ProcessResponseEnum
     ProcessResponseErrorClose,          //!< Error response, close connection
 };
 
+//! Collection of calls that are sent to the server in a single transaction
+/*!
+ *  Calls are added with Add and the results are available in the same order after
+ *  Client::BatchCall.  GetSuccess indicates whether the result is the return value
+ *  of the method or a fault with code and message members.
+ *
+ *  The params are copied when added so the same Value can be reused for each call.
+ *  The results are copied from the response so they stay valid after later calls.
+ */
+class ANYRPC_API Batch
+{
+public:
+    Batch() { Clear(); }
+
+    //! Add a call to the batch
+    void Add(const char* method, Value& params);
+    //! Remove all of the calls and results
+    void Clear();
+
+    //! Get the number of calls in the batch
+    std::size_t GetSize() const { return methods_.size(); }
+    //! Get the method name of a call
+    const char* GetMethod(std::size_t index) const { return methods_[index].c_str(); }
+    //! Get the parameters of a call
+    Value& GetParams(std::size_t index) { return params_[index]; }
+    //! Get the result of a call
+    Value& GetResult(std::size_t index) { return results_[index]; }
+    //! Indicate whether the call was successful
+    bool GetSuccess(std::size_t index) const { return success_[index]; }
+
+    //! Set the result of a call. The result value is moved into the batch.
+    void SetResult(std::size_t index, Value& result, bool success);
+    //! Set the same result for all of the calls, generally after a transport failure
+    void SetAllResults(Value& result, bool success);
+
+private:
+    std::vector<std::string> methods_;      //!< Method name of each call
+    Value params_;                          //!< Array with the parameters of each call
+    Value results_;                         //!< Array with the result of each call
+    std::vector<bool> success_;             //!< Success indication of each call
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+//! Owner of the response data that is referenced by a result
+/*!
+ *  The responses are parsed in place so the strings and binary data of a result
+ *  reference the receive buffer.  Normally this buffer belongs to the Client and
+ *  is reused by the next call.  When a ResponseBuffer is given to Call or
+ *  GetPostResult, the ownership of the buffer is passed to it instead so the
+ *  result stays valid until the ResponseBuffer is released or destroyed.
+ *
+ *  Large responses are passed without copying. A response that fits in the
+ *  Client fixed buffer is copied since that buffer may hold the start of the next response.
+ */
+class ANYRPC_API ResponseBuffer
+{
+public:
+    ResponseBuffer() : data_(0), length_(0) {}
+    ~ResponseBuffer() { Release(); }
+
+    //! Free the response data. Any result that references the data is no longer valid.
+    void Release() { free(data_); data_ = 0; length_ = 0; }
+    //! Take ownership of malloc allocated data
+    void Take(char* data, std::size_t length) { Release(); data_ = data; length_ = length; }
+
+    const char* GetData() const { return data_; }
+    std::size_t GetLength() const { return length_; }
+    bool IsEmpty() const { return (data_ == 0); }
+
+private:
+    // Prohibit copy constructor & assignment operator.
+    ResponseBuffer(const ResponseBuffer&);
+    ResponseBuffer& operator=(const ResponseBuffer&);
+
+    char* data_;                            //!< Response data allocated with malloc
+    std::size_t length_;                    //!< Length of the response data
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 //! Process the client information into a request using a specific protocol
 /*!
  *  This is the base class for creating requests and processing the responses
@@ -60,6 +143,11 @@ public:
     virtual bool GenerateRequest(const char* method, Value& params, Stream& os, unsigned& requestId, bool notification) = 0;
     //! Process the RPC response string.  The result will have any values returned.
     virtual ProcessResponseEnum ProcessResponse(char* response, std::size_t length, Value& result, unsigned requestId, bool notification) = 0;
+    //! Generate a single request with all of the calls in the batch.  Return false if the protocol doesn't support batches.
+    virtual bool GenerateBatchRequest(Batch& /* batch */, Stream& /* os */, std::vector<unsigned>& /* requestIds */) { return false; }
+    //! Process the response to a batch request and place each result in the batch
+    virtual ProcessResponseEnum ProcessBatchResponse(char* /* response */, std::size_t /* length */, Batch& /* batch */, std::vector<unsigned>& /* requestIds */)
+        { return ProcessResponseErrorClose; }
     //! Generate a value result value with the code and message
     virtual void GenerateFaultResult(int errorCode, std::string const& msg, Value& result);
 
@@ -86,6 +174,9 @@ private:
  *  Multiple asynchronous RPC call can be made before getting the result since
  *  a list of the expected sequence is kept.
  *
+ *  BatchCall sends a set of calls in a single request if the protocol supports it,
+ *  otherwise the calls are pipelined with Post and GetPostResult.
+ *
  *  Notify calls are also available with the need for a response
  *  determined by the transport protocol.  A notification may also have
  *  a result from a delivery or protocol failure.
@@ -96,6 +187,11 @@ private:
  *
  *  The header and request are stored in a segmented buffer so that data copying is not required
  *  from realloc calls as a single buffer is expanded.
+ *
+ *  Calls to idempotent methods can skip the server when a ResponseCache is set.
+ *
+ *  The result references the response data so it is only valid until the next transaction
+ *  unless a ResponseBuffer is used to take ownership of the data.
  */
 class ANYRPC_API Client
 {
@@ -108,6 +204,8 @@ public:
     virtual void SetServer(const char* host, int port) { host_ = host; port_ = port; Close(); }
     //! Set timeout for the client to respond to a request
     virtual void SetTimeout(unsigned msTime) { timeout_ = msTime; }
+    //! Set the cache used for the results of idempotent methods, null to disable
+    void SetCache(ResponseCache* cache) { cache_ = cache; }
     //! Close the connection
     virtual void Close() { log_info("close socket, fd=" << socket_.GetFileDescriptor()); socket_.Close(); }
 
@@ -115,6 +213,19 @@ public:
     virtual bool Post(const char* method, Value& params, Value& result);
     virtual bool GetPostResult(Value& result);
     virtual bool Notify(const char* method, Value& params, Value& result);
+    //! Call where the result references the response data owned by the buffer instead of the client
+    bool Call(const char* method, Value& params, Value& result, ResponseBuffer& buffer);
+    //! GetPostResult where the result references the response data owned by the buffer instead of the client
+    bool GetPostResult(Value& result, ResponseBuffer& buffer);
+    //! Execute all of the calls in the batch.  Return true if all of the calls were successful.
+    virtual bool BatchCall(Batch& batch);
+
+    //! Get the processing result of the last Call, Post, GetPostResult, or Notify
+    ProcessResponseEnum GetLastResponse() const { return lastResponse_; }
+    //! Get the socket file descriptor so that multiple clients can wait for a response together
+    SOCKET GetFileDescriptor() { return socket_.GetFileDescriptor(); }
+    //! Abandon any posted requests. The connection is closed so a late response is discarded.
+    void CancelPending() { Reset(); }
 
 protected:
     log_define("AnyRPC.Client");
@@ -131,6 +242,8 @@ protected:
     virtual void PreserveReceiveBuffer();
     //! Return the amount of time left for the call
     unsigned GetTimeLeft();
+    //! Send the call to the server and wait for the result
+    virtual bool CallServer(const char* method, Value& params, Value& result);
     //! Connect to the server
     virtual bool Connect(Value& result);
     //! Generate the RPC request into the request_ stream based on the method and params
@@ -147,6 +260,10 @@ protected:
     virtual bool ReadResponse(Value& result);
     //! Process the actual RPC response message
     virtual ProcessResponseEnum ProcessResponse(Value& result, bool notification=false);
+    //! Get the response data to parse, passing the ownership to the response buffer if requested
+    char* GetResponseData();
+    //! Send the batch calls as separate requests without waiting for each response
+    virtual bool PipelineCall(Batch& batch);
     //! Indicate whether this protocol is expecting a response from a notification
     virtual bool TransportHasNotifyResponse() = 0;
 
@@ -175,6 +292,9 @@ protected:
     unsigned timeout_;                      //!< Timeout value in milliseconds
 
     bool responseProcessed_;                //!< The response has been process and buffer needs to be reclaimed
+    ResponseBuffer* responseBuffer_;        //!< Buffer to take ownership of the response data, null to keep it
+    ResponseCache* cache_;                  //!< Cache for the results of idempotent methods, null if not used
+    ProcessResponseEnum lastResponse_;      //!< Processing result of the last transaction
 };
 
 ////////////////////////////////////////////////////////////////////////////////
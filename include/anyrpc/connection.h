@@ -38,6 +38,8 @@
 namespace anyrpc
 {
 
+class MemoryArena;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 //! Process an RPC request to produced an output in the Stream
@@ -52,6 +54,29 @@ typedef bool RpcHandler(MethodManager* manager, char* request, std::size_t lengt
 
 ////////////////////////////////////////////////////////////////////////////////
 
+//! Parse an RPC request while the data is still being received
+/*!
+ *  A parser is used for a request whose body doesn't fit in the connection buffer.
+ *  Each piece of the body is given to Parse as it is received from the socket so
+ *  the parsing overlaps the transfer.  After the whole body has been received,
+ *  Execute produces the response in the same way as the RpcHandler.
+ */
+class ANYRPC_API RpcRequestParser
+{
+public:
+    virtual ~RpcRequestParser() {}
+
+    //! Parse the next piece of the request
+    virtual void Parse(const char* data, std::size_t length) = 0;
+    //! Process the request to produce the response.  Return false if there is no response to send.
+    virtual bool Execute(MethodManager* manager, Stream &response) = 0;
+};
+
+//! Create a parser for a single request, 0 if the request should be given to the RpcHandler when it is complete
+typedef RpcRequestParser* RpcParserFactory(MethodManager* manager);
+
+////////////////////////////////////////////////////////////////////////////////
+
 //! Hold the information to match HTTP content-type field to an RpcHandler
 /*!
  *  The class treats the requestContentType as a regular expression to match
@@ -61,27 +86,33 @@ typedef bool RpcHandler(MethodManager* manager, char* request, std::size_t lengt
 class RpcContentHandler
 {
 public:
-    RpcContentHandler() : handler_(0), matchAnyContentType_(true) {}
-    RpcContentHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType) :
-        handler_(handler), requestContentType_(requestContentType), responseContentType_(responseContentType),
-        matchAnyContentType_(requestContentType==""){}
+    RpcContentHandler() : handler_(0), parserFactory_(0), matchAnyContentType_(true) {}
+    RpcContentHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType,
+                      RpcParserFactory* parserFactory=0) :
+        handler_(handler), parserFactory_(parserFactory), requestContentType_(requestContentType),
+        responseContentType_(responseContentType), matchAnyContentType_(requestContentType==""){}
 
     //! Perform processing on the request using this handler
     bool HandleRequest(MethodManager* manager, char* request, std::size_t length, Stream &response)
         { anyrpc_assert(handler_ != 0, AnyRpcErrorHandlerNotDefined, "The RPC handler was not defined");
           return handler_(manager,request,length,response); }
+    //! Create a parser to process the request as it is received, 0 if the handler doesn't support it
+    RpcRequestParser* CreateParser(MethodManager* manager) { return (parserFactory_ != 0) ? parserFactory_(manager) : 0; }
     //! Determine if this handler is able to process the given contentType
     bool CanProcessContentType(std::string contentType);
     //! Get the content-type string to use with the response
     std::string& GetResponseContentType() { return responseContentType_; }
     //! Set the field if you need to use a default constructor;
-    void SetHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType)
-        { handler_ = handler; requestContentType_ = requestContentType; responseContentType_ = responseContentType; }
+    void SetHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType,
+                    RpcParserFactory* parserFactory=0)
+        { handler_ = handler; requestContentType_ = requestContentType; responseContentType_ = responseContentType;
+          parserFactory_ = parserFactory; }
 
 private:
     log_define("AnyRPC.RpcHandler");
 
     RpcHandler* handler_;               //!< Function pointer to RPC handler
+    RpcParserFactory* parserFactory_;   //!< Function pointer to create a parser for incremental processing, may be 0
 #if defined(ANYRPC_REGEX)
     std::regex requestContentType_;     //!< Regular express to match with the HTTP request content-type
 #else
@@ -144,6 +175,8 @@ public:
     virtual bool ForcedDisconnectAllowed() { return (bufferLength_ == 0); }
     //! Get the time when the last RPC transaction took place
     virtual time_t GetLastTransactionTime() { return lastTransactionTime_; }
+    //! Allocate the values for each request from an arena that is reset after the response is generated
+    void EnableArena(std::size_t blockSize);
 
 #if defined(ANYRPC_THREADING)
     void StartThread();
@@ -192,6 +225,9 @@ protected:
     WriteSegmentedStream response_;         //!< Data for the response body
     std::size_t resultBytesWritten_;        //!< Number of bytes of the body already written
 
+    MemoryArena* arena_;                    //!< Arena for the request values, 0 to use malloc
+    RpcRequestParser* parser_;              //!< Parser for the request while it is received, 0 if the request is parsed after
+
 #if defined(ANYRPC_THREADING)
 private:
     //! Function that is called when the thread is started
@@ -219,7 +255,7 @@ class ANYRPC_API HttpConnection : public Connection
 {
 public:
     HttpConnection(SOCKET fd, MethodManager* manager, RpcHandlerList& handlers) :
-        Connection(fd, manager), handlers_(handlers) {}
+        Connection(fd, manager), handlers_(handlers) { deadline_.tv_sec = 0; deadline_.tv_usec = 0; }
 
     virtual void Initialize(bool preserveBufferData=false);
 
@@ -231,9 +267,12 @@ private:
     void GeneratePOSTResponseHeader(std::size_t bodySize, std::string& contentType);
     void GenerateOPTIONSResponseHeader();
     void GenerateErrorResponseHeader(int code, std::string message);
+    RpcContentHandler* FindHandler();
+    bool DeadlineExpired();
 
     internal::HttpRequest httpRequestState_;    //!< Processing of the HTTP header
     RpcHandlerList& handlers_;                  //!< List of RPC handlers to check
+    struct timeval deadline_;                   //!< Time that the client stops waiting for the response, zero seconds if not specified
 };
 
 ////////////////////////////////////////////////////////////////////////////////
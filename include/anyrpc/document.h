@@ -40,12 +40,16 @@ namespace anyrpc
  *  following element contain the data.  For example, Json does not have a DateTime type
  *  so a two element array is used ["AnyRpcDateTime", "date"].  This data can
  *  be automatically converted while processing the data.
+ *
+ *  Arrays of at least MinTypedArraySize elements that are all the same number
+ *  type are packed into a typed array so that each element only uses the
+ *  space of the number.  Accessing an element expands the array again.
  */
 
 class ANYRPC_API Document : public Handler
 {
 public:
-    Document() : convertExtensions_(true) {}
+    Document() : convertExtensions_(true), convertTypedArrays_(false) {}
     virtual ~Document() {}
 
     //!@name Document Member Functions
@@ -89,6 +93,7 @@ public:
     virtual void StartArray();
     virtual void ArraySeparator();
     virtual void EndArray(std::size_t elementCount = 0);
+    virtual void TypedArray(TypedArrayType type, const void* data, std::size_t elementCount);
     //@}
 
     //! Get the value representing the document data
@@ -96,6 +101,14 @@ public:
 
     //! Set whether to automatically convert extensions to base types when parsing
     void ConvertExtensions(bool convert=true) { convertExtensions_ = convert; }
+    //! Set whether to pack arrays of numbers into typed arrays when parsing.  This is off by default.
+    /*!
+     *  Packing saves space for large arrays of numbers that are only traversed or accessed
+     *  through GetTypedArrayData, but accessing an element expands the array again.
+     */
+    void ConvertTypedArrays(bool convert=true) { convertTypedArrays_ = convert; }
+
+    static const std::size_t MinTypedArraySize = 16;   //!< Smallest array that is packed into a typed array
 
 protected:
     log_define("AnyRPC.Doc");
@@ -110,6 +123,7 @@ private:
 
     std::vector<Value*> stack_;     //!< Chain of values to the current position when parsing
     bool convertExtensions_;        //!< Whether to automatically convert extensions to base type
+    bool convertTypedArrays_;       //!< Whether to automatically pack arrays of numbers into typed arrays
 };
 
 } // namespace anyrpc
@@ -80,6 +80,13 @@ public:
     virtual void StartArray(std::size_t /* elementCount */) { return StartArray(); }
     virtual void ArraySeparator() {}
     virtual void EndArray(std::size_t elementCount = 0) = 0;
+    //! Process an array whose elements are all the same number type.
+    /*!
+     *  The default implementation generates the StartArray, number,
+     *  ArraySeparator, and EndArray calls of a generic array.  Handlers
+     *  that can process the contiguous data directly should override it.
+     */
+    virtual void TypedArray(TypedArrayType type, const void* data, std::size_t elementCount);
     //@}
 
 protected:
@@ -0,0 +1,54 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_DTOA_H_
+#define ANYRPC_DTOA_H_
+
+namespace anyrpc
+{
+namespace internal
+{
+
+static const std::size_t DoubleStringSize = 32;         //!< Buffer size for DoubleToString and FloatToString
+static const std::size_t FixedDoubleStringSize = 340;   //!< Buffer size for DoubleToFixedString
+
+//! Write the shortest string that reads back as the same double and return the end of the string
+/*!
+ *  The digits are generated with the Grisu2 algorithm, which always round trips and
+ *  produces the shortest digits for nearly all values. The layout follows printf's "%g"
+ *  with 17 digits of precision, so exponents are only used for very large and small numbers.
+ *  The string is not null terminated.
+ */
+char* DoubleToString(double value, char* buffer);
+
+//! Write the shortest string that reads back as the same float and return the end of the string
+char* FloatToString(float value, char* buffer);
+
+//! Write the shortest string that reads back as the same double without using an exponent
+/*!
+ *  The xmlrpc specification doesn't allow exponents, so the digits are padded with
+ *  zeroes to place the decimal point. Integral values don't have a decimal point.
+ */
+char* DoubleToFixedString(double value, char* buffer);
+
+} // namespace internal
+} // namespace anyrpc
+
+#endif // ANYRPC_DTOA_H_
@@ -90,12 +90,13 @@ private:
 class ANYRPC_API HttpRequest : public HttpHeader
 {
 public:
-    HttpRequest() {}
+    HttpRequest() : timeout_(-1) {}
     virtual void Initialize();
 
     std::string& GetMethod()        { return method_; }
     std::string& GetRequestUri()    { return requestUri_; }
     std::string& GetHost()          { return host_; }
+    int GetTimeout()                { return timeout_; }
 
 protected:
     virtual ResultEnum ProcessFirstLine(std::string &first, std::string &second, std::string &third);
@@ -106,6 +107,7 @@ private:
     std::string method_;            //!< Request method from the first line
     std::string requestUri_;        //!< Request URI from the first line
     std::string host_;              //!< Info from the host field
+    int timeout_;                   //!< Milliseconds the client will wait for the response, -1 if not specified
 };
 
 ////////////////////////////////////////////////////////////////////////////////
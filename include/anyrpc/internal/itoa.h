@@ -0,0 +1,46 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_ITOA_H_
+#define ANYRPC_ITOA_H_
+
+namespace anyrpc
+{
+namespace internal
+{
+
+static const std::size_t IntegerStringSize = 21;    //!< Buffer size for any of the integer conversions
+
+//!@name Integer to decimal string conversion
+/*!
+ *  The digits are written into the buffer two at a time from a table and
+ *  the end of the string is returned. The string is not null terminated.
+ */
+//@{
+char* U32ToString(uint32_t value, char* buffer);
+char* I32ToString(int32_t value, char* buffer);
+char* U64ToString(uint64_t value, char* buffer);
+char* I64ToString(int64_t value, char* buffer);
+//@}
+
+} // namespace internal
+} // namespace anyrpc
+
+#endif // ANYRPC_ITOA_H_
@@ -0,0 +1,55 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_STRSCAN_H_
+#define ANYRPC_STRSCAN_H_
+
+namespace anyrpc
+{
+namespace internal
+{
+//! Return the number of leading characters that can be copied directly from a Json string.
+/*!
+ *  The scan stops at a quotation mark, a backslash, or a control character.
+ *  It uses AVX2 or SSE2 when the processor supports them and processes one
+ *  character at a time otherwise.
+ */
+std::size_t ScanJsonString(const char* str, std::size_t length);
+
+//! Return the number of leading characters that can be written to a Json string with ASCII encoding.
+/*!
+ *  The scan also stops at characters outside of the ascii range.
+ */
+std::size_t ScanJsonStringAscii(const char* str, std::size_t length);
+
+//! Return the number of leading characters that can be written to Xml character data without escapes.
+/*!
+ *  The scan stops at the markup characters <, >, &, ', and " and at control
+ *  characters other than tab, newline, and carriage return.
+ */
+std::size_t ScanXmlString(const char* str, std::size_t length);
+
+//! Return the name of the implementation selected for the string scans
+const char* ScanStringMethod();
+
+} // namespace internal
+} // namespace anyrpc
+
+#endif // ANYRPC_STRSCAN_H_
@@ -91,6 +91,76 @@ inline void DoubleExtractPower(double &d, int &p)
     }
 }
 
+//! Multiply two 64 bit numbers, returning the low 64 bits and setting high to the upper 64 bits
+inline uint64_t FullMultiply(uint64_t a, uint64_t b, uint64_t& high)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    high = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+#else
+    const uint64_t M32 = 0xFFFFFFFF;
+    const uint64_t a0 = a & M32, a1 = a >> 32, b0 = b & M32, b1 = b >> 32;
+    const uint64_t x = a0 * b0, y = a0 * b1, z = a1 * b0, w = a1 * b1;
+    const uint64_t middle = (x >> 32) + (y & M32) + (z & M32);
+    high = w + (y >> 32) + (z >> 32) + (middle >> 32);
+    return (middle << 32) | (x & M32);
+#endif
+}
+
+//! Convert significand * 10^exp to the nearest double with the Eisel-Lemire algorithm
+/*!
+ *  The significand must hold all of the decimal digits of the number.
+ *  Returns false for the rare numbers that can't be decided with 128 bits of the
+ *  power of ten and for numbers out of range, which require the slower conversion.
+ */
+bool EiselLemire(uint64_t significand, int exp, double& d);
+
+//! Digits of a number that don't fit in the 64 bit significand
+/*!
+ *  The parsers keep the digits after the significand so that these numbers can be
+ *  converted exactly.  Only the first MaxDigits are stored since the digits after
+ *  them can only decide a tie, so for those it is only recorded whether any are not zero.
+ */
+class DecimalDigits
+{
+public:
+    DecimalDigits() { Clear(); }
+
+    void Clear() { count_ = 0; dropped_ = 0; nonZeroDropped_ = false; }
+    void Append(char c)
+    {
+        if (count_ < MaxDigits)
+            digits_[count_++] = c;
+        else
+        {
+            dropped_++;
+            nonZeroDropped_ = nonZeroDropped_ || (c != '0');
+        }
+    }
+
+    std::size_t GetCount() const { return count_; }
+    const char* GetDigits() const { return digits_; }
+    int GetDropped() const { return dropped_; }
+    bool NonZeroDropped() const { return nonZeroDropped_; }
+
+private:
+    enum { MaxDigits = 780 };           //!< More than the 767 significant digits of any halfway point between doubles
+
+    char digits_[MaxDigits];
+    std::size_t count_;
+    int dropped_;
+    bool nonZeroDropped_;
+};
+
+//! Convert (significand followed by the digits) * 10^exp to the nearest double
+/*!
+ *  When the leading 19 digits don't decide the result, it is compared exactly with
+ *  the halfway points between doubles using big integers, which is much slower.
+ *  Returns false if the number is too big for a double.
+ */
+bool StrtodExact(uint64_t significand, const DecimalDigits& digits, int exp, double& d);
+
 } // namespace internal
 } // namespace anyrpc
 
@@ -42,6 +42,22 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class ANYRPC_API JsonHttpBalancedClient : public BalancedClient
+{
+protected:
+    virtual Client* CreateClient(const char* host, int port) { return new JsonHttpClient(host, port); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ANYRPC_API JsonTcpBalancedClient : public BalancedClient
+{
+protected:
+    virtual Client* CreateClient(const char* host, int port) { return new JsonTcpClient(host, port); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 //! ClientHandler for Json format to generate the request and process the response
 class ANYRPC_API JsonClientHandler : public ClientHandler
 {
@@ -49,6 +65,12 @@ public:
     JsonClientHandler() {}
     virtual bool GenerateRequest(const char* method, Value& params, Stream& os, unsigned& requestId, bool notification);
     virtual ProcessResponseEnum ProcessResponse(char* response, size_t length, Value& result, unsigned requestId, bool notification);
+    virtual bool GenerateBatchRequest(Batch& batch, Stream& os, std::vector<unsigned>& requestIds);
+    virtual ProcessResponseEnum ProcessBatchResponse(char* response, size_t length, Batch& batch, std::vector<unsigned>& requestIds);
+
+protected:
+    //! Check a single response object and extract the result or error
+    ProcessResponseEnum ProcessResponseMessage(Value& message, Value& result, unsigned requestId);
 };
 
 
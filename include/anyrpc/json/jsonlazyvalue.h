@@ -0,0 +1,137 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_JSONLAZYVALUE_H_
+#define ANYRPC_JSONLAZYVALUE_H_
+
+namespace anyrpc
+{
+
+//! Json value that is only parsed when it is accessed.
+/*!
+ *  The value starts as the Json text in the request buffer.  Get and operator[]
+ *  find the extent of each member or element of a map or array without decoding
+ *  them and return another JsonLazyValue for the part, so only the parts that are
+ *  accessed are parsed.  GetValue parses the text in situ to a Value whose strings
+ *  reference the buffer, so the buffer must stay valid while the value is used.
+ *
+ *  GetText returns the text that hasn't been parsed, for example to forward it
+ *  without decoding.  Once a part of the text has been parsed in situ, the text of
+ *  that part and the maps and arrays that contain it is no longer available.
+ *
+ *  Errors in the text are only found in the parts that are accessed and are
+ *  thrown as an AnyRpcException.
+ */
+class ANYRPC_API JsonLazyValue
+{
+public:
+    JsonLazyValue();
+    //! Value for the Json text in a writable buffer
+    JsonLazyValue(char* json, std::size_t length);
+    //! Value that has already been parsed, such as the params from another protocol
+    explicit JsonLazyValue(Value& value);
+    ~JsonLazyValue();
+
+    //! Get the type, which only looks at the first character of the text
+    ValueType GetType() const;
+    bool IsMap() const { return GetType() == MapType; }
+    bool IsArray() const { return GetType() == ArrayType; }
+    bool IsString() const { return GetType() == StringType; }
+
+    //! Whether the value has been parsed
+    bool IsParsed() const { return value_ != 0; }
+    //! Get the text that hasn't been parsed, null if it is no longer available
+    const char* GetText(std::size_t& length) const;
+
+    //! Get the Value, parsing the text the first time
+    Value& GetValue();
+    //! Send the value as events to the handler, parsing the text without creating a Value
+    void Traverse(Handler& handler);
+
+    //! Find a member of a map, null if the map doesn't have the member
+    JsonLazyValue* Get(const char* key);
+    //! Number of elements of an array or members of a map
+    std::size_t Size();
+    //! Get an element of an array
+    JsonLazyValue& operator[](std::size_t index);
+
+private:
+    //! Value for a part of the text of the parent
+    JsonLazyValue(char* json, std::size_t length, JsonLazyValue* parent);
+    //! Find the extent of the members or elements of the text
+    void Index();
+    //! Create the parts of a Value that was already parsed
+    void IndexValue();
+    //! Use a Value that is owned by the parent in place of the parsed value
+    void MoveToParent(Value* value);
+
+    //! Member of a map or element of an array
+    struct Part
+    {
+        std::string key;                //!< Key of a map member, empty for an array element
+        JsonLazyValue* value;           //!< Value of the member or element
+    };
+
+    char* text_;                        //!< Json text, null if the value didn't come from text
+    std::size_t length_;                //!< Length of the text
+    Value* value_;                      //!< Parsed value, null until the value is accessed
+    bool ownsValue_;                    //!< Whether the parsed value is deleted with this value
+    JsonLazyValue* parent_;             //!< Map or array that contains this value
+    bool textModified_;                 //!< Whether a part of the text has been parsed in situ
+    bool indexed_;                      //!< Whether the parts have been found
+    std::size_t hint_;                  //!< Position to start searching for the next key
+    std::vector<Part> parts_;           //!< Members or elements that have been found
+
+    log_define("AnyRPC.JsonLazyValue");
+
+    // Prohibit copy constructor & assignment operator.
+    JsonLazyValue(const JsonLazyValue&);
+    JsonLazyValue& operator=(const JsonLazyValue&);
+};
+
+//! Function pointer for a method with lazy Json params
+typedef void JsonLazyFunction(JsonLazyValue& params, Value& result);
+
+//! A JsonLazyMethod receives the Json params without parsing them first.
+/*!
+ *  The Json servers only parse the parts of the params that the function accesses,
+ *  so a method that forwards a large part of the params with GetText avoids most
+ *  of the parse time.  The method, id, and jsonrpc members of the request are
+ *  still parsed before the call.  The params from other protocols are passed as
+ *  a JsonLazyValue that has already been parsed.
+ */
+class ANYRPC_API JsonLazyMethod : public Method
+{
+public:
+    JsonLazyMethod(JsonLazyFunction* function, std::string const& name, std::string const& help, bool deleteOnRemove=true) :
+        Method(name, help, deleteOnRemove), function_(function) {}
+
+    virtual bool LazyParams() const { return true; }
+    virtual void Execute(Value& params, Value& result);
+    //! Execute with the params from a Json request
+    virtual void ExecuteLazy(JsonLazyValue& params, Value& result) { if (function_) function_(params, result); }
+
+private:
+    JsonLazyFunction* function_;
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_JSONLAZYVALUE_H_
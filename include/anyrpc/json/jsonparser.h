@@ -0,0 +1,723 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_JSONPARSER_H_
+#define ANYRPC_JSONPARSER_H_
+
+namespace anyrpc
+{
+namespace internal
+{
+
+//! Character classes used by the Json parser
+enum
+{
+    JsonWhiteSpace = 1,
+    JsonDigit = 2
+};
+
+//! Look up the character class for the Json parser
+inline unsigned JsonCharClass(char c)
+{
+#define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+    // whitespace matches std::isspace in the C locale
+    static const unsigned char classes[256] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0,
+        Z16,
+        1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0,
+        Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
+    };
+#undef Z16
+    return classes[static_cast<unsigned char>(c)];
+}
+
+//! Json parser input that forwards to a Stream with virtual calls
+class JsonStreamInput
+{
+public:
+    JsonStreamInput(Stream& is) : is_(is) {}
+
+    bool Eof() const { return is_.Eof(); }
+    char Peek() const { return is_.Peek(); }
+    char Get() { return is_.Get(); }
+    std::size_t Tell() const { return is_.Tell(); }
+    const char* PeekBuffer(std::size_t& length) const { return is_.PeekBuffer(length); }
+    void Advance(std::size_t length) { is_.Advance(length); }
+
+    char* PutBegin() { return is_.PutBegin(); }
+    void Put(char c) { is_.Put(c); }
+    void Put(const char* str, std::size_t n) { is_.Put(str, n); }
+    std::size_t PutEnd() { return is_.PutEnd(); }
+
+private:
+    Stream& is_;
+};
+
+//! Json parser input from a contiguous buffer that can be inlined completely
+/*!
+ *  The buffer is only written for in situ parsing.  The decoded strings are
+ *  never longer than the Json text that was read so the writes stay behind the
+ *  read position.
+ */
+class JsonBufferInput
+{
+public:
+    JsonBufferInput(char* buffer, std::size_t length) :
+        src_(buffer), head_(buffer), end_(buffer + length), dst_(0), begin_(0) {}
+
+    bool Eof() const { return (src_ >= end_); }
+    char Peek() const { return (src_ < end_) ? *src_ : 0; }
+    char Get() { return (src_ < end_) ? *src_++ : 0; }
+    std::size_t Tell() const { return static_cast<std::size_t>(src_ - head_); }
+    const char* PeekBuffer(std::size_t& length) const { length = static_cast<std::size_t>(end_ - src_); return src_; }
+    void Advance(std::size_t length) { src_ += length; }
+
+    char* PutBegin() { dst_ = src_; begin_ = src_; return begin_; }
+    void Put(char c) { *dst_++ = c; }
+    void Put(const char* str, std::size_t n)
+    {
+        if (dst_ != str)
+            memmove(dst_, str, n);
+        dst_ += n;
+    }
+    std::size_t PutEnd() { std::size_t size = dst_ - begin_; dst_ = 0; begin_ = 0; return size; }
+
+private:
+    char* src_;         //!< Current location for reading data
+    char* head_;        //!< Start of the buffer
+    char* end_;         //!< End of the buffer
+    char* dst_;         //!< Location to write for Put calls
+    char* begin_;       //!< Location from the PutBegin
+};
+
+//! Output for decoded strings when not parsing in situ, reused for each string
+class JsonStringOutput
+{
+public:
+    void Clear() { str_.clear(); }
+    void Put(char c) { str_.push_back(c); }
+    void Put(const char* str, std::size_t n) { str_.append(str, n); }
+    const char* GetBuffer() const { return str_.c_str(); }
+    std::size_t Length() const { return str_.length(); }
+
+private:
+    std::string str_;
+};
+
+//! Recursive descent Json parser for a concrete input type
+/*!
+ *  The Input type provides the same functions as JsonBufferInput.  JsonReader
+ *  uses JsonBufferInput when the stream is a contiguous buffer so the compiler
+ *  can inline all of the character handling, and JsonStreamInput for other streams.
+ */
+template <typename Input>
+class JsonParser
+{
+public:
+    JsonParser(Input& is, Handler& handler, bool inSitu, bool copy) :
+        is_(is), handler_(&handler), inSitu_(inSitu), copy_(copy) {}
+
+    //! Parse a single value, which may be called recursively for arrays and maps
+    void ParseStream()
+    {
+        log_trace();
+        SkipWhiteSpace();
+
+        if (!is_.Eof())
+        {
+            ParseValue();
+        }
+    }
+
+    void SkipWhiteSpace()
+    {
+        while (!is_.Eof() && (JsonCharClass(is_.Peek()) & JsonWhiteSpace))
+            is_.Get();
+    }
+
+    void ParseValue();
+    void ParseNull();
+    void ParseTrue();
+    void ParseFalse();
+    void ParseString();
+    void ParseKey();
+    //! Parse the input to an output as a string that needs decoded.
+    template <typename Output>
+    void ParseStringToStream(Output& os);
+    unsigned ParseHex4();
+    template <typename Output>
+    void EncodeUtf8(Output& os, unsigned codepoint);
+    void ParseMap();
+    void ParseArray();
+    void ParseNumber();
+
+private:
+    bool IsDigit(char c) const { return (JsonCharClass(c) & JsonDigit) != 0; }
+
+    Input& is_;
+    Handler* handler_;
+    bool inSitu_;
+    bool copy_;
+    JsonStringOutput str_;              //!< Decoded string when not parsing in situ
+    DecimalDigits digits_;              //!< Digits of a number that don't fit in the significand
+
+    log_define("AnyRPC.JsonReader");
+};
+
+template <typename Input>
+void JsonParser<Input>::ParseValue()
+{
+    log_trace();
+    // Look at the next character to determine the type of parsing to perform
+    switch (is_.Peek()) {
+        case 'n': ParseNull(); break;
+        case 't': ParseTrue(); break;
+        case 'f': ParseFalse(); break;
+        case '"': ParseString(); break;
+        case '{': ParseMap(); break;
+        case '[': ParseArray(); break;
+        default : ParseNumber();
+    }
+}
+
+template <typename Input>
+void JsonParser<Input>::ParseNull()
+{
+    log_trace();
+    if ((is_.Get() != 'n') ||
+        (is_.Get() != 'u') ||
+        (is_.Get() != 'l') ||
+        (is_.Get() != 'l'))
+        anyrpc_throw(AnyRpcErrorValueInvalid, "Invalid value");
+
+    handler_->Null();
+}
+
+template <typename Input>
+void JsonParser<Input>::ParseTrue()
+{
+    log_trace();
+    if ((is_.Get() != 't') ||
+        (is_.Get() != 'r') ||
+        (is_.Get() != 'u') ||
+        (is_.Get() != 'e'))
+        anyrpc_throw(AnyRpcErrorValueInvalid, "Invalid value");
+
+    handler_->BoolTrue();
+}
+
+template <typename Input>
+void JsonParser<Input>::ParseFalse()
+{
+    log_trace();
+    if ((is_.Get() != 'f') ||
+        (is_.Get() != 'a') ||
+        (is_.Get() != 'l') ||
+        (is_.Get() != 's') ||
+        (is_.Get() != 'e'))
+        anyrpc_throw(AnyRpcErrorValueInvalid, "Invalid value");
+
+    handler_->BoolFalse();
+}
+
+template <typename Input>
+void JsonParser<Input>::ParseString()
+{
+    log_trace();
+    // This should only be called when a quote has already been determined to be the next character
+    anyrpc_assert(is_.Peek() == '\"', AnyRpcErrorParseError, "Expected \" but found " << is_.Peek());
+    is_.Get();
+
+    if (inSitu_)
+    {
+        // When parsing in place, mark the start position and continue with the decoding
+        char* str = is_.PutBegin();
+        ParseStringToStream(is_);
+        std::size_t length = is_.PutEnd() - 1;
+        handler_->String(str,length,copy_);
+    }
+    else
+    {
+        // Decode to the string buffer that is reused for each string
+        str_.Clear();
+        ParseStringToStream(str_);
+        handler_->String(str_.GetBuffer(),str_.Length()-1);
+    }
+}
+
+template <typename Input>
+void JsonParser<Input>::ParseKey()
+{
+    log_trace();
+    // This should only be called when a quote has already been determined to be the next character
+    anyrpc_assert(is_.Peek() == '\"', AnyRpcErrorParseError, "Expected \" but found " << is_.Peek());
+    is_.Get();
+
+    if (inSitu_)
+    {
+        // When parsing in place, mark the start position and continue with the decoding
+        char* str = is_.PutBegin();
+        ParseStringToStream(is_);
+        std::size_t length = is_.PutEnd() - 1;
+        handler_->Key(str,length,copy_);
+    }
+    else
+    {
+        // Decode to the string buffer that is reused for each string
+        str_.Clear();
+        ParseStringToStream(str_);
+        handler_->Key(str_.GetBuffer(),str_.Length()-1);
+    }
+}
+
+// This function is adapted from RapidJason (https://github.com/miloyip/rapidjson)
+template <typename Input>
+template <typename Output>
+void JsonParser<Input>::ParseStringToStream(Output& os)
+{
+    log_trace();
+#define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+    static const char escape[256] = {
+        Z16, Z16, 0, 0,'\"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'/',
+        Z16, Z16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'\\', 0, 0, 0,
+        0, 0,'\b', 0, 0, 0,'\f', 0, 0, 0, 0, 0, 0, 0,'\n', 0,
+        0, 0,'\r', 0,'\t', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
+    };
+#undef Z16
+
+    // Move runs of characters that don't need decoding in bulk when the input is a contiguous buffer
+    std::size_t available;
+    bool contiguous = (is_.PeekBuffer(available) != 0);
+
+    while (true)
+    {
+        if (contiguous)
+        {
+            const char* run = is_.PeekBuffer(available);
+            std::size_t length = ScanJsonString(run, available);
+            if (length > 0)
+            {
+                // advance first since the output may be the same buffer for in situ parsing
+                is_.Advance(length);
+                os.Put(run, length);
+            }
+        }
+
+        char c = is_.Peek();
+        if (c == '\\') // Escape
+        {
+            is_.Get();
+            unsigned char e = is_.Get();
+            if (escape[e])
+            {
+                os.Put(escape[e]);
+            }
+            else if (e == 'u')    // Unicode
+            {
+                unsigned codepoint = ParseHex4();
+                if ((codepoint >= 0xD800) && (codepoint <= 0xDBff))
+                {
+                    // Handle as UTF-16 surrogate pair
+                    if ((is_.Get() != '\\') || (is_.Get() != 'u'))
+                        anyrpc_throw(AnyRpcErrorStringUnicodeSurrogateInvalid,
+                                "The surrogate pair in string is invalid");
+                    unsigned codepoint2 = ParseHex4();
+                    if ((codepoint2 < 0xDC00) || (codepoint2 > 0xDFFF))
+                        anyrpc_throw(AnyRpcErrorStringUnicodeSurrogateInvalid,
+                                "The surrogate pair in string is invalid");
+                    codepoint = (((codepoint - 0xD800) << 10) | (codepoint2 - 0xDC00)) + 0x10000;
+                }
+                EncodeUtf8(os,codepoint);
+            }
+            else
+                anyrpc_throw(AnyRpcErrorStringEscapeInvalid,
+                        "Invalid escape character in string");
+        }
+        else if (c == '"')     // Closing double quote
+        {
+            is_.Get();
+            os.Put('\0');   // null-terminate the string
+            return;
+        }
+        else if (c == '\0')
+            anyrpc_throw(AnyRpcErrorStringMissingQuotationMark,
+                    "Missing a closing quotation mark in string");
+        else if ((unsigned)c < 0x20) // RFC 4627: unescaped = %x20-21 / %x23-5B / %x5D-10FFFF
+            anyrpc_throw(AnyRpcErrorStringEscapeInvalid,
+                    "Invalid escape character in string");
+        else
+            os.Put( is_.Get() );
+    }
+}
+
+// This function is adapted from RapidJason (https://github.com/miloyip/rapidjson)
+template <typename Input>
+unsigned JsonParser<Input>::ParseHex4()
+{
+    unsigned codepoint = 0;
+    for (int i=0; i<4; i++)
+    {
+        char c = is_.Get();
+        codepoint <<= 4;
+        if ((c >= '0') && (c <= '9'))
+            codepoint += (c - '0');
+        else if ((c >= 'A') && (c <= 'F'))
+            codepoint += (c - 'A' + 10);
+        else if ((c >= 'a') && (c <= 'f'))
+            codepoint += (c - 'a' + 10);
+        else
+            anyrpc_throw(AnyRpcErrorStringUnicodeEscapeInvalid,
+                    "Incorrect digit after escape in string");
+    }
+    return codepoint;
+}
+
+// This function is adapted from RapidJason (https://github.com/miloyip/rapidjson)
+template <typename Input>
+template <typename Output>
+void JsonParser<Input>::EncodeUtf8(Output& os, unsigned codepoint)
+{
+    if (codepoint <= 0x7F)
+    {
+        os.Put(static_cast<char>(codepoint));
+    }
+    else if (codepoint <= 0x7FF)
+    {
+        os.Put(static_cast<char>(0xC0 | ((codepoint >> 6) & 0xFF)));
+        os.Put(static_cast<char>(0x80 | ((codepoint     ) & 0x3F)));
+    }
+    else if (codepoint <= 0xFFFF)
+    {
+        os.Put(static_cast<char>(0xE0 | ((codepoint >>12) & 0xFF)));
+        os.Put(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        os.Put(static_cast<char>(0x80 | ((codepoint     ) & 0x3F)));
+    }
+    else
+    {
+        os.Put(static_cast<char>(0xF0 | ((codepoint >>18) & 0xFF)));
+        os.Put(static_cast<char>(0x80 | ((codepoint >>12) & 0x3F)));
+        os.Put(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        os.Put(static_cast<char>(0x80 | ((codepoint     ) & 0x3F)));
+    }
+}
+
+template <typename Input>
+void JsonParser<Input>::ParseMap()
+{
+    log_trace();
+    anyrpc_assert(is_.Peek() == '{', AnyRpcErrorParseError, "Expected { but found " << is_.Peek());
+    is_.Get();  // Skip '{'
+
+    handler_->StartMap();
+
+    SkipWhiteSpace();
+
+    if (is_.Peek() == '}')
+    {
+        is_.Get();
+        handler_->EndMap(0);  // empty object
+        return;
+    }
+
+    for (std::size_t memberCount = 0;;)
+    {
+        if (is_.Peek() != '\"')
+            anyrpc_throw(AnyRpcErrorObjectMissName, "Missing a name for object member");
+
+        ParseKey();
+        SkipWhiteSpace();
+
+        if (is_.Get() != ':')
+            anyrpc_throw(AnyRpcErrorObjectMissColon, "Missing a colon after a name of object member");
+
+        SkipWhiteSpace();
+        ParseValue();
+        SkipWhiteSpace();
+
+        ++memberCount;
+
+        switch (is_.Get())
+        {
+            case ',':
+                SkipWhiteSpace();
+                handler_->MapSeparator();
+                break;
+            case '}':
+                handler_->EndMap(memberCount);
+                return;
+            default:
+                anyrpc_throw(AnyRpcErrorObjectMissCommaOrCurlyBracket,
+                        "Missing a comma or '}' after an object member");
+        }
+    }
+}
+
+template <typename Input>
+void JsonParser<Input>::ParseArray()
+{
+    log_trace();
+    anyrpc_assert(is_.Peek() == '[', AnyRpcErrorParseError, "Expected [ but found " << is_.Peek());
+    is_.Get();  // Skip '['
+
+    handler_->StartArray();
+
+    SkipWhiteSpace();
+
+    if (is_.Peek() == ']')
+    {
+        is_.Get();
+        handler_->EndArray(0); // empty array
+        return;
+    }
+
+    for (std::size_t elementCount = 0;;)
+    {
+        ParseValue();
+
+        ++elementCount;
+        SkipWhiteSpace();
+
+        switch (is_.Get())
+        {
+            case ',':
+                SkipWhiteSpace();
+                handler_->ArraySeparator();
+                break;
+            case ']':
+                handler_->EndArray(elementCount);
+                return;
+            default:
+                anyrpc_throw(AnyRpcErrorArrayMissCommaOrSquareBracket,
+                        "Missing a comma or ']' after an array element");
+        }
+    }
+}
+
+// This function is adapted from RapidJason (https://github.com/miloyip/rapidjson)
+template <typename Input>
+void JsonParser<Input>::ParseNumber()
+{
+    log_trace();
+    // Parse minus
+    bool minus = false;
+    if (is_.Peek() == '-')
+    {
+        minus = true;
+        is_.Get();
+    }
+
+    // Parse int: zero / ( digit1-9 *DIGIT )
+    unsigned i = 0;
+    uint64_t i64 = 0;
+    bool use64bit = false;
+    if (is_.Peek() == '0')
+    {
+        i = 0;
+        is_.Get();
+    }
+    else if (IsDigit(is_.Peek()))
+    {
+        i = static_cast<unsigned>(is_.Get() - '0');
+
+        if (minus)
+            while (IsDigit(is_.Peek()))
+            {
+                if (i >= 214748364) { // 2^31 = 2147483648
+                    if ((i != 214748364) || (is_.Peek() > '8'))
+                    {
+                        i64 = i;
+                        use64bit = true;
+                        break;
+                    }
+                }
+                i = i * 10 + static_cast<unsigned>(is_.Get() - '0');
+            }
+        else
+            while (IsDigit(is_.Peek()))
+            {
+                if (i >= 429496729) { // 2^32 - 1 = 4294967295
+                    if ((i != 429496729) || (is_.Peek() > '5'))
+                    {
+                        i64 = i;
+                        use64bit = true;
+                        break;
+                    }
+                }
+                i = i * 10 + static_cast<unsigned>(is_.Get() - '0');
+            }
+    }
+    else
+        anyrpc_throw(AnyRpcErrorValueInvalid, "Invalid value");
+
+    // Parse 64bit int
+    bool useDouble = false;
+    digits_.Clear();
+    if (use64bit)
+    {
+        if (minus)
+            while (IsDigit(is_.Peek()))
+            {
+                 if (i64 >= ANYRPC_UINT64_C2(0x0CCCCCCC, 0xCCCCCCCC)) // 2^63 = 9223372036854775808
+                    if ((i64 != ANYRPC_UINT64_C2(0x0CCCCCCC, 0xCCCCCCCC)) || (is_.Peek() > '8'))
+                    {
+                        useDouble = true;
+                        break;
+                    }
+                i64 = i64 * 10 + static_cast<unsigned>(is_.Get() - '0');
+            }
+        else
+            while (IsDigit(is_.Peek()))
+            {
+                if (i64 >= ANYRPC_UINT64_C2(0x19999999, 0x99999999)) // 2^64 - 1 = 18446744073709551615
+                    if ((i64 != ANYRPC_UINT64_C2(0x19999999, 0x99999999)) || (is_.Peek() > '5'))
+                    {
+                        useDouble = true;
+                        break;
+                    }
+                i64 = i64 * 10 + static_cast<unsigned>(is_.Get() - '0');
+            }
+    }
+
+    // Force double for big integer
+    bool exactSignificand = false;      // i64 holds all of the non-zero digits for the Eisel-Lemire conversion
+    int expInt = 0;                     // integer digits that are not in i64
+    if (useDouble) {
+        exactSignificand = true;
+        while (IsDigit(is_.Peek()))
+        {
+            if (expInt >= 309)
+                anyrpc_throw(AnyRpcErrorNumberTooBig, "Number too big to be stored in double");
+            char c = is_.Get();
+            exactSignificand = exactSignificand && (c == '0');
+            expInt++;
+            digits_.Append(c);
+        }
+    }
+
+    // Parse frac = decimal-point 1*DIGIT
+    int expFrac = 0;
+    if (is_.Peek() == '.')
+    {
+        is_.Get();
+
+        if (!IsDigit(is_.Peek()))
+            anyrpc_throw(AnyRpcErrorNumberMissFraction, "Missing fraction part in number");
+
+        if (!useDouble)
+        {
+            // Use i64 to store the significand
+            if (!use64bit)
+                i64 = i;
+
+            while (IsDigit(is_.Peek()))
+            {
+                if (i64 >= ANYRPC_UINT64_C2(0x19999999, 0x99999999)) // another digit could overflow
+                    break;
+                i64 = i64 * 10 + static_cast<unsigned>(is_.Get() - '0');
+                --expFrac;
+            }
+
+            exactSignificand = !IsDigit(is_.Peek());
+            useDouble = true;
+        }
+        else
+            exactSignificand = false;
+        // keep the digits that don't fit in i64 for the exact conversion
+        while (IsDigit(is_.Peek()))
+        {
+            digits_.Append(is_.Get());
+            --expFrac;
+        }
+    }
+
+    // Parse exp = e [ minus / plus ] 1*DIGIT
+    int exp = 0;
+    if ((is_.Peek() == 'e') || (is_.Peek() == 'E'))
+    {
+        if (!useDouble)
+        {
+            if (!use64bit)
+                i64 = i;
+            exactSignificand = true;
+            useDouble = true;
+        }
+        is_.Get();
+
+        bool expMinus = false;
+        if (is_.Peek() == '+')
+            is_.Get();
+        else if (is_.Peek() == '-')
+        {
+            is_.Get();
+            expMinus = true;
+        }
+
+        if (IsDigit(is_.Peek()))
+        {
+            exp = is_.Get() - '0';
+            while (IsDigit(is_.Peek()))
+            {
+                exp = exp * 10 + (is_.Get() - '0');
+                if ((exp > 308) && !expMinus) // exp > 308 should be rare, so it should be checked first.
+                    anyrpc_throw(AnyRpcErrorNumberTooBig, "Number too big to be stored in double");
+            }
+        }
+        else
+            anyrpc_throw(AnyRpcErrorNumberMissExponent, "Missing exponent in number");
+
+        if (expMinus)
+            exp = -exp;
+    }
+
+    // Finish parsing, call event according to the type of number.
+    if (useDouble)
+    {
+        int p = exp + expFrac;
+        double d;
+        // the numbers with more digits or near the ends of the range need the exact conversion
+        if ((!exactSignificand || !EiselLemire(i64, p + expInt, d)) && !StrtodExact(i64, digits_, p, d))
+            anyrpc_throw(AnyRpcErrorNumberTooBig, "Number too big to be stored in double");
+
+        handler_->Double(minus ? -d : d);
+    }
+    else {
+        if (use64bit)
+        {
+            if (minus)
+                handler_->Int64(-(int64_t)i64);
+            else
+                handler_->Uint64(i64);
+        }
+        else
+        {
+            if (minus)
+                handler_->Int(-(int)i);
+            else
+                handler_->Uint(i);
+        }
+    }
+}
+
+} // namespace internal
+} // namespace anyrpc
+
+#endif // ANYRPC_JSONPARSER_H_
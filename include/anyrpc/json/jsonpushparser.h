@@ -0,0 +1,113 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+#ifndef ANYRPC_JSONPUSHPARSER_H_
+#define ANYRPC_JSONPUSHPARSER_H_
+
+namespace anyrpc
+{
+
+//! Parse Json text that is received in pieces of any size
+/*!
+ *  The data is given to Parse as it arrives and parsing stops at the end of each
+ *  piece, even in the middle of a string or number, and continues with the next one.
+ *  This allows a large request to be parsed while the rest of it is still being
+ *  received.  Finish is called after the last piece to complete the document.
+ *
+ *  The handler receives the same calls as from the JsonReader.  Strings and
+ *  numbers that are complete in a piece are decoded directly from it, and the
+ *  ones split between pieces are collected in an internal buffer first.  As with
+ *  the JsonReader, any data after the first complete value is ignored.
+ */
+class ANYRPC_API JsonPushParser
+{
+public:
+    JsonPushParser(Handler& handler) : handler_(handler) { Reset(); }
+
+    //! Prepare to parse a new document
+    void Reset();
+    //! Parse the next piece of data.  Return false if an error has occurred.
+    bool Parse(const char* data, std::size_t length);
+    //! Complete the document after all of the data has been parsed.  Return false if an error has occurred.
+    bool Finish();
+    //! Indicate whether a complete value has been parsed
+    bool IsComplete() const { return (state_ == Complete); }
+
+    //! Indicate whether an error has occurred during the processing
+    bool HasParseError() const { return parseError_.IsErrorSet(); }
+    int GetParseErrorCode() const { return parseError_.GetCode(); }
+    const std::string& GetParseErrorStr() const { return parseError_.GetMessage(); }
+    std::size_t GetErrorOffset() const { return parseError_.GetOffset(); }
+
+private:
+    //! Position in the Json grammar between tokens
+    enum State
+    {
+        ExpectValue,            //!< Start of the document, after a colon, or after a comma in an array
+        ExpectValueOrEnd,       //!< After the start of an array
+        ExpectKey,              //!< After a comma in a map
+        ExpectKeyOrEnd,         //!< After the start of a map
+        ExpectColon,            //!< After a key
+        ExpectCommaOrEnd,       //!< After a value in an array or map
+        Complete                //!< The top level value has been parsed
+    };
+
+    //! Token that is split between pieces of data
+    enum Token
+    {
+        NoToken, StringToken, KeyToken, ScalarToken
+    };
+
+    //! Open array or map
+    struct Container
+    {
+        Container(bool isMap) : isMap_(isMap), count_(0) {}
+        bool isMap_;
+        std::size_t count_;
+    };
+
+    //! Process the data until the end or an error, which throws an exception with pos at the error
+    void ParseData(const char* data, std::size_t length, std::size_t& pos);
+    //! Decode the token at pos if it is complete in the data or keep it for the next piece.  Return the position after it.
+    std::size_t StartToken(const char* data, std::size_t length, std::size_t pos, Token token);
+    //! Find the position after the closing quote of a string.  Return npos if it isn't in the data.
+    std::size_t FindStringEnd(const char* data, std::size_t length, std::size_t pos);
+    //! Decode a complete string, including the quotes, or a number or literal
+    void ParseToken(const char* str, std::size_t length, Token token);
+    //! Update the state after a value was completed
+    void EndValue();
+    //! Set the error at the current offset
+    void SetParseError(AnyRpcException& fault, std::size_t pos);
+
+    Handler& handler_;
+    State state_;                       //!< Position in the grammar
+    std::vector<Container> stack_;      //!< Arrays and maps that are open
+    Token token_;                       //!< Type of token that is collected in tokenStr_
+    std::string tokenStr_;              //!< Start of a token that continues in the next piece
+    bool escaped_;                      //!< The token ends with a backslash that escapes the next character
+    bool started_;                      //!< StartDocument has been called
+    std::size_t offset_;                //!< Offset of the current piece of data in the document
+    AnyRpcException parseError_;
+
+    log_define("AnyRPC.JsonPushParser");
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_JSONPUSHPARSER_H_
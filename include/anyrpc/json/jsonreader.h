@@ -35,21 +35,9 @@ public:
     virtual void ParseStream(Handler& handler);
 
 private:
-    //! Internal function that may be called recursively to parse the stream.
-    void ParseStream();
-    void ParseValue();
-    void ParseNull();
-    void ParseTrue();
-    void ParseFalse();
-    void ParseString();
-    void ParseKey();
-    //! Parse the input stream to an output stream as a string that needs decoded.
-    void ParseStringToStream(Stream& os);
-    unsigned ParseHex4();
-    void EncodeUtf8(Stream& os, unsigned codepoint);
-    void ParseMap();
-    void ParseArray();
-    void ParseNumber();
+    //! Parse with the JsonParser for the concrete input type, the offset is added to error positions
+    template <typename Input>
+    void ParseInput(Input& input, std::size_t offset);
 
     log_define("AnyRPC.JsonReader");
 };
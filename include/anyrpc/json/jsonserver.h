@@ -25,13 +25,19 @@ namespace anyrpc
 {
 
 bool JsonRpcHandler(MethodManager* manager, char* request, std::size_t length, Stream &response);
+//! Create a parser that processes a Json request while it is received
+/*!
+ *  Returns 0 when the manager has methods with lazy params so that the
+ *  request is only parsed as far as the method needs once it is complete.
+ */
+RpcRequestParser* JsonRpcCreateParser(MethodManager* manager);
 
 ////////////////////////////////////////////////////////////////////////////////
 
 class ANYRPC_API JsonHttpServer : public ServerST
 {
 public:
-    JsonHttpServer() { AddHandler( &JsonRpcHandler, "", "application/json-rpc" ); }
+    JsonHttpServer() { AddHandler( &JsonRpcHandler, "", "application/json-rpc", &JsonRpcCreateParser ); }
 
 protected:
     virtual Connection* CreateConnection(SOCKET fd) { return new HttpConnection(fd, GetMethodManager(), GetRpcHandlerList()); }
@@ -51,7 +57,7 @@ protected:
 class ANYRPC_API JsonHttpServerMT : public ServerMT
 {
 public:
-    JsonHttpServerMT() { AddHandler( &JsonRpcHandler, "", "application/json-rpc" ); }
+    JsonHttpServerMT() { AddHandler( &JsonRpcHandler, "", "application/json-rpc", &JsonRpcCreateParser ); }
 
 protected:
     virtual Connection* CreateConnection(SOCKET fd) { return new HttpConnection(fd, GetMethodManager(), GetRpcHandlerList()); }
@@ -70,8 +76,8 @@ protected:
 class ANYRPC_API JsonHttpServerTP : public ServerTP
 {
 public:
-    JsonHttpServerTP() { AddHandler( &JsonRpcHandler, "", "application/json-rpc" ); }
-    JsonHttpServerTP(const unsigned numThreads) : ServerTP(numThreads) { AddHandler( &JsonRpcHandler, "", "application/json-rpc" ); }
+    JsonHttpServerTP() { AddHandler( &JsonRpcHandler, "", "application/json-rpc", &JsonRpcCreateParser ); }
+    JsonHttpServerTP(const unsigned numThreads) : ServerTP(numThreads) { AddHandler( &JsonRpcHandler, "", "application/json-rpc", &JsonRpcCreateParser ); }
 
 protected:
     virtual Connection* CreateConnection(SOCKET fd) { return new HttpConnection(fd, GetMethodManager(), GetRpcHandlerList()); }
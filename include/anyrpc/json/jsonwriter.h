@@ -81,6 +81,7 @@ public:
     virtual void StartArray();
     virtual void ArraySeparator();
     virtual void EndArray(std::size_t elementCount = 0);
+    virtual void TypedArray(TypedArrayType type, const void* data, std::size_t elementCount);
     //@}
 
 private:
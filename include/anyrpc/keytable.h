@@ -0,0 +1,78 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_KEYTABLE_H_
+#define ANYRPC_KEYTABLE_H_
+
+namespace anyrpc
+{
+
+//! Global table of interned map keys
+/*!
+ *  Maps in requests and responses repeat a small set of keys.  When a member
+ *  is added with a key that is in the table, the key references the interned
+ *  string instead of storing its own copy.  Finding a member with an interned
+ *  key compares the string pointers and the hash index uses the hash that
+ *  was calculated when the key was interned.
+ *
+ *  The protocol keys (jsonrpc, id, method, params, result, error, code,
+ *  message, faultCode, faultString) are interned at startup.  Applications
+ *  should intern the keys of their own schemas before creating the maps that
+ *  use them, i.e. before starting the servers.  Interned keys are never
+ *  removed and the table has a fixed capacity.
+ *
+ *  Finding a key doesn't lock so the table can be used by several server
+ *  threads while keys are interned.
+ */
+class ANYRPC_API KeyTable
+{
+public:
+    //! Add the key to the table and return the interned string, 0 if the table is full
+    static const char* Intern(const char* str, std::size_t length);
+    //! Add the key to the table and return the interned string, 0 if the table is full
+    static const char* Intern(const char* str) { return Intern(str, strlen(str)); }
+    //! Get the interned string for the key, 0 if it isn't in the table
+    static const char* Find(const char* str, std::size_t length);
+    //! Get the hash of an interned string
+    static uint32_t GetHash(const char* interned) { return reinterpret_cast<const Entry*>(interned - sizeof(Entry))->hash; }
+    //! Number of interned keys
+    static std::size_t GetSize();
+
+    //! Hash of a key string
+    static uint32_t Hash(const char* str, std::size_t length);
+
+    static const std::size_t MaxKeys = 512;
+
+private:
+    log_define("AnyRPC.KeyTable");
+
+    //! Header in front of the characters of an interned string
+    struct Entry
+    {
+        uint32_t hash;          //!< Hash of the string
+        uint32_t length;        //!< Number of characters, not including the terminating zero
+    };
+
+    static const std::size_t Slots = 2 * MaxKeys;
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_KEYTABLE_H_
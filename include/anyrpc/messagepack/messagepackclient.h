@@ -42,6 +42,22 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class ANYRPC_API MessagePackHttpBalancedClient : public BalancedClient
+{
+protected:
+    virtual Client* CreateClient(const char* host, int port) { return new MessagePackHttpClient(host, port); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ANYRPC_API MessagePackTcpBalancedClient : public BalancedClient
+{
+protected:
+    virtual Client* CreateClient(const char* host, int port) { return new MessagePackTcpClient(host, port); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 //! ClientHandler for MessagePack format to generate the request and process the response
 class ANYRPC_API MessagePackClientHandler : public ClientHandler
 {
@@ -76,6 +76,7 @@ public:
     //@{
     virtual void StartArray(std::size_t elementCount);
     virtual void EndArray(std::size_t elementCount = 0);
+    virtual void TypedArray(TypedArrayType type, const void* data, std::size_t elementCount);
     //@}
 
 private:
@@ -85,6 +86,13 @@ private:
     void WriteUint(unsigned u);
     //! Write an unsigned 64bit number to the output stream
     void WriteUint64(uint64_t u64);
+    //!@name Write a type marker and its big endian data with a single call to the stream
+    //@{
+    void PutTag8(unsigned char tag, char value);
+    void PutTag16(unsigned char tag, uint16_t value);
+    void PutTag32(unsigned char tag, uint32_t value);
+    void PutTag64(unsigned char tag, uint64_t value);
+    //@}
 
     log_define("AnyRPC.MpacWriter");
 };
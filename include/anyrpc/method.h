@@ -27,6 +27,8 @@ namespace anyrpc
 typedef void Function (Value& params, Value& result);
 
 class MethodManager;
+class ParamSchema;
+class JsonLazyValue;
 
 //! The Method class is used to specify RPC functions to call.
 /*!
@@ -42,18 +44,26 @@ class ANYRPC_API Method
 {
 public:
     Method(std::string const& name, std::string const& help, bool deleteOnRemove=true) :
-        name_(name), help_(help), deleteOnRemove_(deleteOnRemove) {}
+        name_(name), help_(help), deleteOnRemove_(deleteOnRemove), paramSchema_(0) {}
     virtual ~Method() {}
 
     virtual void Execute(Value& /* params */, Value& /* result */) {}
     std::string& Name() { return name_; }
     std::string& Help() { return help_; }
     bool DeleteOnRemove() { return deleteOnRemove_; }
+    //! Schema that the params are checked against before Execute, null if they aren't checked
+    const ParamSchema* GetParamSchema() { return paramSchema_; }
+    void SetParamSchema(const ParamSchema* schema) { paramSchema_ = schema; }
+    //! Whether the method takes Json params that are only parsed when they are accessed, see JsonLazyMethod
+    virtual bool LazyParams() const { return false; }
+    //! Execute with Json params that are only parsed when they are accessed.  Called instead of Execute when LazyParams is true.
+    virtual void ExecuteLazy(JsonLazyValue& /* params */, Value& /* result */) {}
 
 protected:
     std::string name_;
     std::string help_;
     bool deleteOnRemove_;
+    const ParamSchema* paramSchema_;
 
     log_define("AnyRcp.Method");
 };
@@ -69,6 +79,215 @@ private:
     Function *function_;
 };
 
+#if ANYRPC_HAS_VARIADIC_TEMPLATES
+namespace internal
+{
+
+//! Conversion between a Value and the C++ type of a typed method parameter or result
+/*!
+ *  Check indicates whether the Value can be converted to the type, Get converts
+ *  the Value, and Set stores the type in the result.
+ */
+template <typename T> struct ValueConverter;
+
+template <> struct ValueConverter<bool>
+{
+    static const char* Name() { return "bool"; }
+    static bool Check(const Value& value) { return value.IsBool(); }
+    static bool Get(Value& value) { return value.GetBool(); }
+    static void Set(Value& result, bool b) { result = b; }
+};
+
+template <> struct ValueConverter<int>
+{
+    static const char* Name() { return "int"; }
+    static bool Check(const Value& value) { return value.IsInt(); }
+    static int Get(Value& value) { return value.GetInt(); }
+    static void Set(Value& result, int i) { result = i; }
+};
+
+template <> struct ValueConverter<unsigned>
+{
+    static const char* Name() { return "unsigned"; }
+    static bool Check(const Value& value) { return value.IsUint(); }
+    static unsigned Get(Value& value) { return value.GetUint(); }
+    static void Set(Value& result, unsigned u) { result = u; }
+};
+
+template <> struct ValueConverter<int64_t>
+{
+    static const char* Name() { return "int64"; }
+    static bool Check(const Value& value) { return value.IsInt64(); }
+    static int64_t Get(Value& value) { return value.GetInt64(); }
+    static void Set(Value& result, int64_t i64) { result = i64; }
+};
+
+template <> struct ValueConverter<uint64_t>
+{
+    static const char* Name() { return "uint64"; }
+    static bool Check(const Value& value) { return value.IsUint64(); }
+    static uint64_t Get(Value& value) { return value.GetUint64(); }
+    static void Set(Value& result, uint64_t u64) { result = u64; }
+};
+
+template <> struct ValueConverter<float>
+{
+    static const char* Name() { return "float"; }
+    static bool Check(const Value& value) { return value.IsNumber(); }
+    static float Get(Value& value) { return value.GetFloat(); }
+    static void Set(Value& result, float f) { result = f; }
+};
+
+template <> struct ValueConverter<double>
+{
+    static const char* Name() { return "double"; }
+    static bool Check(const Value& value) { return value.IsNumber(); }
+    static double Get(Value& value) { return value.GetDouble(); }
+    static void Set(Value& result, double d) { result = d; }
+};
+
+template <> struct ValueConverter<std::string>
+{
+    static const char* Name() { return "string"; }
+    static bool Check(const Value& value) { return value.IsString(); }
+    static std::string Get(Value& value) { return std::string(value.GetString(), value.GetStringLength()); }
+    static void Set(Value& result, const std::string& s) { result = s; }
+};
+
+//! Any Value is passed through without conversion
+template <> struct ValueConverter<Value>
+{
+    static const char* Name() { return "value"; }
+    static bool Check(const Value& value) { return value.IsValid(); }
+    static Value& Get(Value& value) { return value; }
+    static void Set(Value& result, Value& value) { result.Assign(value); }
+};
+
+//! Arrays are converted to vectors with each element checked
+template <typename T> struct ValueConverter<std::vector<T> >
+{
+    static const char* Name() { return "array"; }
+    static bool Check(const Value& value)
+    {
+        if (!value.IsArray())
+            return false;
+        Value& array = const_cast<Value&>(value);
+        for (std::size_t i=0; i<array.Size(); i++)
+            if (!ValueConverter<T>::Check(array[i]))
+                return false;
+        return true;
+    }
+    static std::vector<T> Get(Value& value)
+    {
+        std::vector<T> v;
+        v.reserve(value.Size());
+        for (std::size_t i=0; i<value.Size(); i++)
+            v.push_back(ValueConverter<T>::Get(value[i]));
+        return v;
+    }
+    static void Set(Value& result, const std::vector<T>& v)
+    {
+        result.SetArray(v.size());
+        for (std::size_t i=0; i<v.size(); i++)
+            ValueConverter<T>::Set(result[i], v[i]);
+    }
+};
+
+//! Compile time list of the parameter positions
+template <std::size_t... I> struct IndexSequence {};
+template <std::size_t N, std::size_t... I> struct MakeIndexSequence : MakeIndexSequence<N-1, N-1, I...> {};
+template <std::size_t... I> struct MakeIndexSequence<0, I...> { typedef IndexSequence<I...> Type; };
+
+//! Check each param against the type of the function parameter at the same position
+template <typename... Args> struct TypedParams
+{
+    template <std::size_t... I>
+    static bool Check(Value& params, std::size_t& index, const char*& expected, IndexSequence<I...>)
+    {
+        bool valid[] = { true, CheckParam<typename std::decay<Args>::type>(params[I], I, index, expected)... };
+        for (std::size_t i=0; i<sizeof(valid)/sizeof(valid[0]); i++)
+            if (!valid[i])
+                return false;
+        return true;
+    }
+
+    template <typename T>
+    static bool CheckParam(Value& param, std::size_t i, std::size_t& index, const char*& expected)
+    {
+        if (ValueConverter<T>::Check(param))
+            return true;
+        if (expected == 0)
+        {
+            // report the first parameter that doesn't match
+            index = i;
+            expected = ValueConverter<T>::Name();
+        }
+        return false;
+    }
+};
+
+//! Call the function with the converted params and store the converted return value in the result
+template <typename R, typename... Args> struct TypedInvoker
+{
+    template <std::size_t... I>
+    static void Call(R (*function)(Args...), Value& params, Value& result, IndexSequence<I...>)
+    {
+        R value = function(ValueConverter<typename std::decay<Args>::type>::Get(params[I])...);
+        ValueConverter<typename std::decay<R>::type>::Set(result, value);
+    }
+};
+
+//! Functions without a return value produce a null result
+template <typename... Args> struct TypedInvoker<void, Args...>
+{
+    template <std::size_t... I>
+    static void Call(void (*function)(Args...), Value& params, Value& result, IndexSequence<I...>)
+    {
+        function(ValueConverter<typename std::decay<Args>::type>::Get(params[I])...);
+        result.SetNull();
+    }
+};
+
+} // namespace internal
+
+template <typename Signature> class TypedMethodFunction;
+
+//! A TypedMethodFunction calls a function with C++ parameter and return types.
+/*!
+ *  The params must be an array with an element for each parameter of the function.
+ *  The types are checked before the function is called and a mismatch produces an
+ *  AnyRpcErrorInvalidParams fault that names the parameter and the expected type.
+ *  Supported types are bool, int, unsigned, int64_t, uint64_t, float, double,
+ *  std::string, Value, and std::vector of these types.  Parameters may also be
+ *  const references to these types.
+ */
+template <typename R, typename... Args>
+class TypedMethodFunction<R(Args...)> : public Method
+{
+public:
+    typedef R FunctionType(Args...);
+
+    TypedMethodFunction(FunctionType* function, std::string const& name, std::string const& help, bool deleteOnRemove=true) :
+        Method(name, help, deleteOnRemove), function_(function) {}
+
+    virtual void Execute(Value& params, Value& result)
+    {
+        const std::size_t numParams = sizeof...(Args);
+        if (params.IsArray() ? (params.Size() != numParams) : (numParams != 0))
+            anyrpc_throw(AnyRpcErrorInvalidParams, "Invalid parameters, expected " << numParams << " parameters");
+        typedef typename internal::MakeIndexSequence<sizeof...(Args)>::Type Indices;
+        std::size_t index = 0;
+        const char* expected = 0;
+        if (!internal::TypedParams<Args...>::Check(params, index, expected, Indices()))
+            anyrpc_throw(AnyRpcErrorInvalidParams, "Invalid parameter " << index << ", expected " << expected);
+        internal::TypedInvoker<R, Args...>::Call(function_, params, result, Indices());
+    }
+
+private:
+    FunctionType* function_;
+};
+#endif // ANYRPC_HAS_VARIADIC_TEMPLATES
+
 //! MethodInternal classes are typically used for introspection of the MethodManager.
 class MethodInternal : public Method
 {
@@ -116,18 +335,66 @@ public:
     ~MethodManager();
 
     void AddFunction(Function* function, std::string const& name, std::string const& help);
+#if ANYRPC_HAS_VARIADIC_TEMPLATES
+    //! Add a function with C++ parameter and return types, e.g. AddFunction<int(double, const std::string&)>
+    template <typename Signature>
+    void AddFunction(Signature* function, std::string const& name, std::string const& help)
+    {
+        AddMethod(new TypedMethodFunction<Signature>(function, name, help));
+    }
+#endif
     void AddMethod(Method* method);
-    bool ExecuteMethod(std::string const& name, Value& params, Value& result);
+    //! Execute the method, checking the params against its schema unless they were already checked while parsing
+    bool ExecuteMethod(std::string const& name, Value& params, Value& result, bool paramsValidated=false);
+    //! Execute the method with Json params that are only parsed when they are accessed, or all parsed first if the method doesn't take lazy params
+    bool ExecuteLazyMethod(std::string const& name, JsonLazyValue& params, Value& result);
+
+    //! Check the params of the method against a copy of the schema before it is executed
+    void SetParamSchema(std::string const& name, const ParamSchema& schema);
+    //! Get the schema of the method, null if the method doesn't have one
+    const ParamSchema* FindParamSchema(std::string const& name) const;
+    //! Whether any method has a schema
+    bool HasParamSchemas() const { return !schemas_.empty(); }
+    //! Find the method with the name, null if it isn't defined
+    Method* FindMethod(std::string const& name);
+    //! Whether any method takes lazy params
+    bool HasLazyMethods() const { return lazyMethods_ > 0; }
     void ListMethods(Value& params, Value& result);
     void FindHelpMethod(Value& params, Value& result);
 
+    //! Set the deadline for methods executed by the calling thread.  Later methods will fail with AnyRpcErrorDeadlineExceeded.
+    static void SetDeadline(const struct timeval& deadline);
+    //! Remove the deadline for methods executed by the calling thread
+    static void ClearDeadline();
+    //! Indicate whether the deadline for the calling thread has passed
+    static bool DeadlineExpired();
+
 private:
+    //! Check the deadline and the params against the schema of the method before it is executed
+    template <typename ParamsType>
+    void CheckExecute(Method* method, ParamsType& params, bool paramsValidated);
+
     typedef std::map<std::string, Method*> MethodMap;   //!< definition of mapping function using the method name as the key
     MethodMap methods_;                                 //!< map of method names to method definitions
+    std::vector<ParamSchema*> schemas_;                 //!< schemas that were set for the methods
+    std::size_t lazyMethods_;                           //!< number of methods that take lazy params
 
     log_define("AnyRPC.MethodManager");
 };
 
+//! Set the deadline for the calling thread for the lifetime of the scope and then remove it
+class ANYRPC_API DeadlineScope
+{
+public:
+    //! A deadline with zero seconds leaves the thread without a deadline
+    DeadlineScope(const struct timeval& deadline) { if (deadline.tv_sec != 0) MethodManager::SetDeadline(deadline); }
+    ~DeadlineScope() { MethodManager::ClearDeadline(); }
+
+private:
+    DeadlineScope(const DeadlineScope&);
+    DeadlineScope& operator=(const DeadlineScope&);
+};
+
 } // namespace anyrpc
 
 #endif // ANYRPC_METHOD_H_
@@ -0,0 +1,271 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_PARAMSCHEMA_H_
+#define ANYRPC_PARAMSCHEMA_H_
+
+namespace anyrpc
+{
+
+class MethodManager;
+
+//! Description of the params that a method accepts.
+/*!
+ *  The schema gives the type of each value along with the required members of
+ *  maps, the positional elements of arrays, the length of strings, arrays, and
+ *  maps, and the range of numbers.  It is stored as a table of nodes so that a
+ *  SchemaValidator can check the parse events with a stack of node indices.
+ *
+ *  ParamSchema lookup(ParamSchema::ArrayType);
+ *  lookup.Element(ParamSchema(ParamSchema::StringType).Length(1, 64))
+ *        .Element(ParamSchema(ParamSchema::IntegerType).Range(0, 1000));
+ *  server.GetMethodManager()->SetParamSchema("lookup", lookup);
+ *
+ *  Integer values are accepted for NumberType and the Json extension arrays
+ *  are accepted for BinaryType and DateTimeType.
+ */
+class ANYRPC_API ParamSchema
+{
+public:
+    enum Type { AnyType, NullType, BoolType, IntegerType, NumberType, StringType, BinaryType, DateTimeType, ArrayType, MapType };
+
+    static const std::size_t NoNode = static_cast<std::size_t>(-1);     //!< Index for values that aren't checked
+
+    //! Element of an array or member of a map
+    struct Child
+    {
+        std::string key;                //!< Key of a map member, empty for an array element
+        std::size_t node;               //!< Index of the schema of the value
+        bool required;                  //!< Whether the member must be present
+    };
+
+    //! Schema of a single value
+    struct Node
+    {
+        Type type;                      //!< Type of the value
+        bool hasRange;                  //!< Whether numbers are limited to the range
+        double min;                     //!< Smallest number
+        double max;                     //!< Largest number
+        std::size_t minLength;          //!< Smallest length or number of elements or members
+        std::size_t maxLength;          //!< Largest length or number of elements or members
+        std::size_t elements;           //!< Schema of the array elements after the positional elements
+        bool otherMembers;              //!< Whether maps can contain members that aren't in the children
+        std::size_t required;           //!< Number of required children
+        std::vector<Child> children;    //!< Positional array elements or map members
+    };
+
+    explicit ParamSchema(Type type = AnyType);
+
+    //! Limit numbers to the range
+    ParamSchema& Range(double min, double max);
+    //! Limit the length of strings and binary data, or the number of elements or members
+    ParamSchema& Length(std::size_t min, std::size_t max);
+    //! Add the schema of the next array element.  Positional elements are required.
+    ParamSchema& Element(const ParamSchema& schema);
+    //! Set the schema of the array elements after the positional elements, otherwise they are rejected
+    ParamSchema& Elements(const ParamSchema& schema);
+    //! Add a member of a map
+    ParamSchema& Member(const char* key, const ParamSchema& schema, bool required = true);
+    //! Set whether maps can contain members that aren't in the schema
+    ParamSchema& OtherMembers(bool allow = true);
+
+    //! Get the node at the index, the root is at index zero
+    const Node& GetNode(std::size_t index) const { return nodes_[index]; }
+
+    //! Find the member with the key, searching from the hint since keys usually arrive in order
+    /*!
+     *  The hint is updated to the position after the member that was found.
+     *  Returns the position in the children or NoNode if the key isn't a member.
+     */
+    std::size_t FindMember(std::size_t node, const char* key, std::size_t length, std::size_t& hint) const;
+
+private:
+    //! Append the nodes of the schema to the table and return the index of its root
+    std::size_t AddNodes(const ParamSchema& schema);
+    //! Add a child to the root node
+    void AddChild(const char* key, const ParamSchema& schema, bool required);
+
+    std::vector<Node> nodes_;           //!< Table of nodes with the root first
+
+    log_define("AnyRPC.ParamSchema");
+};
+
+//! Handler that checks the parse events against a ParamSchema.
+/*!
+ *  The events are passed on to the target handler, if there is one, so the
+ *  check runs while a Document is created.  A value that doesn't match the
+ *  schema throws AnyRpcErrorInvalidParams, which the reader reports as a parse
+ *  error, so the parsing stops at the first mismatch.
+ */
+class ANYRPC_API SchemaValidator : public Handler
+{
+public:
+    explicit SchemaValidator(Handler* target = 0) : schema_(0), target_(target) { Reset(); }
+    SchemaValidator(const ParamSchema& schema, Handler* target = 0) : schema_(&schema), target_(target) { Reset(); }
+
+    //! Prepare to check another value
+    void Reset();
+    //! Prepare to check another value with the schema
+    void Reset(const ParamSchema& schema) { schema_ = &schema; Reset(); }
+
+    //! Whether the complete value has been checked
+    bool IsComplete() const { return started_ && stack_.empty(); }
+
+    virtual void StartDocument() { if (target_) target_->StartDocument(); }
+    virtual void EndDocument() { if (target_) target_->EndDocument(); }
+    virtual void Null();
+    virtual void BoolTrue();
+    virtual void BoolFalse();
+    virtual void DateTime(time_t dt);
+    virtual void String(const char* str, std::size_t length, bool copy = true);
+    virtual void Binary(const unsigned char* str, std::size_t length, bool copy = true);
+    virtual void Int(int i);
+    virtual void Uint(unsigned u);
+    virtual void Int64(int64_t i64);
+    virtual void Uint64(uint64_t u64);
+    virtual void Float(float f);
+    virtual void Double(double d);
+    virtual void StartMap();
+    virtual void StartMap(std::size_t memberCount);
+    virtual void Key(const char* str, std::size_t length, bool copy = true);
+    virtual void MapSeparator() { if (target_) target_->MapSeparator(); }
+    virtual void EndMap(std::size_t memberCount = 0);
+    virtual void StartArray();
+    virtual void StartArray(std::size_t elementCount);
+    virtual void ArraySeparator() { if (target_) target_->ArraySeparator(); }
+    virtual void EndArray(std::size_t elementCount = 0);
+    virtual void TypedArray(TypedArrayType type, const void* data, std::size_t elementCount);
+
+private:
+    //! Find the node for the next value, NoNode if the value isn't checked
+    std::size_t StartValue();
+    //! Check a value of the type and return its node, NoNode if it isn't checked
+    std::size_t CheckValue(ParamSchema::Type type, std::size_t length = 0);
+    //! Check a number of the type against the range
+    void CheckNumber(ParamSchema::Type type, double d);
+    //! Check the start of a map or array, the count is zero if it isn't known
+    void StartContainer(bool isMap, std::size_t count);
+    //! Check the number of elements or members at the end of a map or array
+    void EndContainer();
+    //! Throw the fault for the value that is being checked
+    void Mismatch(const std::string& reason) const;
+
+    //! Map or array that is being checked
+    struct Frame
+    {
+        std::size_t node;               //!< Schema of the map or array, NoNode if it isn't checked
+        std::size_t count;              //!< Number of elements or members so far
+        std::size_t child;              //!< Position of the last member or element in the children, NoNode if it has none
+        std::size_t hint;               //!< Position to start searching for the next key
+        std::size_t seen;               //!< Start of the flags for the members that have been found
+        std::size_t required;           //!< Number of required members that have been found
+    };
+
+    const ParamSchema* schema_;         //!< Schema being checked
+    Handler* target_;                   //!< Handler to receive the events
+    bool started_;                      //!< Whether the root value has started
+    std::size_t next_;                  //!< Node of the next map member
+    std::vector<Frame> stack_;          //!< Maps and arrays being checked
+    std::vector<char> seen_;            //!< Flags for the members of the maps being checked
+};
+
+//! Handler that checks the params of a request against the schema of its method while it is parsed.
+/*!
+ *  The events are passed on to the target Document.  When the method name is
+ *  found before the params, the params events are sent through a SchemaValidator
+ *  so that an invalid request stops the parsing.  Otherwise the params are checked
+ *  when the method is executed.  Each protocol finds the method and params in its
+ *  request envelope.
+ */
+class ANYRPC_API RequestValidator : public Handler
+{
+public:
+    RequestValidator(Handler& target, MethodManager* manager);
+
+    //! Whether the params were checked against the schema of the method
+    /*!
+     *  A request that repeats the method or params is never validated while it is
+     *  parsed since the method may not be executed with the params that were checked.
+     */
+    bool ParamsValidated() const { return validated_ && !repeated_; }
+
+    virtual void StartDocument() { target_.StartDocument(); }
+    virtual void EndDocument() { target_.EndDocument(); }
+    virtual void Null();
+    virtual void BoolTrue();
+    virtual void BoolFalse();
+    virtual void DateTime(time_t dt);
+    virtual void String(const char* str, std::size_t length, bool copy = true);
+    virtual void Binary(const unsigned char* str, std::size_t length, bool copy = true);
+    virtual void Int(int i);
+    virtual void Uint(unsigned u);
+    virtual void Int64(int64_t i64);
+    virtual void Uint64(uint64_t u64);
+    virtual void Float(float f);
+    virtual void Double(double d);
+    virtual void StartMap();
+    virtual void StartMap(std::size_t memberCount);
+    virtual void Key(const char* str, std::size_t length, bool copy = true);
+    virtual void MapSeparator();
+    virtual void EndMap(std::size_t memberCount = 0);
+    virtual void StartArray();
+    virtual void StartArray(std::size_t elementCount);
+    virtual void ArraySeparator();
+    virtual void EndArray(std::size_t elementCount = 0);
+    virtual void TypedArray(TypedArrayType type, const void* data, std::size_t elementCount);
+
+protected:
+    //! Part of the request envelope
+    enum Part { OtherPart, MethodPart, ParamsPart };
+
+    //! Find the part of the envelope for the value at the position in the request map or array
+    virtual Part EnvelopePart() const = 0;
+
+    bool mapEnvelope_;                  //!< Whether the request is a map
+    std::size_t envelopeSize_;          //!< Number of members or elements in the request, zero if the reader doesn't know
+    std::size_t position_;              //!< Position of the value in the request
+    std::string key_;                   //!< Key of the value in a request map
+
+private:
+    //! Find the handler for the next value
+    Handler& StartValue();
+    //! Find the handler for the start of a map or array
+    Handler& StartContainer(bool isMap, std::size_t count);
+    //! Find the handler for the end of a map or array
+    Handler& EndContainer();
+    //! Stop sending events to the validator once the params are complete
+    void EndValue();
+
+    Handler& target_;                   //!< Handler to receive the events
+    MethodManager* manager_;            //!< Methods with the schemas
+    SchemaValidator validator_;         //!< Validator for the params
+    const ParamSchema* schema_;         //!< Schema of the method, null if it doesn't have one
+    std::size_t depth_;                 //!< Depth of the maps and arrays outside of the params
+    Part part_;                         //!< Part of the envelope for the current value
+    bool active_;                       //!< Whether the params are being sent to the validator
+    bool validated_;                    //!< Whether the params were checked
+    bool methodFound_;                  //!< Whether the envelope had a method
+    bool paramsFound_;                  //!< Whether the envelope had params
+    bool repeated_;                     //!< Whether the envelope repeated the method or params
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_PARAMSCHEMA_H_
@@ -71,6 +71,14 @@ public:
 
     //! Set the maximum number of simultaneous connections that the server can have
     void SetMaxConnections(unsigned maxConnections) { maxConnections_ = maxConnections; }
+    //! Allocate the request values from a per-connection MemoryArena with the given block size, 0 to use malloc
+    /*!
+     *  The arena is reset after each response.  Only the request and response use
+     *  the arena since the methods are executed with the heap, so a method can keep
+     *  the values that it creates.  The params are still in the arena so a method
+     *  must Copy them, not Assign them, to keep them after returning.
+     */
+    void SetArenaBlockSize(std::size_t blockSize) { arenaBlockSize_ = blockSize; }
     //! Bind the server to a point and start listening for clients
     virtual bool BindAndListen(int port, int backlog = 5);
     //! Operate the server for a specified number of milliseconds
@@ -82,7 +90,8 @@ public:
     //! Get the method manager with the list of available methods
     MethodManager* GetMethodManager() { return &manager_; }
     //! Add a handler to the list of supported protocols - mostly for http servers
-    void AddHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType);
+    void AddHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType,
+                    RpcParserFactory* parserFactory=0);
     //! Get the list of handlers - mostly for http servers
     RpcHandlerList& GetRpcHandlerList() { return handlers_; }
 
@@ -107,6 +116,7 @@ protected:
     bool exit_;                 //!< Indication to exit the Work function or Thread
     bool working_;              //!< Inside the work loop
     unsigned maxConnections_;   //!< Maximum number of simultaneous active connections
+    std::size_t arenaBlockSize_;//!< Block size for the connection arenas, 0 if not used
 
     typedef std::list<Connection*> ConnectionList;
     ConnectionList connections_;//!< List of active connections
@@ -0,0 +1,81 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_SHAREDVALUE_H_
+#define ANYRPC_SHAREDVALUE_H_
+
+#if defined(ANYRPC_THREADING)
+# include <atomic>
+#endif //defined(ANYRPC_THREADING)
+
+namespace anyrpc
+{
+
+//! Immutable Value that can be referenced from many Value trees without copying
+/*!
+ *  The SharedValue holds a private copy of the data that can't be modified.
+ *  A Value references it with Value::SetShared, and copying that Value only
+ *  adds a reference instead of copying the data.  Writers traverse the
+ *  referenced data as if it was part of the tree.
+ *
+ *  The SharedValue is deleted when the last Value that references it is
+ *  destroyed.  When threading is enabled the reference count is atomic so
+ *  the same SharedValue can be used by several server threads at once.
+ *
+ *  Value shared;
+ *  shared.SetShared(new SharedValue(config));
+ *  result.Copy(shared);        // only adds a reference
+ */
+class ANYRPC_API SharedValue
+{
+public:
+    //! Create the shared data from a copy of the value
+    explicit SharedValue(const Value& value);
+
+    //! Get the shared data
+    const Value& GetValue() const { return value_; }
+    //! Number of Values that reference the shared data
+    unsigned GetRefCount() const { return refCount_; }
+
+    //! Add a reference to the shared data
+    void AddRef() { ++refCount_; }
+    //! Remove a reference and delete the object when there are none left
+    void Release() { if (--refCount_ == 0) delete this; }
+
+private:
+    log_define("AnyRPC.SharedValue");
+
+    // Only deleted by Release
+    ~SharedValue() {}
+    // Prohibit copy constructor & assignment operator.
+    SharedValue(const SharedValue&);
+    SharedValue& operator=(const SharedValue&);
+
+    Value value_;                           //!< Data that is shared
+#if defined(ANYRPC_THREADING)
+    std::atomic<unsigned> refCount_;        //!< Number of Values that reference the data
+#else
+    unsigned refCount_;                     //!< Number of Values that reference the data
+#endif //defined(ANYRPC_THREADING)
+};
+
+} // namespace anyrpc
+
+#endif // ANYRPC_SHAREDVALUE_H_
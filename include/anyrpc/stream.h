@@ -53,6 +53,10 @@ public:
     virtual std::size_t Read(char* /* ptr */ , std::size_t /* length */) { anyrpc_assert(false,AnyRpcErrorIllegalCall,"Illegal call"); return 0; }
     //! Skip forward up to length characters.  Return the number of characters skipped.
     virtual std::size_t Skip(std::size_t /* length */) { anyrpc_assert(false,AnyRpcErrorIllegalCall,"Illegal call"); return 0; }
+    //! Return the unread data if it is in a contiguous buffer and set the length.  Return null if the data must be read with Get.
+    virtual const char* PeekBuffer(std::size_t& length) const { length = 0; return 0; }
+    //! Move forward over data that was returned by PeekBuffer.
+    virtual void Advance(std::size_t /* length */) { anyrpc_assert(false,AnyRpcErrorIllegalCall,"Illegal call"); }
 
     //! Mark the current position as the destination.  Used with InSitu processing.
     virtual char* PutBegin() { anyrpc_assert(false,AnyRpcErrorIllegalCall,"Illegal call"); return 0; }
@@ -66,6 +70,11 @@ public:
     virtual void Put(const char * /* str */, std::size_t /* n */) {}
     //! Reset the mark for putting characters in the stream with InSitu processing.
     virtual std::size_t PutEnd() { anyrpc_assert(false,AnyRpcErrorIllegalCall,"Illegal call"); return 0; }
+    //! Return space for up to length characters at the end of the stream.  Return null if the stream doesn't buffer the data.
+    //! The characters are only added to the stream by Commit and any other call on the stream invalidates the space.
+    virtual char* Reserve(std::size_t /* length */) { return 0; }
+    //! Add length characters that were written to the space from Reserve to the stream.
+    virtual void Commit(std::size_t /* length */) { anyrpc_assert(false,AnyRpcErrorIllegalCall,"Illegal call"); }
 
     //! Return the current character position in a read stream. Used to indicate the position of an error.
     virtual std::size_t Tell() const { return 0; }
@@ -78,6 +87,41 @@ protected:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+//! StreamReservation is space to format a short item for a stream.
+//! The item is written directly in the stream buffer when the stream supports Reserve
+//! and otherwise in a local buffer that is added with a single Put call.
+
+template <std::size_t Size>
+class StreamReservation
+{
+public:
+    StreamReservation(Stream& os) : os_(os)
+    {
+        buffer_ = os.Reserve(Size);
+        if (!buffer_)
+            buffer_ = local_;
+    }
+
+    //! Start of the space for the item
+    char* Begin() { return buffer_; }
+    //! Add the characters up to end to the stream
+    void Commit(const char* end)
+    {
+        std::size_t length = static_cast<std::size_t>(end - buffer_);
+        if (buffer_ == local_)
+            os_.Put(local_, length);
+        else
+            os_.Commit(length);
+    }
+
+private:
+    Stream& os_;
+    char* buffer_;
+    char local_[Size];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 //! StdOutStream provides a more direct way to send data to stdout without
 //! needing to use WriteFileStream.
 //! This class does not buffer any data so there is no need to flush the stream
@@ -137,6 +181,8 @@ public:
     virtual void Put(const char *str) { Put(str,strlen(str)); }
     virtual void Put(const std::string &str) { Put(str.c_str(),str.length()); }
     virtual void Put(const char *str, std::size_t n);
+    virtual char* Reserve(std::size_t length);
+    virtual void Commit(std::size_t length);
 
     virtual void Flush();
 
@@ -231,6 +277,8 @@ public:
     virtual char GetClear();
     virtual std::size_t Read(char* ptr, std::size_t length);
     virtual std::size_t Skip(std::size_t length);
+    virtual const char* PeekBuffer(std::size_t& length) const { length = static_cast<std::size_t>(eof_ - src_); return src_; }
+    virtual void Advance(std::size_t length) { src_ += std::min(static_cast<std::size_t>(eof_ - src_), length); }
     virtual char* PutBegin();
     virtual void Put(char c);
     virtual void Put(const char *str) { Put(str,strlen(str));}
@@ -277,13 +325,20 @@ public:
 class ANYRPC_API WriteStringStream : public WriteBufferedStream
 {
 public:
-    WriteStringStream() {}
-    WriteStringStream(std::size_t reserveSize) { str_.reserve(reserveSize); }
+    WriteStringStream() : reserved_(0) {}
+    WriteStringStream(std::size_t reserveSize) : reserved_(0) { str_.reserve(reserveSize); }
 
     virtual void Put(char c) { str_.push_back(c); }
     virtual void Put(const char *str) { str_.append(str); }
     virtual void Put(const std::string &str) { str_.append(str); }
     virtual void Put(const char *str, std::size_t n) { str_.append(str, n); }
+    virtual char* Reserve(std::size_t length)
+    {
+        reserved_ = str_.length();
+        str_.resize(reserved_ + length);
+        return &str_[reserved_];
+    }
+    virtual void Commit(std::size_t length) { str_.resize(reserved_ + length); }
 
     virtual const char* GetBuffer(std::size_t offset, std::size_t& segmentLength)
     {
@@ -303,6 +358,7 @@ public:
 
 private:
     std::string str_;
+    std::size_t reserved_;          //!< Length of the string before the space from Reserve
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -325,13 +381,15 @@ public:
     virtual void Put(const char *str) { Put(str,strlen(str));}
     virtual void Put(const std::string &str) { Put(str.c_str(),str.length()); }
     virtual void Put(const char *str, std::size_t n);
+    virtual char* Reserve(std::size_t length);
+    virtual void Commit(std::size_t length);
 
     virtual const char* GetBuffer(std::size_t offset, std::size_t& segmentLength);
     virtual std::size_t Length() { return length_; }
     virtual void Clear();
 
 private:
-    void AddBuffer();
+    void AddBuffer(std::size_t minCapacity=0);
 
     struct BufferSegment
     {
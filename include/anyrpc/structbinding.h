@@ -0,0 +1,440 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef ANYRPC_STRUCTBINDING_H_
+#define ANYRPC_STRUCTBINDING_H_
+
+#include <limits>
+
+namespace anyrpc
+{
+
+class StructType;
+
+//! Description of how a C++ type is read from parse events and written to a handler.
+/*!
+ *  The FieldType functions receive a pointer to the C++ object.  The default
+ *  functions reject the event as a type mismatch, so each type only overrides
+ *  the events that it accepts.  A null event leaves the object unchanged.
+ */
+class ANYRPC_API FieldType
+{
+public:
+    virtual ~FieldType() {}
+
+    //! Name of the type used in error messages
+    virtual const char* Name() const = 0;
+
+    //!@name Value Member Functions
+    //@{
+    virtual void Null(void* /* object */) const {}
+    virtual void Bool(void* /* object */, bool /* b */) const { TypeMismatch("bool"); }
+    virtual void Int64(void* /* object */, int64_t /* i64 */) const { TypeMismatch("integer"); }
+    virtual void Uint64(void* /* object */, uint64_t /* u64 */) const { TypeMismatch("integer"); }
+    virtual void Double(void* /* object */, double /* d */) const { TypeMismatch("double"); }
+    virtual void String(void* /* object */, const char* /* str */, std::size_t /* length */) const { TypeMismatch("string"); }
+    //@}
+
+    //!@name Container Member Functions
+    //@{
+    //! Struct types return their description, other types return null
+    virtual const StructType* GetStructType() const { return 0; }
+    //! Array types return the type of the elements, other types return null
+    virtual const FieldType* GetElementType() const { return 0; }
+    //! Clear the array and reserve space for the expected elements
+    virtual void StartArray(void* /* object */, std::size_t /* elementCount */) const {}
+    //! Add an element to the end of the array and return a pointer to it
+    virtual void* AppendElement(void* /* object */) const { return 0; }
+    //@}
+
+    //! Write the object as events to the handler
+    virtual void Write(const void* object, Handler& handler) const = 0;
+
+protected:
+    //! Throw the fault for an event that the type doesn't accept
+    void TypeMismatch(const char* found) const;
+
+    log_define("AnyRPC.FieldType");
+};
+
+//! Access to a member of a struct from a pointer to the struct
+class ANYRPC_API FieldAccess
+{
+public:
+    FieldAccess(const FieldType& type) : type_(type) {}
+    virtual ~FieldAccess() {}
+
+    const FieldType& GetType() const { return type_; }
+    virtual void* Get(void* object) const = 0;
+    virtual const void* Get(const void* object) const = 0;
+
+private:
+    const FieldType& type_;             //!< Type of the member
+};
+
+//! A StructType describes the fields of a struct that are read from and written to a map.
+/*!
+ *  Keys that are not fields are skipped when reading and fields that are missing
+ *  from the map keep their value.  The fields are written in the order they were added.
+ */
+class ANYRPC_API StructType : public FieldType
+{
+public:
+    StructType(const char* name) : name_(name) {}
+    virtual ~StructType();
+
+    virtual const char* Name() const { return name_; }
+    virtual const StructType* GetStructType() const { return this; }
+    virtual void Write(const void* object, Handler& handler) const;
+
+    //! Number of fields
+    std::size_t GetSize() const { return fields_.size(); }
+
+    //! Find the field with the key, searching from the hint since keys usually arrive in order
+    /*!
+     *  The hint is updated to the position after the field that was found.
+     *  Returns null if the key is not a field.
+     */
+    const FieldAccess* FindField(const char* key, std::size_t length, std::size_t& hint) const;
+
+protected:
+    //! Add a field, taking ownership of the access object
+    void AddFieldAccess(const char* name, FieldAccess* access);
+    //! Keep a type that was created for a field, the StructType deletes it
+    const FieldType& AddOwnedType(FieldType* type);
+
+private:
+    //! Definition of a field in the struct
+    struct Field
+    {
+        std::string name;               //!< Key of the field in the map
+        FieldAccess* access;            //!< Access to the member of the struct
+    };
+
+    const char* name_;                  //!< Name of the struct used in error messages
+    std::vector<Field> fields_;         //!< Fields in the order they are written
+    std::vector<FieldType*> ownedTypes_;//!< Types created for fields such as arrays of structs
+
+    // Prohibit copy constructor & assignment operator.
+    StructType(const StructType&);
+    StructType& operator=(const StructType&);
+};
+
+namespace internal
+{
+
+//! Field type for bool members
+class ANYRPC_API BoolFieldType : public FieldType
+{
+public:
+    virtual const char* Name() const { return "bool"; }
+    virtual void Bool(void* object, bool b) const { *static_cast<bool*>(object) = b; }
+    virtual void Write(const void* object, Handler& handler) const
+    {
+        if (*static_cast<const bool*>(object))
+            handler.BoolTrue();
+        else
+            handler.BoolFalse();
+    }
+};
+
+//! Field type for integer members, values that don't fit the member are rejected
+template <typename T>
+class IntegerFieldType : public FieldType
+{
+public:
+    virtual const char* Name() const { return "integer"; }
+    virtual void Int64(void* object, int64_t i64) const
+    {
+        if ((i64 < 0) && !std::numeric_limits<T>::is_signed)
+            TypeMismatch("negative integer");
+        if ((i64 > 0) && (static_cast<uint64_t>(i64) > static_cast<uint64_t>(std::numeric_limits<T>::max())))
+            TypeMismatch("large integer");
+        if (std::numeric_limits<T>::is_signed && (i64 < static_cast<int64_t>(std::numeric_limits<T>::min())))
+            TypeMismatch("large integer");
+        *static_cast<T*>(object) = static_cast<T>(i64);
+    }
+    virtual void Uint64(void* object, uint64_t u64) const
+    {
+        if (u64 > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+            TypeMismatch("large integer");
+        *static_cast<T*>(object) = static_cast<T>(u64);
+    }
+    virtual void Write(const void* object, Handler& handler) const
+    {
+        T value = *static_cast<const T*>(object);
+        if (std::numeric_limits<T>::is_signed)
+        {
+            if (sizeof(T) <= sizeof(int))
+                handler.Int(static_cast<int>(value));
+            else
+                handler.Int64(static_cast<int64_t>(value));
+        }
+        else
+        {
+            if (sizeof(T) <= sizeof(unsigned))
+                handler.Uint(static_cast<unsigned>(value));
+            else
+                handler.Uint64(static_cast<uint64_t>(value));
+        }
+    }
+};
+
+//! Field type for float and double members, integers are converted
+template <typename T>
+class RealFieldType : public FieldType
+{
+public:
+    virtual const char* Name() const { return "double"; }
+    virtual void Int64(void* object, int64_t i64) const { *static_cast<T*>(object) = static_cast<T>(i64); }
+    virtual void Uint64(void* object, uint64_t u64) const { *static_cast<T*>(object) = static_cast<T>(u64); }
+    virtual void Double(void* object, double d) const { *static_cast<T*>(object) = static_cast<T>(d); }
+    virtual void Write(const void* object, Handler& handler) const
+    {
+        if (sizeof(T) == sizeof(float))
+            handler.Float(static_cast<float>(*static_cast<const T*>(object)));
+        else
+            handler.Double(static_cast<double>(*static_cast<const T*>(object)));
+    }
+};
+
+//! Field type for std::string members
+class ANYRPC_API StringFieldType : public FieldType
+{
+public:
+    virtual const char* Name() const { return "string"; }
+    virtual void String(void* object, const char* str, std::size_t length) const
+    {
+        static_cast<std::string*>(object)->assign(str, length);
+    }
+    virtual void Write(const void* object, Handler& handler) const
+    {
+        const std::string* str = static_cast<const std::string*>(object);
+        handler.String(str->data(), str->length());
+    }
+};
+
+//! Field type for std::vector members with elements of the given type
+/*!
+ *  std::vector<bool> is not supported since its elements can't be addressed.
+ */
+template <typename T>
+class VectorFieldType : public FieldType
+{
+public:
+    VectorFieldType(const FieldType& elementType) : elementType_(elementType) {}
+
+    virtual const char* Name() const { return "array"; }
+    virtual const FieldType* GetElementType() const { return &elementType_; }
+    virtual void StartArray(void* object, std::size_t elementCount) const
+    {
+        std::vector<T>* v = static_cast<std::vector<T>*>(object);
+        v->clear();
+        v->reserve(elementCount);
+    }
+    virtual void* AppendElement(void* object) const
+    {
+        std::vector<T>* v = static_cast<std::vector<T>*>(object);
+        v->push_back(T());
+        return &v->back();
+    }
+    virtual void Write(const void* object, Handler& handler) const
+    {
+        const std::vector<T>* v = static_cast<const std::vector<T>*>(object);
+        std::size_t size = v->size();
+        handler.StartArray(size);
+        for (std::size_t i=0; i<size; i++)
+        {
+            elementType_.Write(&(*v)[i], handler);
+            if (i != (size-1))
+                handler.ArraySeparator();
+        }
+        handler.EndArray(size);
+    }
+
+private:
+    const FieldType& elementType_;      //!< Type of each element
+};
+
+//! Access to a member using a pointer to member
+template <typename S, typename M>
+class MemberAccess : public FieldAccess
+{
+public:
+    MemberAccess(M S::*member, const FieldType& type) : FieldAccess(type), member_(member) {}
+
+    virtual void* Get(void* object) const { return &(static_cast<S*>(object)->*member_); }
+    virtual const void* Get(const void* object) const { return &(static_cast<const S*>(object)->*member_); }
+
+private:
+    M S::*member_;                      //!< Member of the struct
+};
+
+} // namespace internal
+
+//! Get the field type of a C++ type that doesn't need a description
+/*!
+ *  The types are bool, the integer types, float, double, std::string,
+ *  and std::vector of these types.  Structs use a StructDescriptor.
+ */
+template <typename T> struct FieldTypeOf;
+
+#define ANYRPC_FIELD_TYPE_OF(T, FieldTypeClass) \
+    template <> struct FieldTypeOf<T> \
+    { \
+        static const FieldType& Get() { static const FieldTypeClass type; return type; } \
+    }
+
+ANYRPC_FIELD_TYPE_OF(bool, internal::BoolFieldType);
+ANYRPC_FIELD_TYPE_OF(int, internal::IntegerFieldType<int>);
+ANYRPC_FIELD_TYPE_OF(unsigned, internal::IntegerFieldType<unsigned>);
+ANYRPC_FIELD_TYPE_OF(int64_t, internal::IntegerFieldType<int64_t>);
+ANYRPC_FIELD_TYPE_OF(uint64_t, internal::IntegerFieldType<uint64_t>);
+ANYRPC_FIELD_TYPE_OF(float, internal::RealFieldType<float>);
+ANYRPC_FIELD_TYPE_OF(double, internal::RealFieldType<double>);
+ANYRPC_FIELD_TYPE_OF(std::string, internal::StringFieldType);
+
+#undef ANYRPC_FIELD_TYPE_OF
+
+template <typename T> struct FieldTypeOf<std::vector<T> >
+{
+    static const FieldType& Get() { static const internal::VectorFieldType<T> type(FieldTypeOf<T>::Get()); return type; }
+};
+
+//! Description of the fields of the struct S
+/*!
+ *  The fields are added once, typically when the application starts, and the
+ *  descriptor is then used to read and write any number of structs.
+ *
+ *  struct Point { double x; double y; std::string label; };
+ *  StructDescriptor<Point> pointType("Point");
+ *  pointType.AddField("x", &Point::x).AddField("y", &Point::y).AddField("label", &Point::label);
+ *
+ *  StructReader structReader(pointType, point);
+ *  reader >> structReader;             // JsonReader, XmlReader, or MessagePackReader
+ *  WriteStruct(writer, pointType, point);
+ */
+template <typename S>
+class StructDescriptor : public StructType
+{
+public:
+    StructDescriptor(const char* name) : StructType(name) {}
+
+    //! Add a member with a type from FieldTypeOf
+    template <typename M>
+    StructDescriptor& AddField(const char* name, M S::*member)
+    {
+        AddFieldAccess(name, new internal::MemberAccess<S,M>(member, FieldTypeOf<M>::Get()));
+        return *this;
+    }
+
+    //! Add a member that is a struct
+    template <typename M>
+    StructDescriptor& AddField(const char* name, M S::*member, const StructDescriptor<M>& type)
+    {
+        AddFieldAccess(name, new internal::MemberAccess<S,M>(member, type));
+        return *this;
+    }
+
+    //! Add a member that is an array of structs
+    template <typename M>
+    StructDescriptor& AddField(const char* name, std::vector<M> S::*member, const StructDescriptor<M>& elementType)
+    {
+        const FieldType& type = AddOwnedType(new internal::VectorFieldType<M>(elementType));
+        AddFieldAccess(name, new internal::MemberAccess<S,std::vector<M> >(member, type));
+        return *this;
+    }
+
+    //! Add a member with an application defined type
+    template <typename M>
+    StructDescriptor& AddField(const char* name, M S::*member, const FieldType& type)
+    {
+        AddFieldAccess(name, new internal::MemberAccess<S,M>(member, type));
+        return *this;
+    }
+};
+
+//! Handler that fills a struct directly from the reader events without creating a Value.
+/*!
+ *  The events are matched to the fields of the StructDescriptor.  Keys that are not
+ *  fields are skipped along with their values.  A value that doesn't match the type
+ *  of the field throws AnyRpcErrorInvalidParams, which the reader reports as a parse error.
+ */
+class ANYRPC_API StructReader : public Handler
+{
+public:
+    //! Read into an object described by the type
+    StructReader(const FieldType& type, void* object) : rootType_(&type), root_(object) { Reset(); }
+    template <typename S>
+    StructReader(const StructDescriptor<S>& type, S& object) : rootType_(&type), root_(&object) { Reset(); }
+
+    //! Prepare to read another document into the object
+    void Reset();
+
+    virtual void Null();
+    virtual void BoolTrue();
+    virtual void BoolFalse();
+    virtual void DateTime(time_t dt);
+    virtual void String(const char* str, std::size_t length, bool copy = true);
+    virtual void Binary(const unsigned char* str, std::size_t length, bool copy = true);
+    virtual void Int(int i);
+    virtual void Uint(unsigned u);
+    virtual void Int64(int64_t i64);
+    virtual void Uint64(uint64_t u64);
+    virtual void Double(double d);
+    virtual void StartMap();
+    virtual void Key(const char* str, std::size_t length, bool copy = true);
+    virtual void EndMap(std::size_t memberCount = 0);
+    virtual void StartArray();
+    virtual void StartArray(std::size_t elementCount);
+    virtual void EndArray(std::size_t elementCount = 0);
+
+private:
+    //! Find the type and object for the next value, returns false if the value is skipped
+    bool NextTarget(const FieldType*& type, void*& object);
+    void StartArrayInternal(std::size_t elementCount);
+
+    //! Map or array that is being read
+    struct Frame
+    {
+        const FieldType* type;          //!< Type of the map or array
+        void* object;                   //!< Object that is being read
+        const FieldType* memberType;    //!< Type of the field for the last key, null to skip the value
+        void* member;                   //!< Field for the last key
+        std::size_t hint;               //!< Position to start searching for the next key
+    };
+
+    const FieldType* rootType_;         //!< Type of the object being read
+    void* root_;                        //!< Object being read
+    bool rootStarted_;                  //!< Whether the root value has been read
+    std::size_t skipDepth_;             //!< Depth of the maps and arrays being skipped
+    std::vector<Frame> stack_;          //!< Maps and arrays being read
+};
+
+//! Write the struct as events to the handler, normally a writer
+template <typename S>
+void WriteStruct(Handler& handler, const StructDescriptor<S>& type, const S& object)
+{
+    type.Write(&object, handler);
+}
+
+} // namespace anyrpc
+
+#endif // ANYRPC_STRUCTBINDING_H_
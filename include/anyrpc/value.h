@@ -37,12 +37,26 @@ enum ANYRPC_API ValueType
     NumberType,
     DateTimeType,
     BinaryType,
+    SharedType,
     ValueTypeSize
 };
 
+//! Element type of a typed array
+enum ANYRPC_API TypedArrayType
+{
+    TypedNone,
+    TypedInt32,
+    TypedInt64,
+    TypedFloat,
+    TypedDouble,
+    TypedUint8,
+    TypedArrayTypeSize
+};
+
 // forward declarations
 struct Member;
 class Handler;
+class SharedValue;
 class MemberIterator;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -55,6 +69,11 @@ class MemberIterator;
  *  object.  The base value object will occupy 16 bytes on a 32-bit architecture
  *  and 24 bytes on a 64-bit architecture.
  *
+ *  When ANYRPC_PACKED_VALUE is defined, the value object also occupies 16 bytes on
+ *  a 64-bit architecture.  The map and array pointers are stored in 48 bits with the
+ *  capacity in the remaining 16 bits, strings are limited to 4GB, and short strings
+ *  are limited to 11 characters.  Large capacities are rounded up to a multiple of 1024.
+ *
  *  Map and Array types have a separate allocation to store the individual elements
  *  that are needed for the type.
  *
@@ -62,6 +81,10 @@ class MemberIterator;
  *  storage for a separate copy of the data, or reference the data.  If the data is
  *  referenced, then it is not freed on exit and must be maintained external to the
  *  value object.
+ *
+ *  When a MemoryArena is current for the thread, new storage for maps, arrays, and
+ *  copied strings is taken from the arena instead of malloc.  This storage is released
+ *  when the arena is reset so the value must be destroyed before then.
  */
 class ANYRPC_API Value
 {
@@ -72,6 +95,10 @@ public:
     Value();
     //! Copy constructor will duplicate the value structure.
     Value(const Value& rhs);
+#if ANYRPC_HAS_RVALUE_REFS
+    //! Move constructor takes the value structure.  The rhs will be null after.
+    Value(Value&& rhs) noexcept : data_(rhs.data_), flags_(rhs.flags_) { rhs.flags_ = NullFlag; }
+#endif
     //! Constructor for a specific value type with default content.
     explicit Value(ValueType type);
     //! Constructor for a boolean value type.
@@ -114,6 +141,9 @@ public:
     //!@name Assignment Operators
     //@{
     Value& operator=(const Value& rhs);
+#if ANYRPC_HAS_RVALUE_REFS
+    Value& operator=(Value&& rhs) noexcept { Assign(rhs); return *this; }
+#endif
     Value& operator=(bool b);
     Value& operator=(int i);
     Value& operator=(unsigned u);
@@ -150,6 +180,8 @@ public:
     inline bool IsString()      const { return (flags_ & StringFlag) != 0; }
     inline bool IsDateTime()    const { return flags_ == DateTimeType; }
     inline bool IsBinary()      const { return (flags_ & BinaryFlag) != 0; }
+    inline bool IsShared()      const { return GetType() == SharedType; }
+    inline bool IsInterned()    const { return (flags_ & InternedFlag) != 0; }
     //@}
 
     //!@name Invalid Member Functions
@@ -171,7 +203,10 @@ public:
     //!@name Map Member Functions
     //! A map associates a string (key) with a value.  The value can be any type.
     //! The keys should be unique although this is not verified.
-    //! The current implementation searches the keys sequentially.
+    //! Small maps search the keys sequentially.  Larger maps build a hash index
+    //! in the member allocation on the first search and index new members as needed.
+    //! If keys are duplicated, the first member with the key is found.
+    //! Keys that are in the KeyTable reference the interned string and are compared by pointer.
     //! The AddMember functions return a reference to the value of the newly added member.
     //@{
     //! Set the object to be a map type.
@@ -184,6 +219,18 @@ public:
     Value& AddMember(const char* str, Value& value, bool copy=true) { return AddMember(str, strlen(str), value, copy); }
     //! Add member with string key and value.
     Value& AddMember(const std::string& str, Value& value) { return AddMember(str.c_str(), str.length(), value); }
+#if ANYRPC_HAS_RVALUE_REFS
+    //! Add member with key and value.  The key must be a String.  The value is moved into the map.
+    Value& AddMember(Value& key, Value&& value, bool copy=true);
+    //! Add member with key and value.  The key must be a String.  Both are moved into the map.
+    Value& AddMember(Value&& key, Value&& value) { return AddMember(key, std::move(value), false); }
+    //! Add member with string key and value.  The value is moved into the map.
+    Value& AddMember(const char* str, std::size_t length, Value&& value, bool copy=true);
+    //! Add member with string key and value.  The value is moved into the map.
+    Value& AddMember(const char* str, Value&& value, bool copy=true) { return AddMember(str, strlen(str), std::move(value), copy); }
+    //! Add member with string key and value.  The value is moved into the map.
+    Value& AddMember(const std::string& str, Value&& value) { return AddMember(str.c_str(), str.length(), std::move(value)); }
+#endif
     //! Add member with key.  The key must be a String.  The value will be invalid until assigned.
     Value& AddMember(Value& key, bool copy=true);
     //! Add member with string key.  The value will be invalid until assigned.
@@ -206,6 +253,23 @@ public:
     std::size_t MemberCount() const { anyrpc_assert(IsMap(), AnyRpcErrorValueAccess, "Not Map, type=" << GetType()); return data_.m.size; }
     //! Return whether the map has zero members.
     bool IsMapEmpty() const { anyrpc_assert(IsMap(), AnyRpcErrorValueAccess, "NotMap, type=" << GetType()); return data_.m.size == 0; }
+    //! Get the value of the member with the given key without adding it.  NULL is returned if the key is not found or this is not a map.
+    const Value* Get(const char* str) const;
+    //! Get the value of the member with the given key without adding it.  NULL is returned if the key is not found or this is not a map.
+    Value* Get(const char* str) { return const_cast<Value*>(static_cast<const Value*>(this)->Get(str)); }
+    //! Get the value of the member with the given key without adding it.  NULL is returned if the key is not found or this is not a map.
+    const Value* Get(const std::string& str) const { return Get(str.c_str()); }
+    //! Get the value of the member with the given key without adding it.  NULL is returned if the key is not found or this is not a map.
+    Value* Get(const std::string& str) { return Get(str.c_str()); }
+    //! Get the values for several keys with a single pass through the members.
+    /*!
+     *  Each of the values is set to the member value or NULL if the key is not found.
+     *  Returns the number of keys that were found.
+     */
+    std::size_t GetMembers(const char* const keys[], std::size_t count, const Value* values[]) const;
+    //! Get the values for several keys with a single pass through the members.
+    std::size_t GetMembers(const char* const keys[], std::size_t count, Value* values[])
+        { return GetMembers(keys, count, const_cast<const Value**>(values)); }
     //! Access member with the given string key.  If the key is not found, create a new entry with an invalid value.
     Value& operator[](const char* str);
     //! Access member with the given string key.  If the key is not found, create a new entry with an invalid value.
@@ -251,7 +315,7 @@ public:
     //! Return the current size of the array.  This is the number of active elements.
     std::size_t Size() const { anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType()); return data_.a.size; }
     //! Return the current capacity of the array.  This is the number of allocated elements.
-    std::size_t Capacity() const { anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType()); return data_.a.capacity; }
+    std::size_t Capacity() const { anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType()); return data_.a.GetCapacity(); }
     //! Return whether the array has a size of zero.
     bool IsArrayEmpty() const { anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType()); return data_.a.size == 0; }
     //! Set the array size to zero.
@@ -270,6 +334,47 @@ public:
     Value& SetSize(std::size_t newSize);
     //! Add a new value to the end of the array increasing the size by one.
     Value& PushBack(Value& value);
+#if ANYRPC_HAS_RVALUE_REFS
+    //! Add a new value to the end of the array increasing the size by one.
+    Value& PushBack(Value&& value) { return PushBack(value); }
+#endif
+    //@}
+
+    //!@name Typed Array Member Functions
+    //! A typed array is an array that stores numbers of a single type contiguously
+    //! instead of as individual values.  It is still an ArrayType and the size functions
+    //! can be used directly.  Functions that access or add elements as values will
+    //! first convert it to a standard array.
+    //! Traversing a typed array uses a single Handler::TypedArray call.
+    //@{
+    //! Set the object to be a typed array with the given number of elements set to zero.
+    Value& SetTypedArray(TypedArrayType type, std::size_t size);
+    //! Set the object to be a typed array with a copy of the data.
+    Value& SetTypedArray(TypedArrayType type, const void* data, std::size_t size);
+    //! Whether the array stores its elements as a typed array
+    bool IsTypedArray() const { return (flags_ & TypedArrayMask) != 0; }
+    //! Get the type of the elements of a typed array
+    TypedArrayType GetTypedArrayType() const { return static_cast<TypedArrayType>((flags_ & TypedArrayMask) >> TypedArrayShift); }
+    //! Get the element data of a typed array.  The size is given by Size().
+    void* GetTypedArrayData() { anyrpc_assert(IsTypedArray(), AnyRpcErrorValueAccess, "Not typed array, type=" << GetType()); return data_.a.GetElements(); }
+    //! Get the element data of a typed array.  The size is given by Size().
+    const void* GetTypedArrayData() const { anyrpc_assert(IsTypedArray(), AnyRpcErrorValueAccess, "Not typed array, type=" << GetType()); return data_.a.GetElements(); }
+    //! Convert an array with numbers that are all the same type to a typed array.  Returns false if it can't be converted.
+    bool PackTypedArray();
+    //! Convert a typed array to a standard array of values.
+    Value& ExpandTypedArray();
+    //! Number of bytes for each element of the typed array type
+    static std::size_t TypedArrayElementSize(TypedArrayType type);
+    //@}
+
+    //!@name Shared Value Member Functions
+    //! A shared value references the immutable data of a SharedValue.  Copying it
+    //! only adds a reference and traversing it traverses the referenced data.
+    //@{
+    //! Set the object to reference the shared value
+    Value& SetShared(SharedValue* shared);
+    //! Get the data that is referenced
+    const Value& GetShared() const;
     //@}
 
     //!@name Number Member Functions
@@ -362,6 +467,9 @@ private:
         CopyFlag       = 0x00200000,   //!< String must be copied to clone - either short string or malloced space
         InlineStrFlag  = 0x00400000,   //!< Short string - access with data_.ss.str
         BinaryFlag     = 0x00800000,   //!< Is binary data - either short or standard
+        ArenaFlag      = 0x01000000,   //!< Allocated space belongs to a MemoryArena and isn't freed
+        InternedFlag   = 0x02000000,   //!< String references a key in the KeyTable - access with data_.s
+        TypedArrayMask = 0x000F0000,   //!< Element type of a typed array - access with data_.a
     };
 
     enum ValueCompositeFlags
@@ -378,6 +486,7 @@ private:
         NumberDoubleFlag   = NumberType | NumberFlag | FloatFlag | DoubleFlag,
         NumberAnyFlag      = NumberType | NumberFlag | IntFlag | Int64Flag | UintFlag | Uint64Flag | FloatFlag | DoubleFlag,
         ConstStringFlag    = StringType | StringFlag,
+        InternedStringFlag = StringType | StringFlag | InternedFlag,
         CopyStringFlag     = StringType | StringFlag | CopyFlag,
         ShortStringFlag    = StringType | StringFlag | CopyFlag | InlineStrFlag,
         ConstBinaryFlag    = BinaryType | BinaryFlag,
@@ -385,20 +494,34 @@ private:
         ShortBinaryFlag    = BinaryType | BinaryFlag | CopyFlag | InlineStrFlag,
         MapFlag            = MapType,
         ArrayFlag          = ArrayType,
+        SharedFlag         = SharedType,
     };
 
     static const int TypeMask = 0xFF;
+    static const int TypedArrayShift = 16;
 
     static const std::size_t    DefaultArrayCapacity    = 16;
     static const std::size_t    MaxArrayCapacity        = 16*1024*1024;     // must be less than 2^32 / sizeof(Value) on 32-bit compilation
     static const uint32_t       DefaultMapCapacity      = 16;
     static const uint32_t       MaxMapCapacity          = 16*1024*1024;     // must be less than 2^32 / sizeof(Member) on 32-bit compilation
+    static const uint32_t       HashIndexMinCapacity    = 32;               // maps with less capacity are searched sequentially
+#if defined(ANYRPC_PACKED_VALUE)
+    static const uint64_t       PointerMask             = ANYRPC_UINT64_C2(0x0000FFFF, 0xFFFFFFFF);
+#endif
+
+#if defined(ANYRPC_PACKED_VALUE)
+# pragma pack(push, 4)
+#endif
 
-    //! Allocated or referenced string, part of Data union: 8 bytes in 32-bit mode, 16 bytes in 64-bit mode
+    //! Allocated or referenced string, part of Data union: 8 bytes in 32-bit mode, 16 bytes in 64-bit mode, 12 bytes packed
     struct String
     {
         const char* str;
+#if defined(ANYRPC_PACKED_VALUE)
+        uint32_t length;
+#else
         std::size_t length;
+#endif
     };
 
     // implementation detail: ShortString can represent zero-terminated strings up to MaxSize chars
@@ -463,23 +586,52 @@ private:
         double d;
     };
 
-    //! Map type, part of Data union: 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
-    struct Map
+#if defined(ANYRPC_PACKED_VALUE)
+    //! Map or array storage, part of Data union: 12 bytes packed
+    /*!
+     *  The pointer uses the lower 48 bits and the capacity code uses the upper 16 bits.
+     *  Capacities below 32768 are stored directly, larger ones in units of 1024.
+     */
+    template <typename T>
+    struct Elements
     {
-        Member* members;
+        T* GetElements() const { return reinterpret_cast<T*>(static_cast<uintptr_t>(bits & PointerMask)); }
+        void SetElements(T* elements)
+        {
+            anyrpc_assert((reinterpret_cast<uintptr_t>(elements) & ~PointerMask) == 0, AnyRpcErrorMemoryAllocation,
+                          "Element pointer doesn't fit in 48 bits for the packed value");
+            bits = (bits & ~PointerMask) | reinterpret_cast<uintptr_t>(elements);
+        }
+        uint32_t GetCapacity() const
+            { uint32_t code = static_cast<uint32_t>(bits >> 48); return (code < 0x8000) ? code : ((code & 0x7FFF) << 10); }
+        void SetCapacity(uint32_t capacity)
+            { uint64_t code = (capacity < 0x8000) ? capacity : (0x8000 | (capacity >> 10)); bits = (bits & PointerMask) | (code << 48); }
+
+        uint64_t bits;
         uint32_t size;
-        uint32_t capacity;
     };
-
-    //! Map type, part of Data union: 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
-    struct Array
+#else
+    //! Map or array storage, part of Data union: 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
+    template <typename T>
+    struct Elements
     {
-        Value* elements;
+        T* GetElements() const { return elements; }
+        void SetElements(T* newElements) { elements = newElements; }
+        uint32_t GetCapacity() const { return capacity; }
+        void SetCapacity(uint32_t newCapacity) { capacity = newCapacity; }
+
+        T* elements;
         uint32_t size;
         uint32_t capacity;
     };
+#endif // defined(ANYRPC_PACKED_VALUE)
+
+    //! Map type, part of Data union
+    typedef Elements<Member> Map;
+    //! Array type, part of Data union
+    typedef Elements<Value> Array;
 
-    //! Union of each of the basic data types: 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
+    //! Union of each of the basic data types: 12 bytes in 32-bit mode, 16 bytes in 64-bit mode, 12 bytes packed
     union Data
     {
         String s;
@@ -488,10 +640,38 @@ private:
         Map m;
         Array a;
         time_t dt;
+        SharedValue* sv;
     };
 
+#if defined(ANYRPC_PACKED_VALUE)
+# pragma pack(pop)
+#endif
+
+    //! Round a map or array capacity up to one that can be stored
+    static uint32_t RoundCapacity(std::size_t capacity);
+
     //! Check the capacity of a map to allow a member to be added.
     void AddMemberCheckCapacity();
+    //! Allocate space for the data, from the current arena if there is one
+    void* AllocateData(std::size_t size);
+    //! Change the size of the allocated data, moving it out of an arena that is no longer current
+    void* ReallocateData(void* ptr, std::size_t oldSize, std::size_t newSize);
+    //! Number of bytes to allocate for the members and hash index of a map
+    static std::size_t MapAllocationSize(uint32_t capacity);
+    //! Number of slots in the hash index for the map capacity, zero if the map doesn't use an index
+    static uint32_t HashIndexSlots(uint32_t capacity);
+    //! Hash of a string key
+    static uint32_t HashKey(const Value& key);
+    //! Find the member using the hash index, adding any members that are not yet indexed
+    Member* FindMemberIndexed(const Value& key, const char* interned);
+    //! Find the member without changing the map, the hash index is only used if it is complete
+    const Member* FindMemberConst(const Value& key, const char* interned) const;
+    //! Compare a member key to the key being found, interned is the KeyTable string for the key or 0
+    static bool KeyEqual(const Value& key, const char* interned, const Value& memberKey);
+    //! Set a member key, referencing the KeyTable string when the key is interned
+    void SetKey(const char* str, std::size_t length, bool copy);
+    //! Set a member key, referencing the KeyTable string when the key is interned
+    void SetKey(Value& key, bool copy);
     //! Copy the string as either a short string or with allocated memory.
     void CopyString(const char* s) { CopyString(s, strlen(s)); }
     //! Copy the string as either a short string or with allocated memory.
@@ -509,10 +689,12 @@ private:
     void TraverseInternal(Handler& handler) const;
     //! Internal member function to perform the recursive calls to perform a deep copy.
     void CopyInternal(const Value& rhs);
+    //! Create a Value for an element of a typed array.
+    Value TypedArrayElement(std::size_t index) const;
 
     Data data_;             //!< Data storage which depends on the flags
     unsigned flags_;        //!< Flags that indicate the type information for accessing the data
-};  // 16 bytes in 32-bit mode, 24 bytes in 64-bit mode
+};  // 16 bytes in 32-bit mode, 24 bytes in 64-bit mode, 16 bytes packed
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -44,6 +44,22 @@ protected:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class ANYRPC_API XmlHttpBalancedClient : public BalancedClient
+{
+protected:
+    virtual Client* CreateClient(const char* host, int port) { return new XmlHttpClient(host, port); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ANYRPC_API XmlTcpBalancedClient : public BalancedClient
+{
+protected:
+    virtual Client* CreateClient(const char* host, int port) { return new XmlTcpClient(host, port); }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 //! ClientHandler for XmlRpc format to generate the request and process the response
 class ANYRPC_API XmlClientHandler : public ClientHandler
 {
@@ -51,6 +67,8 @@ public:
     XmlClientHandler() {}
     virtual bool GenerateRequest(const char* method, Value& params, Stream& os, unsigned& requestId, bool notification);
     virtual ProcessResponseEnum ProcessResponse(char* response, std::size_t length, Value& result, unsigned requestId, bool notification);
+    virtual bool GenerateBatchRequest(Batch& batch, Stream& os, std::vector<unsigned>& requestIds);
+    virtual ProcessResponseEnum ProcessBatchResponse(char* response, std::size_t length, Batch& batch, std::vector<unsigned>& requestIds);
 };
 
 } // namespace anyrpc
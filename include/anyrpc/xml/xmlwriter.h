@@ -42,6 +42,7 @@ public:
     //! Make the text more readable with indentation and linefeeds
     void SetPretty(bool pretty=true) { pretty_ = pretty; }
     //! Set the double format method. The default is no exponents for xmlrpc spec compatibility.
+    //! A precision of 17 or more writes the shortest digits that read back as the same value.
     void SetScientificPrecision(unsigned precision=18)
         { precision_ = std::min( 32u, precision); }
 
@@ -91,11 +92,6 @@ private:
     void EndToken(const char* pToken);
     //@}
 
-    //! Convert a double precision value to a string without using exponents
-    void DoubleToStream(Stream& os, double value);
-    inline unsigned LeadDigit(double arg, double precision)
-        { return (std::min)( (unsigned)9, (unsigned)(arg + precision)); }
-
     Stream& os_;                    //!< Stream to write the messagepack representation to
     bool pretty_;                   //!< Write using tabs and newlines to make it easier for a person to read
     int level_;                     //!< Current indent level
@@ -0,0 +1,127 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/arena.h"
+
+namespace anyrpc
+{
+
+static ANYRPC_THREAD_LOCAL MemoryArena* currentArena = 0;
+
+MemoryArena* MemoryArena::GetCurrent()
+{
+    return currentArena;
+}
+
+void MemoryArena::SetCurrent(MemoryArena* arena)
+{
+    currentArena = arena;
+}
+
+MemoryArena::MemoryArena(std::size_t blockSize) :
+    head_(0), ptr_(0), end_(0), last_(0), blockSize_(Align(blockSize)), used_(0), capacity_(0)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+    while (head_ != 0)
+    {
+        Block* next = head_->next;
+        free(head_);
+        head_ = next;
+    }
+}
+
+void MemoryArena::AddBlock(std::size_t size)
+{
+    size = std::max(Align(size), blockSize_);
+    Block* block = static_cast<Block*>(malloc(Align(sizeof(Block)) + size));
+    anyrpc_assert(block != 0, AnyRpcErrorMemoryAllocation, "Data allocation failed");
+    block->next = head_;
+    block->size = size;
+    head_ = block;
+    ptr_ = reinterpret_cast<char*>(block) + Align(sizeof(Block));
+    end_ = ptr_ + size;
+    last_ = 0;
+    capacity_ += size;
+}
+
+void* MemoryArena::Malloc(std::size_t size)
+{
+    size = Align(size);
+    if (static_cast<std::size_t>(end_ - ptr_) < size)
+        AddBlock(size);
+    last_ = ptr_;
+    ptr_ += size;
+    used_ += size;
+    return last_;
+}
+
+void* MemoryArena::Realloc(void* ptr, std::size_t oldSize, std::size_t newSize)
+{
+    if (ptr == 0)
+        return Malloc(newSize);
+
+    oldSize = Align(oldSize);
+    newSize = Align(newSize);
+    if (newSize <= oldSize)
+        return ptr;
+
+    // the last allocation can grow into the remaining space of the block
+    if ((ptr == last_) && (static_cast<std::size_t>(end_ - last_) >= newSize))
+    {
+        ptr_ = last_ + newSize;
+        used_ += newSize - oldSize;
+        return ptr;
+    }
+
+    void* newPtr = Malloc(newSize);
+    memcpy(newPtr, ptr, oldSize);
+    return newPtr;
+}
+
+void MemoryArena::Reset()
+{
+    if ((head_ != 0) && (head_->next != 0))
+    {
+        // replace the blocks with one that would have held all of the data
+        std::size_t size = capacity_;
+        while (head_ != 0)
+        {
+            Block* next = head_->next;
+            free(head_);
+            head_ = next;
+        }
+        capacity_ = 0;
+        AddBlock(size);
+    }
+    else if (head_ != 0)
+    {
+        ptr_ = reinterpret_cast<char*>(head_) + Align(sizeof(Block));
+        last_ = 0;
+    }
+    used_ = 0;
+}
+
+} // namespace anyrpc
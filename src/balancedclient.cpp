@@ -0,0 +1,423 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/value.h"
+#include "anyrpc/stream.h"
+#include "anyrpc/handler.h"
+#include "anyrpc/socket.h"
+#include "anyrpc/client.h"
+#include "anyrpc/balancedclient.h"
+#include "anyrpc/internal/time.h"
+
+#if !defined(WIN32)
+# include <sys/select.h>
+#endif // !defined(WIN32)
+
+namespace anyrpc
+{
+
+BalancedClient::BalancedClient()
+{
+    policy_ = BalanceRoundRobin;
+    nextIndex_ = 0;
+    timeout_ = 60000;
+    ejectErrors_ = 5;
+    ejectTime_ = 30000;
+    maxIdleClients_ = 4;
+    hedging_ = false;
+    hedgePercentile_ = 95;
+    nextCallTime_ = 0;
+
+    struct timeval currentTime;
+    gettimeofday( &currentTime, 0 );
+    randomState_ = static_cast<unsigned>(currentTime.tv_usec) | 1;
+}
+
+BalancedClient::~BalancedClient()
+{
+    for (std::size_t i=0; i<endpoints_.size(); i++)
+    {
+        std::vector<Client*>& idle = endpoints_[i].idle_;
+        for (std::size_t j=0; j<idle.size(); j++)
+            delete idle[j];
+        idle.clear();
+    }
+}
+
+void BalancedClient::AddEndpoint(const char* host, int port)
+{
+    log_debug("AddEndpoint: host=" << host << ", port=" << port);
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    endpoints_.push_back(Endpoint(host, port));
+}
+
+void BalancedClient::Close()
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    for (std::size_t i=0; i<endpoints_.size(); i++)
+    {
+        std::vector<Client*>& idle = endpoints_[i].idle_;
+        for (std::size_t j=0; j<idle.size(); j++)
+            idle[j]->Close();
+    }
+}
+
+bool BalancedClient::Call(const char* method, Value& params, Value& result)
+{
+    log_trace();
+    if (hedging_ && (endpoints_.size() > 1))
+    {
+        int hedgeDelay = GetHedgeDelay();
+        if (hedgeDelay >= 0)
+            return HedgedCall(method, params, result, hedgeDelay);
+    }
+
+    std::size_t index;
+    Client* client = Acquire(index);
+    if (client == 0)
+    {
+        result.SetInvalid();
+        return false;
+    }
+
+    struct timeval startTime;
+    gettimeofday( &startTime, 0 );
+    bool success;
+    try
+    {
+        success = client->Call(method, params, result);
+    }
+    catch (...)
+    {
+        // the call is no longer outstanding and the connection may be part way through it
+        client->Close();
+        Release(index, client, startTime, false);
+        throw;
+    }
+    Release(index, client, startTime);
+    return success;
+}
+
+bool BalancedClient::Notify(const char* method, Value& params, Value& result)
+{
+    log_trace();
+    std::size_t index;
+    Client* client = Acquire(index);
+    if (client == 0)
+    {
+        result.SetInvalid();
+        return false;
+    }
+
+    struct timeval startTime;
+    gettimeofday( &startTime, 0 );
+    bool success;
+    try
+    {
+        success = client->Notify(method, params, result);
+    }
+    catch (...)
+    {
+        // the call is no longer outstanding and the connection may be part way through it
+        client->Close();
+        Release(index, client, startTime, false);
+        throw;
+    }
+    Release(index, client, startTime);
+    return success;
+}
+
+bool BalancedClient::HedgedCall(const char* method, Value& params, Value& result, int hedgeDelay)
+{
+    log_debug("HedgedCall: delay=" << hedgeDelay);
+    std::size_t index[2];
+    Client* client[2];
+    client[0] = Acquire(index[0]);
+    if (client[0] == 0)
+    {
+        result.SetInvalid();
+        return false;
+    }
+
+    struct timeval startTime;
+    gettimeofday( &startTime, 0 );
+    bool posted;
+    try
+    {
+        posted = client[0]->Post(method, params, result);
+    }
+    catch (...)
+    {
+        client[0]->Close();
+        Release(index[0], client[0], startTime, false);
+        throw;
+    }
+    if (!posted)
+    {
+        Release(index[0], client[0], startTime);
+        return false;
+    }
+
+    // Wait for the first response before sending the hedged request
+    SOCKET fd[2];
+    fd[0] = client[0]->GetFileDescriptor();
+    struct timeval tval;
+    tval.tv_sec = hedgeDelay / 1000;
+    tval.tv_usec = (hedgeDelay % 1000) * 1000;
+    fd_set readfds;
+    FD_ZERO( &readfds );
+    FD_SET( fd[0], &readfds );
+    int numClients = 1;
+    if (select( static_cast<int>(fd[0]) + 1, &readfds, 0, 0, &tval ) == 0)
+    {
+        client[1] = Acquire(index[1], index[0]);
+        if (client[1] != 0)
+        {
+            struct timeval currentTime;
+            gettimeofday( &currentTime, 0 );
+            int timeLeft = static_cast<int>(timeout_) - MilliTimeDiff(currentTime, startTime);
+            client[1]->SetTimeout(std::max(0, timeLeft));
+            Value hedgeResult;
+            if (client[1]->Post(method, params, hedgeResult))
+                numClients = 2;
+            else
+                Release(index[1], client[1], startTime);
+        }
+    }
+
+    // Use whichever client is readable first
+    int winner = 0;
+    if (numClients == 2)
+    {
+        fd[1] = client[1]->GetFileDescriptor();
+        struct timeval currentTime;
+        gettimeofday( &currentTime, 0 );
+        int timeLeft = std::max(0, static_cast<int>(timeout_) - MilliTimeDiff(currentTime, startTime));
+        tval.tv_sec = timeLeft / 1000;
+        tval.tv_usec = (timeLeft % 1000) * 1000;
+        FD_ZERO( &readfds );
+        FD_SET( fd[0], &readfds );
+        FD_SET( fd[1], &readfds );
+        if ((select( static_cast<int>(std::max(fd[0], fd[1])) + 1, &readfds, 0, 0, &tval ) > 0) &&
+            !FD_ISSET( fd[0], &readfds ))
+            winner = 1;
+        log_debug("HedgedCall: winner=" << winner);
+
+        // The other request is abandoned without affecting its endpoint statistics
+        client[1-winner]->CancelPending();
+        Release(index[1-winner], client[1-winner], startTime, false);
+    }
+
+    struct timeval currentTime;
+    gettimeofday( &currentTime, 0 );
+    client[winner]->SetTimeout(std::max(0, static_cast<int>(timeout_) - MilliTimeDiff(currentTime, startTime)));
+    bool success = client[winner]->GetPostResult(result);
+    Release(index[winner], client[winner], startTime);
+    return success;
+}
+
+int BalancedClient::GetHedgeDelay()
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    if (callTimes_.size() < HedgeMinSamples)
+        return -1;
+
+    std::vector<int64_t> callTimes(callTimes_);
+    std::size_t position = std::min(callTimes.size() * hedgePercentile_ / 100, callTimes.size() - 1);
+    std::nth_element(callTimes.begin(), callTimes.begin() + position, callTimes.end());
+    return static_cast<int>(callTimes[position] / 1000) + 1;
+}
+
+std::size_t BalancedClient::SelectEndpoint(std::vector<std::size_t>& available)
+{
+    std::size_t numAvailable = available.size();
+    switch (policy_)
+    {
+        case BalanceLeastOutstanding:
+        {
+            // start the search at a rotating position so that ties are spread out
+            std::size_t start = nextIndex_++ % numAvailable;
+            std::size_t selected = available[start];
+            for (std::size_t i=1; i<numAvailable; i++)
+            {
+                std::size_t index = available[(start + i) % numAvailable];
+                if (endpoints_[index].outstanding_ < endpoints_[selected].outstanding_)
+                    selected = index;
+            }
+            return selected;
+        }
+        case BalancePowerOfTwoChoices:
+        {
+            if (numAvailable == 1)
+                return available[0];
+            std::size_t first = NextRandom() % numAvailable;
+            std::size_t second = NextRandom() % (numAvailable - 1);
+            if (second >= first)
+                second++;
+            Endpoint& ep1 = endpoints_[available[first]];
+            Endpoint& ep2 = endpoints_[available[second]];
+            // weight the latency by the calls in progress so that a fast endpoint isn't overloaded
+            int64_t score1 = ep1.latency_ * (ep1.outstanding_ + 1);
+            int64_t score2 = ep2.latency_ * (ep2.outstanding_ + 1);
+            return (score2 < score1) ? available[second] : available[first];
+        }
+        default:
+        {
+            // available is in increasing order so find the first at or after the next position
+            std::size_t selected = available[0];
+            for (std::size_t i=0; i<numAvailable; i++)
+            {
+                if (available[i] >= nextIndex_)
+                {
+                    selected = available[i];
+                    break;
+                }
+            }
+            nextIndex_ = selected + 1;
+            return selected;
+        }
+    }
+}
+
+Client* BalancedClient::Acquire(std::size_t& index, std::size_t exclude)
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    if (endpoints_.empty())
+    {
+        log_warn("No endpoints defined");
+        return 0;
+    }
+
+    struct timeval currentTime;
+    gettimeofday( &currentTime, 0 );
+
+    std::vector<std::size_t> available;
+    std::size_t soonest = NoEndpoint;
+    for (std::size_t i=0; i<endpoints_.size(); i++)
+    {
+        Endpoint& ep = endpoints_[i];
+        if (i == exclude)
+            continue;
+        if ((ep.ejectUntil_.tv_sec == 0) || (MilliTimeDiff(currentTime, ep.ejectUntil_) >= 0))
+            available.push_back(i);
+        else if ((soonest == NoEndpoint) || (MilliTimeDiff(ep.ejectUntil_, endpoints_[soonest].ejectUntil_) < 0))
+            soonest = i;
+    }
+    if (available.empty() && (soonest == NoEndpoint))
+    {
+        log_debug("No other endpoint available");
+        return 0;
+    }
+
+    // If all endpoints are ejected, use the one that will return first instead of failing
+    index = available.empty() ? soonest : SelectEndpoint(available);
+    log_debug("Acquire: index=" << index << ", available=" << available.size());
+
+    Endpoint& ep = endpoints_[index];
+    ep.outstanding_++;
+
+    Client* client;
+    if (ep.idle_.empty())
+        client = CreateClient(ep.host_.c_str(), ep.port_);
+    else
+    {
+        client = ep.idle_.back();
+        ep.idle_.pop_back();
+    }
+    client->SetTimeout(timeout_);
+    return client;
+}
+
+void BalancedClient::Release(std::size_t index, Client* client, struct timeval& startTime, bool completed)
+{
+    struct timeval currentTime;
+    gettimeofday( &currentTime, 0 );
+    int64_t callTime = MicroTimeDiff(currentTime, startTime);
+
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    Endpoint& ep = endpoints_[index];
+    ep.outstanding_--;
+
+    if (!completed)
+    {
+        // An abandoned call says nothing about the endpoint
+    }
+    else if (client->GetLastResponse() == ProcessResponseErrorClose)
+    {
+        ep.consecutiveErrors_++;
+        if ((ejectErrors_ > 0) && (ep.consecutiveErrors_ >= ejectErrors_))
+        {
+            log_warn("Eject endpoint: host=" << ep.host_ << ", port=" << ep.port_ << ", errors=" << ep.consecutiveErrors_);
+            ep.ejectUntil_.tv_sec = currentTime.tv_sec + ejectTime_ / 1000;
+            ep.ejectUntil_.tv_usec = currentTime.tv_usec + (ejectTime_ % 1000) * 1000;
+            if (ep.ejectUntil_.tv_usec >= 1000000)
+            {
+                ep.ejectUntil_.tv_sec++;
+                ep.ejectUntil_.tv_usec -= 1000000;
+            }
+            ep.consecutiveErrors_ = 0;
+        }
+    }
+    else
+    {
+        // Only successful transactions are used for the latency since failures are often fast
+        ep.consecutiveErrors_ = 0;
+        ep.ejectUntil_.tv_sec = 0;
+        if (ep.latency_ == 0)
+            ep.latency_ = callTime;
+        else
+            ep.latency_ += (callTime - ep.latency_) / 8;
+
+        if (callTimes_.size() < HedgeSamples)
+            callTimes_.push_back(callTime);
+        else
+            callTimes_[nextCallTime_] = callTime;
+        nextCallTime_ = (nextCallTime_ + 1) % HedgeSamples;
+    }
+
+    if (ep.idle_.size() < maxIdleClients_)
+        ep.idle_.push_back(client);
+    else
+        delete client;
+}
+
+unsigned BalancedClient::NextRandom()
+{
+    // xorshift generator - only needs to be good enough to spread the selection
+    randomState_ ^= randomState_ << 13;
+    randomState_ ^= randomState_ >> 17;
+    randomState_ ^= randomState_ << 5;
+    return randomState_;
+}
+
+} // namespace anyrpc
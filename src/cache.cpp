@@ -0,0 +1,273 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/arena.h"
+#include "anyrpc/value.h"
+#include "anyrpc/cache.h"
+#include "anyrpc/internal/time.h"
+
+#include <iomanip>
+
+namespace anyrpc
+{
+
+void ResponseCache::AddMethod(std::string const& method, unsigned msTime)
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    methods_[method] = msTime;
+}
+
+void ResponseCache::RemoveMethod(std::string const& method)
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    methods_.erase(method);
+
+    // the method name is the second line of the key
+    std::map<std::string, Entry>::iterator it = entries_.begin();
+    while (it != entries_.end())
+    {
+        std::size_t start = it->first.find('\n') + 1;
+        std::size_t end = it->first.find('\n', start);
+        std::map<std::string, Entry>::iterator current = it++;
+        if (!current->second.pending_ && (current->first.compare(start, end - start, method) == 0))
+            Erase(current);
+    }
+}
+
+void ResponseCache::SetCapacity(std::size_t capacity)
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    capacity_ = capacity;
+    Trim();
+}
+
+std::size_t ResponseCache::GetSize()
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    return lru_.size();
+}
+
+void ResponseCache::Clear()
+{
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    // pending entries are kept so the waiting threads are still released
+    std::map<std::string, Entry>::iterator it = entries_.begin();
+    while (it != entries_.end())
+    {
+        std::map<std::string, Entry>::iterator current = it++;
+        if (!current->second.pending_)
+            Erase(current);
+    }
+}
+
+bool ResponseCache::Lookup(std::string const& host, int port, const char* method, Value& params, Value& result, std::string& cacheKey)
+{
+    cacheKey.clear();
+#if defined(ANYRPC_THREADING)
+    std::unique_lock<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+    if (methods_.find(method) == methods_.end())
+        return false;
+
+    std::stringstream endpoint;
+    endpoint << host << ":" << port << "\n" << method << "\n";
+    std::string key = endpoint.str();
+    AppendCanonical(params, key);
+
+    std::map<std::string, Entry>::iterator it = entries_.find(key);
+#if defined(ANYRPC_THREADING)
+    // wait for another thread that is already making the same call
+    while ((it != entries_.end()) && it->second.pending_)
+    {
+        log_debug("Lookup: wait for pending call, method=" << method);
+        pendingDone_.wait(lock);
+        it = entries_.find(key);
+    }
+#endif // defined(ANYRPC_THREADING)
+
+    if (it != entries_.end())
+    {
+        struct timeval currentTime;
+        gettimeofday( &currentTime, 0 );
+        if (!it->second.pending_ && (MilliTimeDiff(currentTime, it->second.expires_) < 0))
+        {
+            log_debug("Lookup: found, method=" << method);
+            result.Copy(it->second.result_);
+            lru_.splice(lru_.begin(), lru_, it->second.lruPosition_);
+            return true;
+        }
+        if (!it->second.pending_)
+            Erase(it);
+    }
+
+    // this caller will make the call and provide the result
+    log_debug("Lookup: not found, method=" << method);
+    entries_[key].pending_ = true;
+    cacheKey = key;
+    return false;
+}
+
+void ResponseCache::Complete(std::string const& cacheKey, Value& result, bool success)
+{
+    {
+#if defined(ANYRPC_THREADING)
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif // defined(ANYRPC_THREADING)
+        std::map<std::string, Entry>::iterator it = entries_.find(cacheKey);
+        if (it == entries_.end())
+            return;
+
+        // the method name is the second line of the key
+        std::size_t start = cacheKey.find('\n') + 1;
+        std::map<std::string, unsigned>::iterator method = methods_.find(cacheKey.substr(start, cacheKey.find('\n', start) - start));
+        if (!success || (method == methods_.end()))
+            entries_.erase(it);
+        else
+        {
+            Entry& entry = it->second;
+            // the result may reference the client receive buffer so a full copy is required,
+            // and it must not use a request arena since the entry outlives the request
+            {
+                ArenaScope heapScope(0);
+                entry.result_.Copy(result);
+            }
+            gettimeofday( &entry.expires_, 0 );
+            entry.expires_.tv_sec += method->second / 1000;
+            entry.expires_.tv_usec += (method->second % 1000) * 1000;
+            if (entry.expires_.tv_usec >= 1000000)
+            {
+                entry.expires_.tv_sec++;
+                entry.expires_.tv_usec -= 1000000;
+            }
+            entry.pending_ = false;
+            lru_.push_front(cacheKey);
+            entry.lruPosition_ = lru_.begin();
+            Trim();
+        }
+    }
+#if defined(ANYRPC_THREADING)
+    pendingDone_.notify_all();
+#endif // defined(ANYRPC_THREADING)
+}
+
+void ResponseCache::Erase(std::map<std::string, Entry>::iterator it)
+{
+    if (!it->second.pending_)
+        lru_.erase(it->second.lruPosition_);
+    entries_.erase(it);
+}
+
+void ResponseCache::Trim()
+{
+    while (lru_.size() > capacity_)
+    {
+        log_debug("Trim: remove least recently used");
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
+
+void ResponseCache::AppendCanonical(Value& value, std::string& key)
+{
+    std::stringstream data;
+    switch (value.GetType())
+    {
+        case NullType       : key += 'n'; break;
+        case FalseType      : key += 'f'; break;
+        case TrueType       : key += 't'; break;
+        case NumberType     :
+            if (value.IsInt())
+                data << 'i' << value.GetInt();
+            else if (value.IsUint())
+                data << 'u' << value.GetUint();
+            else if (value.IsInt64())
+                data << 'i' << value.GetInt64();
+            else if (value.IsUint64())
+                data << 'u' << value.GetUint64();
+            else
+                data << 'd' << std::setprecision(17) << value.GetDouble();
+            key += data.str();
+            break;
+        case DateTimeType   :
+            data << 'T' << value.GetDateTime();
+            key += data.str();
+            break;
+        case StringType     :
+            data << 's' << value.GetStringLength() << ':';
+            key += data.str();
+            key.append(value.GetString(), value.GetStringLength());
+            break;
+        case BinaryType     :
+            data << 'b' << value.GetBinaryLength() << ':';
+            key += data.str();
+            key.append(reinterpret_cast<const char*>(value.GetBinary()), value.GetBinaryLength());
+            break;
+        case ArrayType      :
+            key += '[';
+            for (std::size_t i=0; i<value.Size(); i++)
+                AppendCanonical(value[i], key);
+            key += ']';
+            break;
+        case MapType        :
+        {
+            // sort the members by key so the order they were added doesn't matter
+            std::vector<std::pair<std::string, Value*> > members;
+            for (MemberIterator it = value.MemberBegin(); it != value.MemberEnd(); ++it)
+                members.push_back(std::make_pair(std::string(it.GetKey().GetString(), it.GetKey().GetStringLength()), &it.GetValue()));
+            std::sort(members.begin(), members.end());
+            key += '{';
+            for (std::size_t i=0; i<members.size(); i++)
+            {
+                data.str("");
+                data << members[i].first.length() << ':';
+                key += data.str();
+                key += members[i].first;
+                AppendCanonical(*members[i].second, key);
+            }
+            key += '}';
+            break;
+        }
+        case SharedType     :
+        {
+            // use the contents since a freed shared value's address can be reused for other data,
+            // and a copy so the shared data isn't changed by expanding any typed arrays
+            Value contents;
+            contents.Copy(value.GetShared());
+            AppendCanonical(contents, key);
+            break;
+        }
+        default             : key += 'x'; break;   // invalid
+    }
+}
+
+} // namespace anyrpc
@@ -29,6 +29,7 @@
 #include "anyrpc/method.h"
 #include "anyrpc/socket.h"
 #include "anyrpc/client.h"
+#include "anyrpc/cache.h"
 #include "anyrpc/internal/time.h"
 
 namespace anyrpc
@@ -45,6 +46,41 @@ unsigned ClientHandler::GetNextId()
     return nextId_++;
 }
 
+void Batch::Add(const char* method, Value& params)
+{
+    methods_.push_back(method);
+    Value paramsCopy(params);
+    params_.PushBack(paramsCopy);
+    Value result;
+    results_.PushBack(result);
+    success_.push_back(false);
+}
+
+void Batch::Clear()
+{
+    methods_.clear();
+    params_.SetArray();
+    results_.SetArray();
+    success_.clear();
+}
+
+void Batch::SetResult(std::size_t index, Value& result, bool success)
+{
+    results_[index].Assign(result);
+    success_[index] = success;
+}
+
+void Batch::SetAllResults(Value& result, bool success)
+{
+    for (std::size_t i=0; i<GetSize(); i++)
+    {
+        results_[i].Copy(result);
+        success_[i] = success;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ClientHandler::GenerateFaultResult(int errorCode, std::string const& errorMsg, Value& result)
 {
     result["code"] = errorCode;
@@ -60,6 +96,9 @@ Client::Client(ClientHandler* handler)
     timeout_ = 60000;
     responseAllocated_ = false;
     responseProcessed_ = false;
+    responseBuffer_ = 0;
+    cache_ = 0;
+    lastResponse_ = ProcessResponseSuccess;
     ResetReceiveBuffer();
     ResetTransaction();
 }
@@ -72,6 +111,9 @@ Client::Client(ClientHandler* handler, const char* host, int port)
     timeout_ = 60000;
     responseAllocated_ = false;
     responseProcessed_ = false;
+    responseBuffer_ = 0;
+    cache_ = 0;
+    lastResponse_ = ProcessResponseSuccess;
     ResetReceiveBuffer();
     ResetTransaction();
 }
@@ -84,10 +126,38 @@ Client::~Client()
 }
 
 bool Client::Call(const char* method, Value& params, Value& result)
+{
+    log_trace();
+    std::string cacheKey;
+    if ((cache_ != 0) && cache_->Lookup(host_, port_, method, params, result, cacheKey))
+    {
+        lastResponse_ = ProcessResponseSuccess;
+        return true;
+    }
+
+    bool success;
+    try
+    {
+        success = CallServer(method, params, result);
+    }
+    catch (...)
+    {
+        // other callers are waiting for the pending entry
+        if (!cacheKey.empty())
+            cache_->Complete(cacheKey, result, false);
+        throw;
+    }
+    if (!cacheKey.empty())
+        cache_->Complete(cacheKey, result, success);
+    return success;
+}
+
+bool Client::CallServer(const char* method, Value& params, Value& result)
 {
     log_trace();
     gettimeofday( &startTime_, 0 );
     result.SetInvalid();
+    lastResponse_ = ProcessResponseErrorClose;
 
     PreserveReceiveBuffer();
     ResetTransaction();
@@ -111,7 +181,8 @@ bool Client::Call(const char* method, Value& params, Value& result)
         if (ReadHeader(result) &&
             ReadResponse(result))
         {
-            switch (ProcessResponse(result))
+            lastResponse_ = ProcessResponse(result);
+            switch (lastResponse_)
             {
                 case ProcessResponseSuccess       : return true;
                 case ProcessResponseErrorKeepOpen : return false;
@@ -123,11 +194,21 @@ bool Client::Call(const char* method, Value& params, Value& result)
     return false;
 }
 
+bool Client::Call(const char* method, Value& params, Value& result, ResponseBuffer& buffer)
+{
+    buffer.Release();
+    responseBuffer_ = &buffer;
+    bool success = Call(method, params, result);
+    responseBuffer_ = 0;
+    return success;
+}
+
 bool Client::Post(const char* method, Value& params, Value& result)
 {
     log_trace();
     gettimeofday( &startTime_, 0 );
     result.SetInvalid();
+    lastResponse_ = ProcessResponseErrorClose;
 
     PreserveReceiveBuffer();
     ResetTransaction();
@@ -147,6 +228,7 @@ bool Client::Post(const char* method, Value& params, Value& result)
                 return false;
             }
         }
+        lastResponse_ = ProcessResponseSuccess;
         return true;
     }
     Reset();
@@ -158,6 +240,7 @@ bool Client::GetPostResult(Value& result)
     log_trace();
     gettimeofday( &startTime_, 0 );
     result.SetInvalid();
+    lastResponse_ = ProcessResponseErrorClose;
 
     if (responseProcessed_)
     {
@@ -169,7 +252,8 @@ bool Client::GetPostResult(Value& result)
         ReadHeader(result) &&
         ReadResponse(result))
     {
-        switch (ProcessResponse(result))
+        lastResponse_ = ProcessResponse(result);
+        switch (lastResponse_)
         {
             case ProcessResponseSuccess       : return true;
             case ProcessResponseErrorKeepOpen : return false;
@@ -181,11 +265,21 @@ bool Client::GetPostResult(Value& result)
     return false;
 }
 
+bool Client::GetPostResult(Value& result, ResponseBuffer& buffer)
+{
+    buffer.Release();
+    responseBuffer_ = &buffer;
+    bool success = GetPostResult(result);
+    responseBuffer_ = 0;
+    return success;
+}
+
 bool Client::Notify(const char* method, Value& params, Value& result)
 {
     log_trace();
     gettimeofday( &startTime_, 0 );
     result.SetInvalid();
+    lastResponse_ = ProcessResponseErrorClose;
 
     PreserveReceiveBuffer();
     ResetTransaction();
@@ -209,6 +303,7 @@ bool Client::Notify(const char* method, Value& params, Value& result)
         if (!TransportHasNotifyResponse())
         {
             requestId_.pop_front();
+            lastResponse_ = ProcessResponseSuccess;
             return true;
         }
         // continue with the processing response
@@ -218,6 +313,7 @@ bool Client::Notify(const char* method, Value& params, Value& result)
             // don't process the response for a notification
             requestId_.pop_front();
             result.SetNull();
+            lastResponse_ = ProcessResponseSuccess;
             return true;
         }
     }
@@ -225,6 +321,101 @@ bool Client::Notify(const char* method, Value& params, Value& result)
     return false;
 }
 
+bool Client::BatchCall(Batch& batch)
+{
+    log_trace();
+    if (batch.GetSize() == 0)
+        return true;
+
+    gettimeofday( &startTime_, 0 );
+    lastResponse_ = ProcessResponseErrorClose;
+
+    PreserveReceiveBuffer();
+    ResetTransaction();
+
+    std::vector<unsigned> requestIds;
+    if (!handler_->GenerateBatchRequest(batch, request_, requestIds))
+        return PipelineCall(batch);
+
+    // The same processing as Call but the ids are kept locally
+    Value result;
+    if (Connect(result) &&
+        GenerateHeader())
+    {
+        if (!WriteRequest(result))
+        {
+            // retry the connection
+            Close();
+            if (!Connect(result) ||
+                !WriteRequest(result))
+            {
+                Reset();
+                batch.SetAllResults(result, false);
+                return false;
+            }
+        }
+        // continue with the processing
+        if (ReadHeader(result) &&
+            ReadResponse(result))
+        {
+            responseProcessed_ = true;
+            lastResponse_ = handler_->ProcessBatchResponse(response_, contentLength_, batch, requestIds);
+            switch (lastResponse_)
+            {
+                case ProcessResponseSuccess       : return true;
+                case ProcessResponseErrorKeepOpen : return false;
+                default                           : ; // continue processing
+            }
+            Reset();
+            return false;
+        }
+    }
+    Reset();
+    batch.SetAllResults(result, false);
+    return false;
+}
+
+bool Client::PipelineCall(Batch& batch)
+{
+    log_trace();
+    Value result;
+    std::size_t numPosted = 0;
+    while (numPosted < batch.GetSize())
+    {
+        if (!Post(batch.GetMethod(numPosted), batch.GetParams(numPosted), result))
+        {
+            // the connection has been reset so the posted calls are lost as well
+            batch.SetAllResults(result, false);
+            return false;
+        }
+        numPosted++;
+    }
+
+    bool success = true;
+    for (std::size_t i=0; i<numPosted; i++)
+    {
+        bool callSuccess = GetPostResult(result);
+        // the result can reference the receive buffer which is reused for the next response
+        Value resultCopy;
+        resultCopy.Copy(result);
+        batch.SetResult(i, resultCopy, callSuccess);
+        success = success && callSuccess;
+        if (lastResponse_ == ProcessResponseErrorClose)
+        {
+            // the remaining responses will not arrive after a reset
+            for (std::size_t j=i+1; j<numPosted; j++)
+            {
+                Value fault;
+                fault.Copy(batch.GetResult(i));
+                batch.SetResult(j, fault, false);
+            }
+            return false;
+        }
+    }
+    lastResponse_ = success ? ProcessResponseSuccess : ProcessResponseErrorKeepOpen;
+    return success;
+}
+
 void Client::Reset()
 {
     Close();
@@ -431,7 +622,29 @@ ProcessResponseEnum Client::ProcessResponse(Value& result, bool notification)
         requestId_.pop_front();
     }
     responseProcessed_ = true;
-    return handler_->ProcessResponse(response_,contentLength_,result,requestId,notification);
+    return handler_->ProcessResponse(GetResponseData(),contentLength_,result,requestId,notification);
+}
+
+char* Client::GetResponseData()
+{
+    if (responseBuffer_ == 0)
+        return response_;
+
+    if (responseAllocated_)
+    {
+        // pass the allocated response to the caller so it isn't freed with the next transaction
+        responseBuffer_->Take(response_, contentLength_);
+        responseAllocated_ = false;
+        return response_;
+    }
+
+    // the fixed buffer is reused so the response needs its own space
+    char* response = static_cast<char*>(malloc(contentLength_ + 1));
+    anyrpc_assert(response != 0, AnyRpcErrorMemoryAllocation, "Data allocation failed");
+    memcpy(response, response_, contentLength_);
+    response[contentLength_] = 0;
+    responseBuffer_->Take(response, contentLength_);
+    return response;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -445,6 +658,7 @@ bool HttpClient::GenerateHeader()
     header_ << "Content-Type: " << contentType_ << "\r\n";
     header_ << "Accept: " << contentType_ << "\r\n";
     header_ << "Content-length: " << request_.Length() << "\r\n";
+    header_ << ANYRPC_TIMEOUT_HEADER << ": " << GetTimeLeft() << "\r\n";
     header_ << "\r\n";
 
     return true;
@@ -513,7 +727,7 @@ ProcessResponseEnum HttpClient::ProcessResponse(Value& result, bool notification
         requestId_.pop_front();
     }
     responseProcessed_ = true;
-    ProcessResponseEnum processResult = handler_->ProcessResponse(response_,contentLength_,result,requestId,notification);
+    ProcessResponseEnum processResult = handler_->ProcessResponse(GetResponseData(),contentLength_,result,requestId,notification);
     if (!httpResponseState_.GetKeepAlive())
     {
         log_info("Http response header indicates to close connection");
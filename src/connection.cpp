@@ -21,6 +21,7 @@
 #include "anyrpc/api.h"
 #include "anyrpc/logger.h"
 #include "anyrpc/error.h"
+#include "anyrpc/arena.h"
 #include "anyrpc/value.h"
 #include "anyrpc/stream.h"
 #include "anyrpc/handler.h"
@@ -68,6 +69,8 @@ Connection::Connection(SOCKET fd, MethodManager* manager) :
     contentAvail_ = 0;
     headerBytesWritten_ = 0;
     resultBytesWritten_ = 0;
+    arena_ = 0;
+    parser_ = 0;
 #if defined(ANYRPC_THREADING)
     threadRunning_ = false;
 #endif
@@ -89,6 +92,14 @@ Connection::~Connection()
     log_debug("Connection destructor, fd=" << socket_.GetFileDescriptor());
     if (requestAllocated_)
         free(request_);
+    delete parser_;
+    delete arena_;
+}
+
+void Connection::EnableArena(std::size_t blockSize)
+{
+    if (arena_ == 0)
+        arena_ = new MemoryArena(blockSize);
 }
 
 void Connection::Initialize(bool preserveBufferData)
@@ -131,6 +142,14 @@ void Connection::Initialize(bool preserveBufferData)
         requestAllocated_ = false;
     }
     request_ = 0;
+    if (parser_ != 0)
+    {
+        // the request values from the parser are the only ones in the arena
+        delete parser_;
+        parser_ = 0;
+        if (arena_ != 0)
+            arena_->Reset();
+    }
     header_.Clear();
     response_.Clear();
     contentAvail_ = 0;
@@ -275,6 +294,11 @@ bool Connection::ReadRequest()
             return false;
         }
 
+        if ((parser_ != 0) && (bytesRead > 0))
+        {
+            ArenaScope arenaScope(arena_);
+            parser_->Parse(request_+contentAvail_, bytesRead);
+        }
         contentAvail_ += bytesRead;
 
         // If we haven't gotten the entire request yet, return (keep reading)
@@ -355,6 +379,8 @@ void HttpConnection::Initialize(bool preserveBufferData)
 {
     Connection::Initialize(preserveBufferData);
     httpRequestState_.Initialize();
+    deadline_.tv_sec = 0;
+    deadline_.tv_usec = 0;
 }
 
 bool HttpConnection::ReadHeader()
@@ -406,6 +432,19 @@ bool HttpConnection::ReadHeader()
         // copy the content that was already read to the new space
         memcpy(request_,buffer_+bodyStartPos,contentAvail_);
         requestAllocated_ = true;
+
+        // start parsing while the rest of the request is received if the handler supports it
+        if (httpRequestState_.GetMethod() == "POST")
+        {
+            RpcContentHandler* handler = FindHandler();
+            if (handler != 0)
+                parser_ = handler->CreateParser(manager_);
+            if (parser_ != 0)
+            {
+                ArenaScope arenaScope(arena_);
+                parser_->Parse(request_, contentAvail_);
+            }
+        }
     }
     else
     {
@@ -415,6 +454,21 @@ bool HttpConnection::ReadHeader()
     log_info("specified content length is " << contentLength_);
     log_info("KeepAlive: " << keepAlive_);
 
+    // The client timeout is relative so convert to a local deadline
+    int timeout = httpRequestState_.GetTimeout();
+    if (timeout >= 0)
+    {
+        gettimeofday( &deadline_, 0 );
+        deadline_.tv_sec += timeout / 1000;
+        deadline_.tv_usec += (timeout % 1000) * 1000;
+        if (deadline_.tv_usec >= 1000000)
+        {
+            deadline_.tv_sec++;
+            deadline_.tv_usec -= 1000000;
+        }
+        log_info("Timeout: " << timeout);
+    }
+
     connectionState_ = READ_REQUEST;
     return true;    // Continue monitoring this source
 }
@@ -427,24 +481,35 @@ bool HttpConnection::ExecuteRequest()
 
     if (httpRequestState_.GetMethod() == "POST")
     {
-        // find a handler that will work
-        RpcHandlerList::iterator it = handlers_.begin();
-        for (;it!= handlers_.end(); it++)
-            if ((*it).CanProcessContentType(requestContentType))
-                break;
-        if (it == handlers_.end())
+        RpcContentHandler* handler = FindHandler();
+        if (handler == 0)
         {
             log_warn("Content type not supported by server, " << requestContentType);
             Initialize();
             return false;
         }
+        else if (DeadlineExpired())
+        {
+            // the client has already given up so don't spend time on the execution
+            log_warn("Deadline expired before execution");
+            keepAlive_ = false;
+            GenerateErrorResponseHeader(504, "Gateway Timeout");
+        }
         else
         {
-            (*it).HandleRequest(manager_, request_, contentLength_, response_);
+            {
+                // the deadline is removed even if the execution throws
+                DeadlineScope deadlineScope(deadline_);
+                ArenaScope arenaScope(arena_);
+                if (parser_ != 0)
+                    parser_->Execute(manager_, response_);
+                else
+                    handler->HandleRequest(manager_, request_, contentLength_, response_);
+            }
 
             log_debug("Response length=" << response_.Length());
 
-            std::string& responseContentType = (*it).GetResponseContentType();
+            std::string& responseContentType = handler->GetResponseContentType();
             if (responseContentType.length() == 0)
                 responseContentType = requestContentType;
             GeneratePOSTResponseHeader(response_.Length(), responseContentType);
@@ -463,6 +528,26 @@ bool HttpConnection::ExecuteRequest()
     return true;
 }
 
+RpcContentHandler* HttpConnection::FindHandler()
+{
+    // find a handler that will work
+    std::string& requestContentType = httpRequestState_.GetContentType();
+    for (RpcHandlerList::iterator it = handlers_.begin(); it != handlers_.end(); it++)
+        if ((*it).CanProcessContentType(requestContentType))
+            return &(*it);
+    return 0;
+}
+
+bool HttpConnection::DeadlineExpired()
+{
+    if (deadline_.tv_sec == 0)
+        return false;
+
+    struct timeval currentTime;
+    gettimeofday( &currentTime, 0 );
+    return (MilliTimeDiff(currentTime, deadline_) >= 0);
+}
+
 void HttpConnection::GeneratePOSTResponseHeader(std::size_t bodySize, std::string& contentType)
 {
     header_ << "HTTP/1.1 200 OK\r\n";
@@ -607,7 +692,11 @@ bool TcpConnection::ReadHeader()
 bool TcpConnection::ExecuteRequest()
 {
     log_debug("ContentLength=" << contentLength_ << ", request=" << request_);
-    bool sendResponse = handler_(manager_, request_, contentLength_, response_);
+    bool sendResponse;
+    {
+        ArenaScope arenaScope(arena_);
+        sendResponse = handler_(manager_, request_, contentLength_, response_);
+    }
 
     if (sendResponse)
     {
@@ -210,11 +210,24 @@ void Document::EndArray(size_t elementCount)
                 ConvertBase64(stack_.back());
         }
         else
+        {
             anyrpc_assert( stack_.back()->Size() == elementCount, AnyRpcErrorArrayCountWrong,
                     "Expected size of " << elementCount << ", size=" << stack_.back()->Size());
+
+            // Check if the elements are all the same number type to store as a typed array
+            if (convertTypedArrays_ && (stack_.back()->Size() >= MinTypedArraySize))
+                stack_.back()->PackTypedArray();
+        }
     }
 }
 
+void Document::TypedArray(TypedArrayType type, const void* data, size_t elementCount)
+{
+    log_debug("TypedArray: type=" << type << ", count=" << elementCount);
+    anyrpc_assert( stack_.back()->IsInvalid(), AnyRpcErrorAccessNotInvalidValue, "Not invalid, type=" << stack_.back()->GetType() );
+    stack_.back()->SetTypedArray(type, data, elementCount);
+}
+
 void Document::ConvertDateTime(Value *value)
 {
     // convert string to time
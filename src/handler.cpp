@@ -25,6 +25,31 @@
 #include "anyrpc/stream.h"
 #include "anyrpc/handler.h"
 
+namespace anyrpc
+{
+
+void Handler::TypedArray(TypedArrayType type, const void* data, std::size_t elementCount)
+{
+    StartArray(elementCount);
+    for (std::size_t i=0; i<elementCount; i++)
+    {
+        switch (type)
+        {
+            case TypedInt32:    Int(static_cast<const int32_t*>(data)[i]); break;
+            case TypedInt64:    Int64(static_cast<const int64_t*>(data)[i]); break;
+            case TypedFloat:    Float(static_cast<const float*>(data)[i]); break;
+            case TypedDouble:   Double(static_cast<const double*>(data)[i]); break;
+            case TypedUint8:    Uint(static_cast<const uint8_t*>(data)[i]); break;
+            default:            anyrpc_throw(AnyRpcErrorIllegalCall, "Illegal typed array type=" << type);
+        }
+        if (i != (elementCount-1))
+            ArraySeparator();
+    }
+    EndArray(elementCount);
+}
+
+} // namespace anyrpc
+
 anyrpc::Handler& operator<<(anyrpc::Handler& handler, const anyrpc::Value& value)
 {
     value.Traverse(handler);
@@ -0,0 +1,353 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/internal/strtod.h"
+#include "anyrpc/internal/dtoa.h"
+
+#include <string.h>
+
+namespace anyrpc
+{
+namespace internal
+{
+
+// The Grisu2 implementation is adapted from RapidJason (https://github.com/miloyip/rapidjson)
+// which is based on Florian Loitsch's "Printing Floating-Point Numbers Quickly and Accurately with Integers"
+
+namespace
+{
+
+//! Floating point number with a 64 bit significand, f * 2^e
+struct DiyFp
+{
+    DiyFp() : f(0), e(0) {}
+    DiyFp(uint64_t fp, int exp) : f(fp), e(exp) {}
+
+    DiyFp operator-(const DiyFp& rhs) const { return DiyFp(f - rhs.f, e); }
+
+    DiyFp operator*(const DiyFp& rhs) const
+    {
+        uint64_t high;
+        uint64_t low = FullMultiply(f, rhs.f, high);
+        if (low & (static_cast<uint64_t>(1) << 63))
+            high++; // round
+        return DiyFp(high, e + rhs.e + 64);
+    }
+
+    DiyFp Normalize() const
+    {
+        DiyFp res = *this;
+        while (!(res.f & (static_cast<uint64_t>(1) << 63)))
+        {
+            res.f <<= 1;
+            res.e--;
+        }
+        return res;
+    }
+
+    uint64_t f;
+    int e;
+};
+
+// Cached powers of ten, 10^k for k = -348, -340, ..., 340
+const uint64_t CachedPowersF[] = {
+    ANYRPC_UINT64_C2(0xfa8fd5a0, 0x081c0288), ANYRPC_UINT64_C2(0xbaaee17f, 0xa23ebf76), ANYRPC_UINT64_C2(0x8b16fb20, 0x3055ac76), ANYRPC_UINT64_C2(0xcf42894a, 0x5dce35ea),
+    ANYRPC_UINT64_C2(0x9a6bb0aa, 0x55653b2d), ANYRPC_UINT64_C2(0xe61acf03, 0x3d1a45df), ANYRPC_UINT64_C2(0xab70fe17, 0xc79ac6ca), ANYRPC_UINT64_C2(0xff77b1fc, 0xbebcdc4f),
+    ANYRPC_UINT64_C2(0xbe5691ef, 0x416bd60c), ANYRPC_UINT64_C2(0x8dd01fad, 0x907ffc3c), ANYRPC_UINT64_C2(0xd3515c28, 0x31559a83), ANYRPC_UINT64_C2(0x9d71ac8f, 0xada6c9b5),
+    ANYRPC_UINT64_C2(0xea9c2277, 0x23ee8bcb), ANYRPC_UINT64_C2(0xaecc4991, 0x4078536d), ANYRPC_UINT64_C2(0x823c1279, 0x5db6ce57), ANYRPC_UINT64_C2(0xc2109436, 0x4dfb5637),
+    ANYRPC_UINT64_C2(0x9096ea6f, 0x3848984f), ANYRPC_UINT64_C2(0xd77485cb, 0x25823ac7), ANYRPC_UINT64_C2(0xa086cfcd, 0x97bf97f4), ANYRPC_UINT64_C2(0xef340a98, 0x172aace5),
+    ANYRPC_UINT64_C2(0xb23867fb, 0x2a35b28e), ANYRPC_UINT64_C2(0x84c8d4df, 0xd2c63f3b), ANYRPC_UINT64_C2(0xc5dd4427, 0x1ad3cdba), ANYRPC_UINT64_C2(0x936b9fce, 0xbb25c996),
+    ANYRPC_UINT64_C2(0xdbac6c24, 0x7d62a584), ANYRPC_UINT64_C2(0xa3ab6658, 0x0d5fdaf6), ANYRPC_UINT64_C2(0xf3e2f893, 0xdec3f126), ANYRPC_UINT64_C2(0xb5b5ada8, 0xaaff80b8),
+    ANYRPC_UINT64_C2(0x87625f05, 0x6c7c4a8b), ANYRPC_UINT64_C2(0xc9bcff60, 0x34c13053), ANYRPC_UINT64_C2(0x964e858c, 0x91ba2655), ANYRPC_UINT64_C2(0xdff97724, 0x70297ebd),
+    ANYRPC_UINT64_C2(0xa6dfbd9f, 0xb8e5b88f), ANYRPC_UINT64_C2(0xf8a95fcf, 0x88747d94), ANYRPC_UINT64_C2(0xb9447093, 0x8fa89bcf), ANYRPC_UINT64_C2(0x8a08f0f8, 0xbf0f156b),
+    ANYRPC_UINT64_C2(0xcdb02555, 0x653131b6), ANYRPC_UINT64_C2(0x993fe2c6, 0xd07b7fac), ANYRPC_UINT64_C2(0xe45c10c4, 0x2a2b3b06), ANYRPC_UINT64_C2(0xaa242499, 0x697392d3),
+    ANYRPC_UINT64_C2(0xfd87b5f2, 0x8300ca0e), ANYRPC_UINT64_C2(0xbce50864, 0x92111aeb), ANYRPC_UINT64_C2(0x8cbccc09, 0x6f5088cc), ANYRPC_UINT64_C2(0xd1b71758, 0xe219652c),
+    ANYRPC_UINT64_C2(0x9c400000, 0x00000000), ANYRPC_UINT64_C2(0xe8d4a510, 0x00000000), ANYRPC_UINT64_C2(0xad78ebc5, 0xac620000), ANYRPC_UINT64_C2(0x813f3978, 0xf8940984),
+    ANYRPC_UINT64_C2(0xc097ce7b, 0xc90715b3), ANYRPC_UINT64_C2(0x8f7e32ce, 0x7bea5c70), ANYRPC_UINT64_C2(0xd5d238a4, 0xabe98068), ANYRPC_UINT64_C2(0x9f4f2726, 0x179a2245),
+    ANYRPC_UINT64_C2(0xed63a231, 0xd4c4fb27), ANYRPC_UINT64_C2(0xb0de6538, 0x8cc8ada8), ANYRPC_UINT64_C2(0x83c7088e, 0x1aab65db), ANYRPC_UINT64_C2(0xc45d1df9, 0x42711d9a),
+    ANYRPC_UINT64_C2(0x924d692c, 0xa61be758), ANYRPC_UINT64_C2(0xda01ee64, 0x1a708dea), ANYRPC_UINT64_C2(0xa26da399, 0x9aef774a), ANYRPC_UINT64_C2(0xf209787b, 0xb47d6b85),
+    ANYRPC_UINT64_C2(0xb454e4a1, 0x79dd1877), ANYRPC_UINT64_C2(0x865b8692, 0x5b9bc5c2), ANYRPC_UINT64_C2(0xc83553c5, 0xc8965d3d), ANYRPC_UINT64_C2(0x952ab45c, 0xfa97a0b3),
+    ANYRPC_UINT64_C2(0xde469fbd, 0x99a05fe3), ANYRPC_UINT64_C2(0xa59bc234, 0xdb398c25), ANYRPC_UINT64_C2(0xf6c69a72, 0xa3989f5c), ANYRPC_UINT64_C2(0xb7dcbf53, 0x54e9bece),
+    ANYRPC_UINT64_C2(0x88fcf317, 0xf22241e2), ANYRPC_UINT64_C2(0xcc20ce9b, 0xd35c78a5), ANYRPC_UINT64_C2(0x98165af3, 0x7b2153df), ANYRPC_UINT64_C2(0xe2a0b5dc, 0x971f303a),
+    ANYRPC_UINT64_C2(0xa8d9d153, 0x5ce3b396), ANYRPC_UINT64_C2(0xfb9b7cd9, 0xa4a7443c), ANYRPC_UINT64_C2(0xbb764c4c, 0xa7a44410), ANYRPC_UINT64_C2(0x8bab8eef, 0xb6409c1a),
+    ANYRPC_UINT64_C2(0xd01fef10, 0xa657842c), ANYRPC_UINT64_C2(0x9b10a4e5, 0xe9913129), ANYRPC_UINT64_C2(0xe7109bfb, 0xa19c0c9d), ANYRPC_UINT64_C2(0xac2820d9, 0x623bf429),
+    ANYRPC_UINT64_C2(0x80444b5e, 0x7aa7cf85), ANYRPC_UINT64_C2(0xbf21e440, 0x03acdd2d), ANYRPC_UINT64_C2(0x8e679c2f, 0x5e44ff8f), ANYRPC_UINT64_C2(0xd433179d, 0x9c8cb841),
+    ANYRPC_UINT64_C2(0x9e19db92, 0xb4e31ba9), ANYRPC_UINT64_C2(0xeb96bf6e, 0xbadf77d9), ANYRPC_UINT64_C2(0xaf87023b, 0x9bf0ee6b),
+};
+
+const int16_t CachedPowersE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+const uint64_t Pow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000, ANYRPC_UINT64_C2(0x00000002, 0x540be400),
+    ANYRPC_UINT64_C2(0x00000017, 0x4876e800), ANYRPC_UINT64_C2(0x000000e8, 0xd4a51000), ANYRPC_UINT64_C2(0x00000918, 0x4e72a000),
+    ANYRPC_UINT64_C2(0x00005af3, 0x107a4000), ANYRPC_UINT64_C2(0x00038d7e, 0xa4c68000), ANYRPC_UINT64_C2(0x002386f2, 0x6fc10000),
+    ANYRPC_UINT64_C2(0x01634578, 0x5d8a0000), ANYRPC_UINT64_C2(0x0de0b6b3, 0xa7640000), ANYRPC_UINT64_C2(0x8ac72304, 0x89e80000)
+};
+
+//! Return the cached power c = 10^-K such that the product with a number with binary exponent e has an exponent in [-60,-32]
+DiyFp GetCachedPower(int e, int& K)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0)
+        k++;
+    unsigned index = static_cast<unsigned>((k >> 3) + 1);
+    K = -(-348 + static_cast<int>(index << 3));
+    return DiyFp(CachedPowersF[index], CachedPowersE[index]);
+}
+
+void GrisuRound(char* buffer, int length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t wpW)
+{
+    while ((rest < wpW) && (delta - rest >= tenKappa) &&
+           ((rest + tenKappa < wpW) || (wpW - rest > rest + tenKappa - wpW)))
+    {
+        buffer[length - 1]--;
+        rest += tenKappa;
+    }
+}
+
+unsigned CountDecimalDigits(uint32_t n)
+{
+    unsigned count = 1;
+    while ((count < 10) && (n >= Pow10[count]))
+        count++;
+    return count;
+}
+
+void DigitGen(const DiyFp& W, const DiyFp& Mp, uint64_t delta, char* buffer, int& length, int& K)
+{
+    const DiyFp one(static_cast<uint64_t>(1) << -Mp.e, Mp.e);
+    const DiyFp wpW = Mp - W;
+    uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = CountDecimalDigits(p1);
+    length = 0;
+
+    // digits of the integral part
+    while (kappa > 0)
+    {
+        uint32_t div = static_cast<uint32_t>(Pow10[kappa - 1]);
+        uint32_t d = p1 / div;
+        p1 %= div;
+        if (d || length)
+            buffer[length++] = static_cast<char>('0' + d);
+        kappa--;
+        uint64_t rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta)
+        {
+            K += kappa;
+            GrisuRound(buffer, length, delta, rest, Pow10[kappa] << -one.e, wpW.f);
+            return;
+        }
+    }
+
+    // digits of the fractional part
+    for (;;)
+    {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if (d || length)
+            buffer[length++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta)
+        {
+            K += kappa;
+            int index = -kappa;
+            GrisuRound(buffer, length, delta, p2, one.f, wpW.f * (index < 20 ? Pow10[index] : 0));
+            return;
+        }
+    }
+}
+
+//! Generate the digits of f * 2^e, value = digits * 10^K
+/*!
+ *  hiddenBit is the implicit leading bit of a normal number of the type,
+ *  which is needed to find the boundaries of the values that round to the number.
+ */
+void Grisu2(uint64_t f, int e, uint64_t hiddenBit, char* buffer, int& length, int& K)
+{
+    const DiyFp v(f, e);
+
+    // boundaries halfway to the neighboring numbers, the lower one is closer at a power of two
+    DiyFp plus = DiyFp((v.f << 1) + 1, v.e - 1).Normalize();
+    DiyFp minus = (v.f == hiddenBit) ? DiyFp((v.f << 2) - 1, v.e - 2) : DiyFp((v.f << 1) - 1, v.e - 1);
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    const DiyFp cmk = GetCachedPower(plus.e, K);
+    const DiyFp W = v.Normalize() * cmk;
+    DiyFp Wp = plus * cmk;
+    DiyFp Wm = minus * cmk;
+    Wm.f++;
+    Wp.f--;
+    DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
+}
+
+char* WriteExponent(int K, char* buffer)
+{
+    // same layout as printf, at least two digits
+    *buffer++ = 'e';
+    if (K < 0)
+    {
+        *buffer++ = '-';
+        K = -K;
+    }
+    else
+        *buffer++ = '+';
+    if (K >= 100)
+    {
+        *buffer++ = static_cast<char>('0' + K / 100);
+        K %= 100;
+    }
+    *buffer++ = static_cast<char>('0' + K / 10);
+    *buffer++ = static_cast<char>('0' + K % 10);
+    return buffer;
+}
+
+//! Place the decimal point in the generated digits at the start of the buffer
+char* Prettify(char* buffer, int length, int K, bool allowExponent)
+{
+    int kk = length + K;  // 10^(kk-1) <= v < 10^kk
+
+    if (allowExponent && ((kk < -3) || (kk > 17)))
+    {
+        // d.ddde+NN
+        if (length > 1)
+        {
+            memmove(buffer + 2, buffer + 1, length - 1);
+            buffer[1] = '.';
+            length++;
+        }
+        return WriteExponent(kk - 1, buffer + length);
+    }
+    if (kk >= length)
+    {
+        // dddd000
+        memset(buffer + length, '0', kk - length);
+        return buffer + kk;
+    }
+    if (kk > 0)
+    {
+        // ddd.ddd
+        memmove(buffer + kk + 1, buffer + kk, length - kk);
+        buffer[kk] = '.';
+        return buffer + length + 1;
+    }
+    // 0.000ddd
+    int offset = 2 - kk;
+    memmove(buffer + offset, buffer, length);
+    buffer[0] = '0';
+    buffer[1] = '.';
+    memset(buffer + 2, '0', offset - 2);
+    return buffer + length + offset;
+}
+
+//! Write the sign and the values that don't have digits, returns null for a finite non-zero value
+char* WriteSpecial(bool negative, bool zero, bool infinity, bool nan, char*& buffer)
+{
+    if (nan)
+    {
+        memcpy(buffer, "nan", 3);
+        return buffer + 3;
+    }
+    if (negative)
+        *buffer++ = '-';
+    if (infinity)
+    {
+        memcpy(buffer, "inf", 3);
+        return buffer + 3;
+    }
+    if (zero)
+    {
+        *buffer = '0';
+        return buffer + 1;
+    }
+    return 0;
+}
+
+char* DoubleToBuffer(double value, char* buffer, bool allowExponent)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t hiddenBit = static_cast<uint64_t>(1) << 52;
+    uint64_t significand = bits & (hiddenBit - 1);
+    int biasedExponent = static_cast<int>((bits >> 52) & 0x7ff);
+
+    char* end = WriteSpecial((bits >> 63) != 0, (biasedExponent == 0) && (significand == 0),
+            (biasedExponent == 0x7ff) && (significand == 0), (biasedExponent == 0x7ff) && (significand != 0), buffer);
+    if (end)
+        return end;
+
+    int length, K;
+    if (biasedExponent != 0)
+        Grisu2(significand + hiddenBit, biasedExponent - 1075, hiddenBit, buffer, length, K);
+    else
+        Grisu2(significand, -1074, hiddenBit, buffer, length, K);
+    return Prettify(buffer, length, K, allowExponent);
+}
+
+} // namespace
+
+char* DoubleToString(double value, char* buffer)
+{
+    return DoubleToBuffer(value, buffer, true);
+}
+
+char* DoubleToFixedString(double value, char* buffer)
+{
+    return DoubleToBuffer(value, buffer, false);
+}
+
+char* FloatToString(float value, char* buffer)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t hiddenBit = static_cast<uint32_t>(1) << 23;
+    uint32_t significand = bits & (hiddenBit - 1);
+    int biasedExponent = static_cast<int>((bits >> 23) & 0xff);
+
+    char* end = WriteSpecial((bits >> 31) != 0, (biasedExponent == 0) && (significand == 0),
+            (biasedExponent == 0xff) && (significand == 0), (biasedExponent == 0xff) && (significand != 0), buffer);
+    if (end)
+        return end;
+
+    int length, K;
+    if (biasedExponent != 0)
+        Grisu2(significand + hiddenBit, biasedExponent - 150, hiddenBit, buffer, length, K);
+    else
+        Grisu2(significand, -149, hiddenBit, buffer, length, K);
+    return Prettify(buffer, length, K, true);
+}
+
+} // namespace internal
+} // namespace anyrpc
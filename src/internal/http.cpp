@@ -165,6 +165,7 @@ void HttpRequest::Initialize()
     method_.clear();
     requestUri_.clear();
     host_.clear();
+    timeout_ = -1;
 }
 
 HttpHeader::ResultEnum HttpRequest::ProcessFirstLine(std::string &first, std::string &second, std::string &third)
@@ -217,6 +218,15 @@ HttpHeader::ResultEnum HttpRequest::ProcessLine(std::string &key, std::string &v
         }
         host_ = value;
     }
+    else if (key.compare(ANYRPC_TIMEOUT_HEADER_KEY) == 0)
+    {
+        timeout_ = atoi(value.c_str());
+        if (timeout_ < 0)
+        {
+            log_warn("Invalid timeout specified: " << timeout_ << ", " << value);
+            timeout_ = -1;
+        }
+    }
     else if (key.compare("content-type") == 0)
     {
         if (contentType_.length() > 0)
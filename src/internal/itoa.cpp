@@ -0,0 +1,136 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/internal/itoa.h"
+
+namespace anyrpc
+{
+namespace internal
+{
+
+namespace
+{
+
+const char DigitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+unsigned CountDigits(uint32_t value)
+{
+    unsigned count = 1;
+    for (;;)
+    {
+        // four digits per step keeps the number of branches low for large values
+        if (value < 10) return count;
+        if (value < 100) return count + 1;
+        if (value < 1000) return count + 2;
+        if (value < 10000) return count + 3;
+        value /= 10000;
+        count += 4;
+    }
+}
+
+unsigned CountDigits(uint64_t value)
+{
+    unsigned count = 1;
+    for (;;)
+    {
+        if (value < 10) return count;
+        if (value < 100) return count + 1;
+        if (value < 1000) return count + 2;
+        if (value < 10000) return count + 3;
+        value /= 10000;
+        count += 4;
+    }
+}
+
+//! Write the digits backwards from the end, two at a time
+template <typename T>
+void WriteDigits(T value, char* end)
+{
+    while (value >= 100)
+    {
+        unsigned pair = static_cast<unsigned>(value % 100) * 2;
+        value /= 100;
+        *--end = DigitPairs[pair + 1];
+        *--end = DigitPairs[pair];
+    }
+    if (value >= 10)
+    {
+        unsigned pair = static_cast<unsigned>(value) * 2;
+        *--end = DigitPairs[pair + 1];
+        *--end = DigitPairs[pair];
+    }
+    else
+        *--end = static_cast<char>('0' + value);
+}
+
+} // namespace
+
+char* U32ToString(uint32_t value, char* buffer)
+{
+    char* end = buffer + CountDigits(value);
+    WriteDigits(value, end);
+    return end;
+}
+
+char* I32ToString(int32_t value, char* buffer)
+{
+    uint32_t u = static_cast<uint32_t>(value);
+    if (value < 0)
+    {
+        *buffer++ = '-';
+        u = ~u + 1;
+    }
+    return U32ToString(u, buffer);
+}
+
+char* U64ToString(uint64_t value, char* buffer)
+{
+    // the 32 bit arithmetic is faster on most processors
+    if (value <= 0xffffffff)
+        return U32ToString(static_cast<uint32_t>(value), buffer);
+    char* end = buffer + CountDigits(value);
+    WriteDigits(value, end);
+    return end;
+}
+
+char* I64ToString(int64_t value, char* buffer)
+{
+    uint64_t u = static_cast<uint64_t>(value);
+    if (value < 0)
+    {
+        *buffer++ = '-';
+        u = ~u + 1;
+    }
+    return U64ToString(u, buffer);
+}
+
+} // namespace internal
+} // namespace anyrpc
@@ -0,0 +1,278 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/internal/strscan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+# define ANYRPC_SCAN_SSE2
+# include <emmintrin.h>
+#endif
+
+// AVX2 is compiled for the individual function and only used when the processor supports it
+#if defined(ANYRPC_SCAN_SSE2) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5)))
+# define ANYRPC_SCAN_AVX2
+# include <immintrin.h>
+#endif
+
+namespace anyrpc
+{
+namespace internal
+{
+
+typedef std::size_t ScanFunction(const char* str, std::size_t length);
+
+static inline bool IsJsonSpecial(unsigned char c)
+{
+    return (c < 0x20) || (c == '\"') || (c == '\\');
+}
+
+static inline bool IsXmlSpecial(unsigned char c)
+{
+    if (c < 0x20)
+        return (c != '\t') && (c != '\n') && (c != '\r');
+    return (c == '<') || (c == '>') || (c == '&') || (c == '\'') || (c == '\"');
+}
+
+static std::size_t ScanJsonStringScalar(const char* str, std::size_t length)
+{
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(str);
+    std::size_t i = 0;
+    for (; i<length; i++)
+    {
+        if (IsJsonSpecial(s[i]))
+            break;
+    }
+    return i;
+}
+
+static std::size_t ScanJsonStringAsciiScalar(const char* str, std::size_t length)
+{
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(str);
+    std::size_t i = 0;
+    for (; i<length; i++)
+    {
+        if (IsJsonSpecial(s[i]) || (s[i] >= 0x80))
+            break;
+    }
+    return i;
+}
+
+static std::size_t ScanXmlStringScalar(const char* str, std::size_t length)
+{
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(str);
+    std::size_t i = 0;
+    for (; i<length; i++)
+    {
+        if (IsXmlSpecial(s[i]))
+            break;
+    }
+    return i;
+}
+
+#if defined(ANYRPC_SCAN_SSE2)
+static inline unsigned CountTrailingZeros(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+static inline unsigned JsonMaskSse2(__m128i s)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    // unsigned s <= 0x1f when max(s, 0x1f) == 0x1f
+    __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(s, quote), _mm_cmpeq_epi8(s, backslash)),
+                                   _mm_cmpeq_epi8(_mm_max_epu8(s, control), control));
+    return static_cast<unsigned>(_mm_movemask_epi8(special));
+}
+
+static inline unsigned JsonAsciiMaskSse2(__m128i s)
+{
+    // the sign bits are the characters outside of the ascii range
+    return JsonMaskSse2(s) | static_cast<unsigned>(_mm_movemask_epi8(s));
+}
+
+static inline unsigned XmlMaskSse2(__m128i s)
+{
+    const __m128i control = _mm_set1_epi8(0x1f);
+    __m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\n'))),
+                                      _mm_cmpeq_epi8(s, _mm_set1_epi8('\r')));
+    __m128i special = _mm_andnot_si128(whitespace, _mm_cmpeq_epi8(_mm_max_epu8(s, control), control));
+    special = _mm_or_si128(special, _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('<')), _mm_cmpeq_epi8(s, _mm_set1_epi8('>'))));
+    special = _mm_or_si128(special, _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8('&')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\''))));
+    special = _mm_or_si128(special, _mm_cmpeq_epi8(s, _mm_set1_epi8('\"')));
+    return static_cast<unsigned>(_mm_movemask_epi8(special));
+}
+
+template <unsigned (*Mask)(__m128i), ScanFunction* Scalar>
+static std::size_t ScanSse2(const char* str, std::size_t length)
+{
+    if (length < 16)
+        return Scalar(str, length);
+    std::size_t i = 0;
+    for (; i+16<=length; i+=16)
+    {
+        unsigned mask = Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i)));
+        if (mask != 0)
+            return i + CountTrailingZeros(mask);
+    }
+    if (i == length)
+        return length;
+    // the last block overlaps characters that were already checked, so only use the upper bits of the mask
+    unsigned mask = Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(str + length - 16))) >> (16 - (length - i));
+    return (mask != 0) ? i + CountTrailingZeros(mask) : length;
+}
+#endif // defined(ANYRPC_SCAN_SSE2)
+
+#if defined(ANYRPC_SCAN_AVX2)
+__attribute__((target("avx2")))
+static inline unsigned JsonMaskAvx2(__m256i s)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1f);
+    __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(s, quote), _mm256_cmpeq_epi8(s, backslash)),
+                                      _mm256_cmpeq_epi8(_mm256_max_epu8(s, control), control));
+    return static_cast<unsigned>(_mm256_movemask_epi8(special));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned JsonAsciiMaskAvx2(__m256i s)
+{
+    return JsonMaskAvx2(s) | static_cast<unsigned>(_mm256_movemask_epi8(s));
+}
+
+__attribute__((target("avx2")))
+static inline unsigned XmlMaskAvx2(__m256i s)
+{
+    // classify the characters with a table lookup for each nibble.  The bit for each high nibble
+    // (0x00, 0x10, 0x20, 0x30) is set in the low nibble table for the characters that need an escape.
+    const __m256i lowTable = _mm256_setr_epi8(3, 3, 7, 3, 3, 3, 7, 7, 3, 2, 2, 3, 11, 2, 11, 3,
+                                              3, 3, 7, 3, 3, 3, 7, 7, 3, 2, 2, 3, 11, 2, 11, 3);
+    const __m256i highTable = _mm256_setr_epi8(1, 2, 4, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                               1, 2, 4, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i low = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(s, nibble));
+    __m256i high = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(s, 4), nibble));
+    __m256i plain = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+    return ~static_cast<unsigned>(_mm256_movemask_epi8(plain));
+}
+
+template <unsigned (*Mask)(__m256i), ScanFunction* Sse2>
+__attribute__((target("avx2")))
+static std::size_t ScanAvx2(const char* str, std::size_t length)
+{
+    // the short strings are finished before any of the avx registers are used,
+    // since calling the sse2 code with the upper halves in use is very slow
+    if (length < 32)
+        return Sse2(str, length);
+    std::size_t i = 0;
+    for (; i+32<=length; i+=32)
+    {
+        unsigned mask = Mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i)));
+        if (mask != 0)
+            return i + CountTrailingZeros(mask);
+    }
+    if (i == length)
+        return length;
+    unsigned mask = Mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + length - 32))) >> (32 - (length - i));
+    return (mask != 0) ? i + CountTrailingZeros(mask) : length;
+}
+#endif // defined(ANYRPC_SCAN_AVX2)
+
+//! The scan functions for the implementation that the processor supports
+struct ScanFunctions
+{
+    const char* method;
+    ScanFunction* json;
+    ScanFunction* jsonAscii;
+    ScanFunction* xml;
+};
+
+//! Select the fastest implementation that the processor supports
+static ScanFunctions SelectScanFunctions()
+{
+#if defined(ANYRPC_SCAN_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        ScanFunctions functions = { "avx2",
+                                    &ScanAvx2<JsonMaskAvx2, ScanSse2<JsonMaskSse2, ScanJsonStringScalar> >,
+                                    &ScanAvx2<JsonAsciiMaskAvx2, ScanSse2<JsonAsciiMaskSse2, ScanJsonStringAsciiScalar> >,
+                                    &ScanAvx2<XmlMaskAvx2, ScanSse2<XmlMaskSse2, ScanXmlStringScalar> > };
+        return functions;
+    }
+#endif
+#if defined(ANYRPC_SCAN_SSE2)
+    ScanFunctions functions = { "sse2",
+                                &ScanSse2<JsonMaskSse2, ScanJsonStringScalar>,
+                                &ScanSse2<JsonAsciiMaskSse2, ScanJsonStringAsciiScalar>,
+                                &ScanSse2<XmlMaskSse2, ScanXmlStringScalar> };
+#else
+    ScanFunctions functions = { "scalar", &ScanJsonStringScalar, &ScanJsonStringAsciiScalar, &ScanXmlStringScalar };
+#endif
+    return functions;
+}
+
+//! Get the scan functions, selected on the first call so they can also be used during static initialization
+static const ScanFunctions& GetScanFunctions()
+{
+    static const ScanFunctions scanFunctions = SelectScanFunctions();
+    return scanFunctions;
+}
+
+// short strings are faster without the call to the vector function
+
+std::size_t ScanJsonString(const char* str, std::size_t length)
+{
+    if (length < 16)
+        return ScanJsonStringScalar(str, length);
+    return GetScanFunctions().json(str, length);
+}
+
+std::size_t ScanJsonStringAscii(const char* str, std::size_t length)
+{
+    if (length < 16)
+        return ScanJsonStringAsciiScalar(str, length);
+    return GetScanFunctions().jsonAscii(str, length);
+}
+
+std::size_t ScanXmlString(const char* str, std::size_t length)
+{
+    if (length < 16)
+        return ScanXmlStringScalar(str, length);
+    return GetScanFunctions().xml(str, length);
+}
+
+const char* ScanStringMethod()
+{
+    return GetScanFunctions().method;
+}
+
+} // namespace internal
+} // namespace anyrpc
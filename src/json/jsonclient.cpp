@@ -30,6 +30,7 @@
 #include "anyrpc/method.h"
 #include "anyrpc/socket.h"
 #include "anyrpc/client.h"
+#include "anyrpc/balancedclient.h"
 #include "anyrpc/json/jsonwriter.h"
 #include "anyrpc/json/jsonreader.h"
 #include "anyrpc/json/jsonclient.h"
@@ -62,7 +63,7 @@ bool JsonClientHandler::GenerateRequest(const char* method, Value& params, Strea
     Value request;
     request["jsonrpc"] = "2.0";
     request["method"] = method;
-    request["params"].Assign(params);   // assign so that the structure doesn't need to be copied
+    // the id is written before the params so that a server that rejects the params while parsing can return it
     if (!notification)
     {
         requestId = GetNextId();
@@ -70,6 +71,7 @@ bool JsonClientHandler::GenerateRequest(const char* method, Value& params, Strea
     }
     else
         requestId = 0;
+    request["params"].Assign(params);   // assign so that the structure doesn't need to be copied
 
     JsonWriter jsonStrWriter(os);
     request.Traverse(jsonStrWriter);
@@ -105,47 +107,124 @@ ProcessResponseEnum JsonClientHandler::ProcessResponse(char* response, size_t le
             log_debug( "Parsed: " << message );
 
             if (message.IsMap())
+                processResponse = ProcessResponseMessage(message, result, requestId);
+            else if (message.IsInvalid() && notification)
             {
-                if (!message.HasMember("jsonrpc"))
-                    GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, missing jsonrpc member", result);
-                else if (!message.HasMember("id"))
-                    GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, missing id member", result);
-                else
-                {
-                    Value& id = message["id"];
-                    Value& rpc = message["jsonrpc"];
+                // response from notification with transport that required a response
+                processResponse = ProcessResponseSuccess;
+            }
+            else
+            {
+                log_debug("message type = " << message.GetType());
+                GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, wrong message type", result);
+            }
+        }
+    }
+    catch (AnyRpcException &fault)
+    {
+        std::stringstream buffer;
+        buffer << "Unhandled system error, Code:" << fault.GetCode() << ", Message:" << fault.GetMessage();
+        GenerateFaultResult(AnyRpcErrorSystemError, buffer.str(), result);
+    }
 
-                    if (!rpc.IsString() || (strcmp(rpc.GetString(), "2.0") != 0))
-                        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, rpc version", result);
-                    else if (!id.IsUint() || (id.GetUint() != requestId))
-                    {
-                        log_debug("Invalid id:" << id << ", expected id=" << requestId);
-                        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, bad id", result);
-                    }
-                    else if (message.HasMember("error"))
-                    {
-                        result.Assign(message["error"]);
-                        if (result.HasMember("code") && result["code"].IsInt())
-                        {
-                            int code = result["code"].GetInt();
-                            // keep the close open if only an application type of error
-                            if ((code > AnyRpcErrorTransportError) || (code < AnyRpcErrorApplicationError))
-                                processResponse = ProcessResponseErrorKeepOpen;
-                        }
-                    }
-                    else if (!message.HasMember("result"))
-                        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, no result", result);
-                    else
+    return processResponse;
+}
+
+bool JsonClientHandler::GenerateBatchRequest(Batch& batch, Stream& os, std::vector<unsigned>& requestIds)
+{
+    log_trace();
+    Value request;
+    request.SetSize(batch.GetSize());
+    requestIds.resize(batch.GetSize());
+    for (std::size_t i=0; i<batch.GetSize(); i++)
+    {
+        requestIds[i] = GetNextId();
+        request[i]["jsonrpc"] = "2.0";
+        request[i]["method"] = batch.GetMethod(i);
+        request[i]["id"] = requestIds[i];
+        request[i]["params"].Assign(batch.GetParams(i));
+    }
+
+    JsonWriter jsonStrWriter(os);
+    request.Traverse(jsonStrWriter);
+
+    // move the params back so they are still available in the batch
+    for (std::size_t i=0; i<batch.GetSize(); i++)
+        batch.GetParams(i).Assign(request[i]["params"]);
+
+    return true;
+}
+
+ProcessResponseEnum JsonClientHandler::ProcessBatchResponse(char* response, size_t length, Batch& batch, std::vector<unsigned>& requestIds)
+{
+    log_trace();
+    ProcessResponseEnum processResponse = ProcessResponseErrorClose;
+    Value result;
+    try
+    {
+        Document doc;
+
+        InSituStringStream sstream(response, length);
+        JsonReader reader(sstream);
+        reader.ParseStream(doc);
+        if (reader.HasParseError())
+        {
+            std::stringstream message;
+            message << "Response parse error, offset=" << reader.GetErrorOffset();
+            message << ", code=" << reader.GetParseErrorCode();
+            message << ", message=" << reader.GetParseErrorStr();
+            GenerateFaultResult(AnyRpcErrorResponseParseError, message.str(), result);
+        }
+        else
+        {
+            Value message;
+            message.Assign( doc.GetValue() );
+            log_debug( "Parsed: " << message );
+
+            if (message.IsArray())
+            {
+                // the responses can be in any order so match them to the calls by id
+                std::map<unsigned, std::size_t> callIndex;
+                for (std::size_t i=0; i<requestIds.size(); i++)
+                    callIndex[requestIds[i]] = i;
+
+                Value missing;
+                GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, no response for the call", missing);
+                batch.SetAllResults(missing, false);
+
+                processResponse = ProcessResponseSuccess;
+                std::size_t numResponses = 0;
+                for (std::size_t i=0; i<message.Size(); i++)
+                {
+                    Value& single = message[i];
+                    const Value* id = single.Get("id");
+                    if ((id == 0) || !id->IsUint())
+                        continue;
+                    std::map<unsigned, std::size_t>::iterator it = callIndex.find(id->GetUint());
+                    if (it == callIndex.end())
                     {
-                        result.Assign(message["result"]);
-                        processResponse = ProcessResponseSuccess;
+                        log_debug("Unexpected id:" << *id);
+                        continue;
                     }
+                    Value singleResult;
+                    ProcessResponseEnum singleResponse = ProcessResponseMessage(single, singleResult, requestIds[it->second]);
+                    // the result references the receive buffer which is reused for the next response
+                    Value resultCopy;
+                    resultCopy.Copy(singleResult);
+                    batch.SetResult(it->second, resultCopy, (singleResponse == ProcessResponseSuccess));
+                    if (singleResponse > processResponse)
+                        processResponse = singleResponse;
+                    callIndex.erase(it);
+                    numResponses++;
                 }
+                if ((numResponses < requestIds.size()) && (processResponse == ProcessResponseSuccess))
+                    processResponse = ProcessResponseErrorKeepOpen;
+                return processResponse;
             }
-            else if (message.IsInvalid() && notification)
+            else if (message.Get("error") != 0)
             {
-                // response from notification with transport that required a response
-                processResponse = ProcessResponseSuccess;
+                // a single error applies to the entire batch, typically a parse failure
+                result.Assign(*message.Get("error"));
             }
             else
             {
@@ -161,6 +240,53 @@ ProcessResponseEnum JsonClientHandler::ProcessResponse(char* response, size_t le
         GenerateFaultResult(AnyRpcErrorSystemError, buffer.str(), result);
     }
 
+    batch.SetAllResults(result, false);
+    return processResponse;
+}
+
+ProcessResponseEnum JsonClientHandler::ProcessResponseMessage(Value& message, Value& result, unsigned requestId)
+{
+    ProcessResponseEnum processResponse = ProcessResponseErrorClose;
+
+    // find the envelope members with a single pass without adding any that are missing
+    static const char* const keys[] = { "jsonrpc", "id", "error", "result" };
+    Value* members[4];
+    message.GetMembers(keys, 4, members);
+    Value* rpc = members[0];
+    Value* id = members[1];
+    Value* error = members[2];
+    Value* msgResult = members[3];
+
+    if (rpc == 0)
+        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, missing jsonrpc member", result);
+    else if (id == 0)
+        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, missing id member", result);
+    else if (!rpc->IsString() || (strcmp(rpc->GetString(), "2.0") != 0))
+        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, rpc version", result);
+    else if (!id->IsUint() || (id->GetUint() != requestId))
+    {
+        log_debug("Invalid id:" << *id << ", expected id=" << requestId);
+        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, bad id", result);
+    }
+    else if (error != 0)
+    {
+        result.Assign(*error);
+        const Value* codeValue = result.Get("code");
+        if ((codeValue != 0) && codeValue->IsInt())
+        {
+            int code = codeValue->GetInt();
+            // keep the close open if only an application type of error
+            if ((code > AnyRpcErrorTransportError) || (code < AnyRpcErrorApplicationError))
+                processResponse = ProcessResponseErrorKeepOpen;
+        }
+    }
+    else if (msgResult == 0)
+        GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, no result", result);
+    else
+    {
+        result.Assign(*msgResult);
+        processResponse = ProcessResponseSuccess;
+    }
     return processResponse;
 }
 
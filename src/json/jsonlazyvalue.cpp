@@ -0,0 +1,396 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/value.h"
+#include "anyrpc/stream.h"
+#include "anyrpc/handler.h"
+#include "anyrpc/reader.h"
+#include "anyrpc/document.h"
+#include "anyrpc/method.h"
+#include "anyrpc/json/jsonreader.h"
+#include "anyrpc/json/jsonlazyvalue.h"
+#include "anyrpc/internal/strtod.h"
+#include "anyrpc/internal/strscan.h"
+#include "anyrpc/json/jsonparser.h"
+
+namespace anyrpc
+{
+
+static inline bool IsWhiteSpace(char c)
+{
+    return (internal::JsonCharClass(c) & internal::JsonWhiteSpace) != 0;
+}
+
+static const char* SkipWhiteSpace(const char* p, const char* end)
+{
+    while ((p < end) && IsWhiteSpace(*p))
+        p++;
+    return p;
+}
+
+//! Find the end of the string that starts at the quote and return the position after the closing quote
+static const char* SkipString(const char* p, const char* end)
+{
+    const char* quote = p + 1;
+    while (true)
+    {
+        quote = static_cast<const char*>(memchr(quote, '\"', end - quote));
+        if (quote == 0)
+            anyrpc_throw(AnyRpcErrorStringMissingQuotationMark, "Missing end of string");
+        // the quote is escaped when it follows an odd number of backslashes
+        const char* backslash = quote;
+        while ((backslash > p + 1) && (backslash[-1] == '\\'))
+            backslash--;
+        if (((quote - backslash) & 1) == 0)
+            return quote + 1;
+        quote++;
+    }
+}
+
+//! Find the end of the value that starts at the position without decoding it
+static const char* SkipValue(const char* p, const char* end)
+{
+    if (p >= end)
+        anyrpc_throw(AnyRpcErrorValueInvalid, "Missing value");
+    if (*p == '\"')
+        return SkipString(p, end);
+    if ((*p != '{') && (*p != '['))
+    {
+        // number or literal
+        while ((p < end) && !IsWhiteSpace(*p) && (*p != ',') && (*p != ']') && (*p != '}'))
+            p++;
+        return p;
+    }
+
+    // only the strings and brackets matter to find the end of a map or array
+    std::size_t depth = 0;
+    while (p < end)
+    {
+        char c = *p;
+        if (c == '\"')
+        {
+            p = SkipString(p, end);
+            continue;
+        }
+        if ((c == '{') || (c == '['))
+            depth++;
+        else if ((c == '}') || (c == ']'))
+        {
+            if (--depth == 0)
+                return p + 1;
+        }
+        p++;
+    }
+    anyrpc_throw(AnyRpcErrorParseError, "Missing end of map or array");
+}
+
+//! Parse the Json text to the handler, in situ if the text can be modified
+static void ParseText(char* text, std::size_t length, Handler& handler, bool inSitu)
+{
+    InSituStringStream is(text, length, inSitu);
+    JsonReader reader(is);
+    reader.ParseStream(handler);
+    if (reader.HasParseError())
+        throw AnyRpcException(reader.GetParseErrorCode(), reader.GetParseErrorStr());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+JsonLazyValue::JsonLazyValue() :
+    text_(0), length_(0), value_(0), ownsValue_(false), parent_(0), textModified_(false), indexed_(false), hint_(0)
+{
+}
+
+JsonLazyValue::JsonLazyValue(char* json, std::size_t length) :
+    text_(json), length_(length), value_(0), ownsValue_(false), parent_(0), textModified_(false), indexed_(false), hint_(0)
+{
+    while ((length_ > 0) && IsWhiteSpace(*text_))
+    {
+        text_++;
+        length_--;
+    }
+}
+
+JsonLazyValue::JsonLazyValue(char* json, std::size_t length, JsonLazyValue* parent) :
+    text_(json), length_(length), value_(0), ownsValue_(false), parent_(parent), textModified_(false), indexed_(false), hint_(0)
+{
+}
+
+JsonLazyValue::JsonLazyValue(Value& value) :
+    text_(0), length_(0), value_(&value), ownsValue_(false), parent_(0), textModified_(false), indexed_(false), hint_(0)
+{
+}
+
+JsonLazyValue::~JsonLazyValue()
+{
+    for (std::size_t i=0; i<parts_.size(); i++)
+        delete parts_[i].value;
+    if (ownsValue_)
+        delete value_;
+}
+
+ValueType JsonLazyValue::GetType() const
+{
+    if (value_ != 0)
+        return value_->GetType();
+    if ((text_ == 0) || (length_ == 0))
+        return InvalidType;
+    switch (*text_)
+    {
+        case '{': return MapType;
+        case '[': return ArrayType;
+        case '\"': return StringType;
+        case 'n': return NullType;
+        case 't': return TrueType;
+        case 'f': return FalseType;
+        default: return NumberType;
+    }
+}
+
+const char* JsonLazyValue::GetText(std::size_t& length) const
+{
+    if ((value_ != 0) || textModified_ || (text_ == 0))
+    {
+        length = 0;
+        return 0;
+    }
+    length = length_;
+    return text_;
+}
+
+Value& JsonLazyValue::GetValue()
+{
+    if (value_ != 0)
+        return *value_;
+
+    log_debug("GetValue: length=" << length_ << ", indexed=" << indexed_);
+    // parsing in situ modifies the text of the maps and arrays that contain this value
+    for (JsonLazyValue* parent = parent_; parent != 0; parent = parent->parent_)
+        parent->textModified_ = true;
+
+    Value* value = new Value;
+    if (!indexed_)
+    {
+        anyrpc_assert(!textModified_, AnyRpcErrorParseError, "Text is no longer available");
+        if (text_ != 0)
+        {
+            textModified_ = true;
+            try
+            {
+                Document doc;
+                ParseText(text_, length_, doc, true);
+                value->Assign(doc.GetValue());
+            }
+            catch (const AnyRpcException&)
+            {
+                delete value;
+                throw;
+            }
+        }
+    }
+    else
+    {
+        // the parts may already be parsed in situ so the value is built from them
+        try
+        {
+            if (IsMap())
+            {
+                value->SetMap();
+                for (std::size_t i=0; i<parts_.size(); i++)
+                    (*value)[parts_[i].key].Assign(parts_[i].value->GetValue());
+            }
+            else
+            {
+                value->SetArray(parts_.size());
+                value->SetSize(parts_.size());
+                for (std::size_t i=0; i<parts_.size(); i++)
+                    (*value)[i].Assign(parts_[i].value->GetValue());
+            }
+        }
+        catch (const AnyRpcException&)
+        {
+            delete value;
+            throw;
+        }
+        // the parts now use the values that were moved into this value
+        for (std::size_t i=0; i<parts_.size(); i++)
+        {
+            if (value->IsMap())
+                parts_[i].value->MoveToParent(&(*value)[parts_[i].key]);
+            else
+                parts_[i].value->MoveToParent(&(*value)[i]);
+        }
+    }
+    value_ = value;
+    ownsValue_ = true;
+    return *value_;
+}
+
+void JsonLazyValue::Traverse(Handler& handler)
+{
+    if ((value_ == 0) && (text_ != 0) && !textModified_)
+        ParseText(text_, length_, handler, false);
+    else
+        GetValue().Traverse(handler);
+}
+
+JsonLazyValue* JsonLazyValue::Get(const char* key)
+{
+    anyrpc_assert(IsMap(), AnyRpcErrorValueAccess, "Not map, type=" << GetType());
+    Index();
+    std::size_t size = parts_.size();
+    for (std::size_t n=0; n<size; n++)
+    {
+        std::size_t i = (hint_ + n) % size;
+        if (parts_[i].key == key)
+        {
+            hint_ = i + 1;
+            return parts_[i].value;
+        }
+    }
+    return 0;
+}
+
+std::size_t JsonLazyValue::Size()
+{
+    Index();
+    return parts_.size();
+}
+
+JsonLazyValue& JsonLazyValue::operator[](std::size_t index)
+{
+    anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not array, type=" << GetType());
+    Index();
+    anyrpc_assert(index < parts_.size(), AnyRpcErrorIllegalArrayAccess, "Index out of range, index=" << index << ", size=" << parts_.size());
+    return *parts_[index].value;
+}
+
+void JsonLazyValue::Index()
+{
+    if (indexed_)
+        return;
+    if (value_ != 0)
+    {
+        IndexValue();
+        return;
+    }
+
+    bool isMap = IsMap();
+    anyrpc_assert(isMap || IsArray(), AnyRpcErrorValueAccess, "Not map or array, type=" << GetType());
+    log_debug("Index: length=" << length_);
+    const char* end = text_ + length_;
+    const char* p = SkipWhiteSpace(text_ + 1, end);
+    char close = isMap ? '}' : ']';
+    if ((p < end) && (*p == close))
+    {
+        indexed_ = true;
+        return;
+    }
+
+    while (true)
+    {
+        Part part;
+        if (isMap)
+        {
+            if ((p >= end) || (*p != '\"'))
+                anyrpc_throw(AnyRpcErrorObjectMissName, "Missing a name for a map member");
+            const char* keyEnd = SkipString(p, end);
+            if (memchr(p, '\\', keyEnd - p) == 0)
+                part.key.assign(p + 1, keyEnd - p - 2);
+            else
+            {
+                // decode the escapes to a copy so that the text isn't modified
+                Document doc;
+                ParseText(const_cast<char*>(p), keyEnd - p, doc, false);
+                part.key.assign(doc.GetValue().GetString(), doc.GetValue().GetStringLength());
+            }
+            p = SkipWhiteSpace(keyEnd, end);
+            if ((p >= end) || (*p != ':'))
+                anyrpc_throw(AnyRpcErrorObjectMissColon, "Missing a colon after a map member name");
+            p = SkipWhiteSpace(p + 1, end);
+        }
+        const char* valueEnd = SkipValue(p, end);
+        part.value = new JsonLazyValue(const_cast<char*>(p), valueEnd - p, this);
+        parts_.push_back(part);
+
+        p = SkipWhiteSpace(valueEnd, end);
+        if ((p < end) && (*p == ','))
+        {
+            p = SkipWhiteSpace(p + 1, end);
+            continue;
+        }
+        if ((p >= end) || (*p != close))
+        {
+            if (isMap)
+                anyrpc_throw(AnyRpcErrorObjectMissCommaOrCurlyBracket, "Missing a comma or } after a map member");
+            anyrpc_throw(AnyRpcErrorArrayMissCommaOrSquareBracket, "Missing a comma or ] after an array element");
+        }
+        break;
+    }
+    indexed_ = true;
+}
+
+void JsonLazyValue::IndexValue()
+{
+    if (value_->IsMap())
+    {
+        for (MemberIterator it = value_->MemberBegin(); it != value_->MemberEnd(); ++it)
+        {
+            Part part;
+            part.key.assign(it.GetKey().GetString(), it.GetKey().GetStringLength());
+            part.value = new JsonLazyValue(it.GetValue());
+            part.value->parent_ = this;
+            parts_.push_back(part);
+        }
+    }
+    else
+    {
+        anyrpc_assert(value_->IsArray(), AnyRpcErrorValueAccess, "Not map or array, type=" << value_->GetType());
+        for (std::size_t i=0; i<value_->Size(); i++)
+        {
+            Part part;
+            part.value = new JsonLazyValue((*value_)[i]);
+            part.value->parent_ = this;
+            parts_.push_back(part);
+        }
+    }
+    indexed_ = true;
+}
+
+void JsonLazyValue::MoveToParent(Value* value)
+{
+    if (ownsValue_)
+        delete value_;
+    value_ = value;
+    ownsValue_ = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void JsonLazyMethod::Execute(Value& params, Value& result)
+{
+    JsonLazyValue lazyParams(params);
+    ExecuteLazy(lazyParams, result);
+}
+
+} // namespace anyrpc
@@ -0,0 +1,376 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/value.h"
+#include "anyrpc/stream.h"
+#include "anyrpc/handler.h"
+#include "anyrpc/json/jsonpushparser.h"
+#include "anyrpc/internal/strtod.h"
+#include "anyrpc/internal/strscan.h"
+#include "anyrpc/json/jsonparser.h"
+
+namespace anyrpc
+{
+
+//! Characters that end a number or literal
+static inline bool IsScalarEnd(char c)
+{
+    return (internal::JsonCharClass(c) & internal::JsonWhiteSpace) || (c == ',') || (c == ']') || (c == '}');
+}
+
+//! Find the end of a number or literal.  Return npos if it might continue in the next piece.
+static std::size_t FindScalarEnd(const char* data, std::size_t length, std::size_t pos)
+{
+    while (pos < length)
+    {
+        if (IsScalarEnd(data[pos]))
+            return pos;
+        pos++;
+    }
+    return std::string::npos;
+}
+
+void JsonPushParser::Reset()
+{
+    state_ = ExpectValue;
+    stack_.clear();
+    token_ = NoToken;
+    tokenStr_.clear();
+    escaped_ = false;
+    started_ = false;
+    offset_ = 0;
+    parseError_.Clear();
+}
+
+bool JsonPushParser::Parse(const char* data, std::size_t length)
+{
+    log_debug("Parse: length=" << length << ", offset=" << offset_);
+    if (HasParseError())
+        return false;
+
+    if (!started_)
+    {
+        handler_.StartDocument();
+        started_ = true;
+    }
+
+    std::size_t pos = 0;
+    try
+    {
+        ParseData(data, length, pos);
+    }
+    catch (AnyRpcException &fault)
+    {
+        SetParseError(fault, pos);
+    }
+    offset_ += length;
+    return !HasParseError();
+}
+
+bool JsonPushParser::Finish()
+{
+    log_debug("Finish: offset=" << offset_);
+    if (!started_)
+    {
+        handler_.StartDocument();
+        started_ = true;
+    }
+
+    try
+    {
+        if (!HasParseError())
+        {
+            // a number or literal at the end of the data is only complete now
+            if (token_ != NoToken)
+            {
+                Token token = token_;
+                token_ = NoToken;
+                ParseToken(tokenStr_.data(), tokenStr_.length(), token);
+            }
+
+            // report the same errors as the JsonReader for an incomplete document
+            switch (state_)
+            {
+                case ExpectValue:
+                case ExpectValueOrEnd:
+                    if (!stack_.empty())
+                        anyrpc_throw(AnyRpcErrorValueInvalid, "Invalid value");
+                    break;
+                case ExpectKey:
+                case ExpectKeyOrEnd:
+                    anyrpc_throw(AnyRpcErrorObjectMissName, "Missing a name for object member");
+                case ExpectColon:
+                    anyrpc_throw(AnyRpcErrorObjectMissColon, "Missing a colon after a name of object member");
+                case ExpectCommaOrEnd:
+                    if (stack_.back().isMap_)
+                        anyrpc_throw(AnyRpcErrorObjectMissCommaOrCurlyBracket, "Missing a comma or '}' after an object member");
+                    anyrpc_throw(AnyRpcErrorArrayMissCommaOrSquareBracket, "Missing a comma or ']' after an array element");
+                case Complete:
+                    break;
+            }
+        }
+    }
+    catch (AnyRpcException &fault)
+    {
+        SetParseError(fault, 0);
+    }
+
+    handler_.EndDocument();
+    return !HasParseError();
+}
+
+void JsonPushParser::ParseData(const char* data, std::size_t length, std::size_t& pos)
+{
+    // finish the token that was started in the previous piece
+    if (token_ != NoToken)
+    {
+        std::size_t end = (token_ == ScalarToken) ? FindScalarEnd(data, length, 0) : FindStringEnd(data, length, 0);
+        if (end == std::string::npos)
+        {
+            tokenStr_.append(data, length);
+            pos = length;
+            return;
+        }
+        tokenStr_.append(data, end);
+        Token token = token_;
+        token_ = NoToken;
+        ParseToken(tokenStr_.data(), tokenStr_.length(), token);
+        pos = end;
+    }
+
+    while (pos < length)
+    {
+        char c = data[pos];
+        if (internal::JsonCharClass(c) & internal::JsonWhiteSpace)
+        {
+            pos++;
+            continue;
+        }
+
+        switch (state_)
+        {
+            case ExpectValueOrEnd:
+                if (c == ']')
+                {
+                    pos++;
+                    stack_.pop_back();
+                    handler_.EndArray(0); // empty array
+                    EndValue();
+                    break;
+                }
+                // fall through
+            case ExpectValue:
+                if (c == '{')
+                {
+                    pos++;
+                    handler_.StartMap();
+                    stack_.push_back(Container(true));
+                    state_ = ExpectKeyOrEnd;
+                }
+                else if (c == '[')
+                {
+                    pos++;
+                    handler_.StartArray();
+                    stack_.push_back(Container(false));
+                    state_ = ExpectValueOrEnd;
+                }
+                else if (c == '\"')
+                    pos = StartToken(data, length, pos, StringToken);
+                else
+                    pos = StartToken(data, length, pos, ScalarToken);
+                break;
+
+            case ExpectKeyOrEnd:
+                if (c == '}')
+                {
+                    pos++;
+                    stack_.pop_back();
+                    handler_.EndMap(0);  // empty object
+                    EndValue();
+                    break;
+                }
+                // fall through
+            case ExpectKey:
+                if (c != '\"')
+                    anyrpc_throw(AnyRpcErrorObjectMissName, "Missing a name for object member");
+                pos = StartToken(data, length, pos, KeyToken);
+                break;
+
+            case ExpectColon:
+                if (c != ':')
+                    anyrpc_throw(AnyRpcErrorObjectMissColon, "Missing a colon after a name of object member");
+                pos++;
+                state_ = ExpectValue;
+                break;
+
+            case ExpectCommaOrEnd:
+            {
+                Container& top = stack_.back();
+                if (c == ',')
+                {
+                    pos++;
+                    if (top.isMap_)
+                    {
+                        handler_.MapSeparator();
+                        state_ = ExpectKey;
+                    }
+                    else
+                    {
+                        handler_.ArraySeparator();
+                        state_ = ExpectValue;
+                    }
+                }
+                else if (top.isMap_ && (c == '}'))
+                {
+                    pos++;
+                    std::size_t memberCount = top.count_;
+                    stack_.pop_back();
+                    handler_.EndMap(memberCount);
+                    EndValue();
+                }
+                else if (!top.isMap_ && (c == ']'))
+                {
+                    pos++;
+                    std::size_t elementCount = top.count_;
+                    stack_.pop_back();
+                    handler_.EndArray(elementCount);
+                    EndValue();
+                }
+                else if (top.isMap_)
+                    anyrpc_throw(AnyRpcErrorObjectMissCommaOrCurlyBracket, "Missing a comma or '}' after an object member");
+                else
+                    anyrpc_throw(AnyRpcErrorArrayMissCommaOrSquareBracket, "Missing a comma or ']' after an array element");
+                break;
+            }
+
+            case Complete:
+                // the rest of the data is ignored as with the JsonReader
+                pos = length;
+                break;
+        }
+    }
+}
+
+std::size_t JsonPushParser::StartToken(const char* data, std::size_t length, std::size_t pos, Token token)
+{
+    std::size_t end;
+    if (token == ScalarToken)
+        end = FindScalarEnd(data, length, pos + 1);
+    else
+    {
+        escaped_ = false;
+        end = FindStringEnd(data, length, pos + 1);
+    }
+
+    if (end == std::string::npos)
+    {
+        // keep the start of the token until the rest of it is received
+        token_ = token;
+        tokenStr_.assign(data + pos, length - pos);
+        return length;
+    }
+
+    // decode the complete token directly from the data
+    ParseToken(data + pos, end - pos, token);
+    return end;
+}
+
+std::size_t JsonPushParser::FindStringEnd(const char* data, std::size_t length, std::size_t pos)
+{
+    if (escaped_)
+    {
+        // the previous piece ended with a backslash
+        if (pos >= length)
+            return std::string::npos;
+        escaped_ = false;
+        pos++;
+    }
+
+    for (;;)
+    {
+        pos += internal::ScanJsonString(data + pos, length - pos);
+        if (pos >= length)
+            return std::string::npos;
+        char c = data[pos++];
+        if (c == '\"')
+            return pos;
+        if (c == '\\')
+        {
+            // skip the escaped character, which may be in the next piece
+            if (pos >= length)
+            {
+                escaped_ = true;
+                return std::string::npos;
+            }
+            pos++;
+        }
+        // a control character is reported when the string is decoded
+    }
+}
+
+void JsonPushParser::ParseToken(const char* str, std::size_t length, Token token)
+{
+    // the JsonReader code decodes the token from a copy so the data is not modified
+    internal::JsonBufferInput input(const_cast<char*>(str), length);
+    internal::JsonParser<internal::JsonBufferInput> parser(input, handler_, false, true);
+    switch (token)
+    {
+        case KeyToken:
+            parser.ParseKey();
+            state_ = ExpectColon;
+            return;
+        case StringToken:
+            parser.ParseString();
+            break;
+        default:
+            parser.ParseValue();
+            // characters that don't belong to the number or literal
+            if ((input.Tell() < length) && !stack_.empty())
+            {
+                if (stack_.back().isMap_)
+                    anyrpc_throw(AnyRpcErrorObjectMissCommaOrCurlyBracket, "Missing a comma or '}' after an object member");
+                anyrpc_throw(AnyRpcErrorArrayMissCommaOrSquareBracket, "Missing a comma or ']' after an array element");
+            }
+            break;
+    }
+    EndValue();
+}
+
+void JsonPushParser::EndValue()
+{
+    if (stack_.empty())
+        state_ = Complete;
+    else
+    {
+        stack_.back().count_++;
+        state_ = ExpectCommaOrEnd;
+    }
+}
+
+void JsonPushParser::SetParseError(AnyRpcException& fault, std::size_t pos)
+{
+    log_error("catch exception, stream offset=" << offset_ + pos);
+    fault.SetOffset(offset_ + pos);
+    parseError_ = fault;
+}
+
+} // namespace anyrpc
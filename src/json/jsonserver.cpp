@@ -21,23 +21,32 @@
 #include "anyrpc/api.h"
 #include "anyrpc/logger.h"
 #include "anyrpc/error.h"
+#include "anyrpc/arena.h"
 #include "anyrpc/value.h"
 #include "anyrpc/stream.h"
 #include "anyrpc/handler.h"
 #include "anyrpc/reader.h"
 #include "anyrpc/document.h"
+#include "anyrpc/paramschema.h"
 #include "anyrpc/method.h"
 #include "anyrpc/socket.h"
 #include "anyrpc/connection.h"
 #include "anyrpc/server.h"
 #include "anyrpc/json/jsonwriter.h"
 #include "anyrpc/json/jsonreader.h"
+#include "anyrpc/json/jsonpushparser.h"
+#include "anyrpc/json/jsonlazyvalue.h"
 #include "anyrpc/json/jsonserver.h"
 
 namespace anyrpc
 {
 
-static void JsonExecuteSingleRequest(MethodManager* manager, Value& message, Value& response);
+static bool JsonProcessRequest(MethodManager* manager, char* request, size_t length, Stream &response);
+static bool JsonProcessDocument(MethodManager* manager, const AnyRpcException& parseError, Document& doc, Stream &response,
+                                bool paramsValidated=false);
+static void JsonExecuteSingleRequest(MethodManager* manager, Value& message, Value& response, bool paramsValidated);
+static bool JsonProcessLazyRequest(MethodManager* manager, JsonLazyValue& message, Stream &response);
+static void JsonExecuteLazyRequest(MethodManager* manager, JsonLazyValue& message, Value& response);
 static void JsonGenerateResponse(Value& result, Value& id, Value& response);
 static void JsonGenerateFaultResponse(int errorCode, std::string const& errorMsg, Value& id, Value& response);
 
@@ -47,15 +56,101 @@ log_define("AnyRPC.RpcHandler");
 
 bool JsonRpcHandler(MethodManager* manager, char* request, size_t length, Stream &response)
 {
+    bool sendResponse = JsonProcessRequest(manager, request, length, response);
+
+    // the values for the request have been destroyed so the arena space can be reused
+    MemoryArena* arena = MemoryArena::GetCurrent();
+    if (arena != 0)
+        arena->Reset();
+    return sendResponse;
+}
+
+//! Parse the request with the JsonPushParser as it is received
+class JsonRpcRequestParser : public RpcRequestParser
+{
+public:
+    JsonRpcRequestParser() : parser_(doc_) {}
+
+    virtual void Parse(const char* data, std::size_t length) { parser_.Parse(data, length); }
+    virtual bool Execute(MethodManager* manager, Stream &response)
+    {
+        parser_.Finish();
+        AnyRpcException parseError(parser_.GetParseErrorCode(), parser_.GetParseErrorStr());
+        return JsonProcessDocument(manager, parseError, doc_, response);
+    }
+
+private:
+    Document doc_;
+    JsonPushParser parser_;
+};
+
+RpcRequestParser* JsonRpcCreateParser(MethodManager* manager)
+{
+    if (manager->HasLazyMethods())
+        return 0;
+    return new JsonRpcRequestParser();
+}
+
+//! Find the method and params of a single request while it is parsed
+class JsonRequestValidator : public RequestValidator
+{
+public:
+    JsonRequestValidator(Handler& target, MethodManager* manager) : RequestValidator(target, manager) {}
+
+protected:
+    virtual Part EnvelopePart() const
+    {
+        // the requests of a batch are checked when they are executed
+        if (!mapEnvelope_)
+            return OtherPart;
+        if (key_ == "method")
+            return MethodPart;
+        if (key_ == "params")
+            return ParamsPart;
+        return OtherPart;
+    }
+};
+
+static bool JsonProcessRequest(MethodManager* manager, char* request, size_t length, Stream &response)
+{
+    if (manager->HasLazyMethods())
+    {
+        // batches are parsed completely since each request may use a different method
+        JsonLazyValue message(request, length);
+        if (message.IsMap())
+            return JsonProcessLazyRequest(manager, message, response);
+    }
+
     Document doc;
+    InSituStringStream sstream(request, length);
+    JsonReader reader(sstream);
+    if (!manager->HasParamSchemas())
+    {
+        reader.ParseStream(doc);
+        return JsonProcessDocument(manager, AnyRpcException(reader.GetParseErrorCode(), reader.GetParseErrorStr()), doc, response);
+    }
+
+    // check the params against the schema of the method while they are parsed
+    JsonRequestValidator validator(doc, manager);
+    reader.ParseStream(validator);
+    return JsonProcessDocument(manager, AnyRpcException(reader.GetParseErrorCode(), reader.GetParseErrorStr()), doc, response,
+                               validator.ParamsValidated());
+}
+
+static bool JsonProcessDocument(MethodManager* manager, const AnyRpcException& parseError, Document& doc, Stream &response,
+                                bool paramsValidated)
+{
     Value valueResponse;
     Value nullValue;
     nullValue.SetNull();
 
-    InSituStringStream sstream(request, length);
-    JsonReader reader(sstream);
-    reader.ParseStream(doc);
-    if (reader.HasParseError())
+    if (parseError.GetCode() == AnyRpcErrorInvalidParams)
+    {
+        // the params didn't match the schema, respond with the id if it was before the params
+        Value* id = doc.GetValue().IsMap() ? doc.GetValue().Get("id") : 0;
+        JsonGenerateFaultResponse(AnyRpcErrorInvalidParams, parseError.GetMessage(), (id != 0) ? *id : nullValue, valueResponse);
+    }
+    else if (parseError.IsErrorSet())
         JsonGenerateFaultResponse(AnyRpcErrorParseError, "Parse error", nullValue, valueResponse);
     else
     {
@@ -64,7 +159,7 @@ bool JsonRpcHandler(MethodManager* manager, char* request, size_t length, Stream
 
         if (message.IsMap())
         {
-            JsonExecuteSingleRequest(manager,message,valueResponse);
+            JsonExecuteSingleRequest(manager,message,valueResponse,paramsValidated);
         }
         else if (message.IsArray() && (message.Size() > 0))
         {
@@ -73,7 +168,7 @@ bool JsonRpcHandler(MethodManager* manager, char* request, size_t length, Stream
             for (int i=0; i<(int)message.Size(); i++)
             {
                 Value singleResponse;
-                JsonExecuteSingleRequest(manager,message[i],singleResponse);
+                JsonExecuteSingleRequest(manager,message[i],singleResponse,false);
                 if (singleResponse.IsValid())
                     valueResponse[outIndex++].Assign(singleResponse);
             }
@@ -95,28 +190,101 @@ bool JsonRpcHandler(MethodManager* manager, char* request, size_t length, Stream
     return true;
 }
 
-static void JsonExecuteSingleRequest(MethodManager* manager, Value& message, Value& response)
+static void JsonExecuteSingleRequest(MethodManager* manager, Value& message, Value& response, bool paramsValidated)
+{
+    // find the envelope members with a single pass without adding any that are missing
+    static const char* const keys[] = { "method", "id", "jsonrpc", "params" };
+    Value* members[4];
+    message.GetMembers(keys, 4, members);
+    Value* method = members[0];
+    Value* rpc = members[2];
+    Value* params = members[3];
+    Value noId;
+    Value& id = (members[1] != 0) ? *members[1] : noId;
+
+    if ((method == 0) || !method->IsString())
+        JsonGenerateFaultResponse(AnyRpcErrorInvalidRequest, "Invalid Request", id, response);
+    else if ((rpc == 0) || !rpc->IsString() || (strcmp(rpc->GetString(), "2.0") != 0))
+        JsonGenerateFaultResponse(AnyRpcErrorInvalidRequest, "Invalid Request", id, response);
+    else if ((params == 0) || params->IsInvalid())
+        JsonGenerateFaultResponse(AnyRpcErrorInvalidRequest, "Invalid Request", id, response);
+    else
+    {
+        Value result;
+        result.SetNull();
+
+        std::string methodName = method->GetString();
+        try
+        {
+            if (!manager->ExecuteMethod(methodName, *params, result, paramsValidated))
+                JsonGenerateFaultResponse(AnyRpcErrorMethodNotFound, "Method not found", id, response);
+            else if (id.IsValid())
+                JsonGenerateResponse(result, id, response);
+        }
+        catch (const AnyRpcException& fault)
+        {
+            JsonGenerateFaultResponse(fault.GetCode(), fault.GetMessage(), id, response);
+        }
+    }
+}
+
+static bool JsonProcessLazyRequest(MethodManager* manager, JsonLazyValue& message, Stream &response)
+{
+    Value valueResponse;
+    Value nullValue;
+    nullValue.SetNull();
+
+    try
+    {
+        JsonExecuteLazyRequest(manager, message, valueResponse);
+    }
+    catch (const AnyRpcException& error)
+    {
+        // the envelope of the request couldn't be parsed
+        log_debug("lazy request parse error: " << error.GetMessage());
+        valueResponse.SetInvalid();
+        JsonGenerateFaultResponse(AnyRpcErrorParseError, "Parse error", nullValue, valueResponse);
+    }
+
+    if (valueResponse.IsInvalid())
+        // notification doesn't produce a response message
+        return false;
+
+    JsonWriter jsonStrWriter(response);
+    valueResponse.Traverse(jsonStrWriter);
+
+    return true;
+}
+
+static void JsonExecuteLazyRequest(MethodManager* manager, JsonLazyValue& message, Value& response)
 {
-    Value& method = message["method"];
-    Value& id = message["id"];
-    Value& rpc = message["jsonrpc"];
-    Value& params = message["params"];
+    // the envelope members are parsed now and the params only when the method accesses them
+    JsonLazyValue* method = message.Get("method");
+    JsonLazyValue* idPart = message.Get("id");
+    JsonLazyValue* rpc = message.Get("jsonrpc");
+    JsonLazyValue* params = message.Get("params");
+    Value noId;
+    Value& id = (idPart != 0) ? idPart->GetValue() : noId;
 
-    if (method.IsInvalid() || !method.IsString())
+    if ((method == 0) || !method->IsString())
         JsonGenerateFaultResponse(AnyRpcErrorInvalidRequest, "Invalid Request", id, response);
-    else if (!rpc.IsString() || (strcmp(rpc.GetString(), "2.0") != 0))
+    else if ((rpc == 0) || !rpc->IsString() || (strcmp(rpc->GetValue().GetString(), "2.0") != 0))
         JsonGenerateFaultResponse(AnyRpcErrorInvalidRequest, "Invalid Request", id, response);
-    else if (params.IsInvalid())
+    else if ((params == 0) || (params->GetType() == InvalidType))
         JsonGenerateFaultResponse(AnyRpcErrorInvalidRequest, "Invalid Request", id, response);
     else
     {
         Value result;
         result.SetNull();
 
-        std::string methodName = method.GetString();
+        std::string methodName = method->GetValue().GetString();
+        Method* target = manager->FindMethod(methodName);
+        // errors in the params of other methods are parse errors of the request
+        if ((target == 0) || !target->LazyParams())
+            params->GetValue();
         try
         {
-            if (!manager->ExecuteMethod(methodName, params, result))
+            if (!manager->ExecuteLazyMethod(methodName, *params, result))
                 JsonGenerateFaultResponse(AnyRpcErrorMethodNotFound, "Method not found", id, response);
             else if (id.IsValid())
                 JsonGenerateResponse(result, id, response);
@@ -26,6 +26,9 @@
 #include "anyrpc/handler.h"
 #include "anyrpc/internal/base64.h"
 #include "anyrpc/internal/time.h"
+#include "anyrpc/internal/itoa.h"
+#include "anyrpc/internal/dtoa.h"
+#include "anyrpc/internal/strscan.h"
 #include "anyrpc/json/jsonwriter.h"
 
 namespace anyrpc
@@ -52,35 +55,39 @@ void JsonWriter::BoolFalse()
 void JsonWriter::Int(int i)
 {
     log_debug("Int: " << i);
-    os_ << i;
+    StreamReservation<internal::IntegerStringSize> out(os_);
+    out.Commit( internal::I32ToString(i, out.Begin()) );
 }
 
 void JsonWriter::Uint(unsigned u)
 {
     log_debug("Uint: " << u);
-    os_ << u;
+    StreamReservation<internal::IntegerStringSize> out(os_);
+    out.Commit( internal::U32ToString(u, out.Begin()) );
 }
 
 void JsonWriter::Int64(int64_t i64)
 {
     log_debug("Int64: " << i64);
-    os_ << i64;
+    StreamReservation<internal::IntegerStringSize> out(os_);
+    out.Commit( internal::I64ToString(i64, out.Begin()) );
 }
 
 void JsonWriter::Uint64(uint64_t u64)
 {
     log_debug("Uint64: " << u64);
-    os_ << u64;
+    StreamReservation<internal::IntegerStringSize> out(os_);
+    out.Commit( internal::U64ToString(u64, out.Begin()) );
 }
 
 void JsonWriter::Double(double d)
 {
     log_debug("Double: " << d);
-    char buffer[25];
-    int length = snprintf(buffer, sizeof(buffer), "%g", d);
-    os_.Put( buffer, length );
+    StreamReservation<internal::DoubleStringSize> out(os_);
+    out.Commit( internal::DoubleToString(d, out.Begin()) );
 }
 
+
 void JsonWriter::DateTime(time_t dt)
 {
     char buffer[100];
@@ -120,33 +127,48 @@ void JsonWriter::String(const char* str, size_t length, bool copy)
     };
 
     os_.Put('\"');
+    size_t start = 0;
     for (size_t i=0; i<length; i++)
     {
+        // skip to the next character that needs an escape
+        if (encoding_ == ASCII)
+            i += internal::ScanJsonStringAscii(str + i, length - i);
+        else
+            i += internal::ScanJsonString(str + i, length - i);
+        if (i == length)
+            break;
         unsigned char c = static_cast<unsigned char>(str[i]);
+
+        // write the run of characters that don't need escaping with a single call
+        if (i > start)
+            os_.Put(str + start, i - start);
+
+        StreamReservation<12> out(os_);
+        char* p = out.Begin();
+        *p++ = '\\';
         if (escape[c])
         {
-            os_.Put('\\');
-            os_.Put(escape[c]);
-            if (escape[(unsigned char)c] == 'u')
+            *p++ = escape[c];
+            if (escape[c] == 'u')
             {
-                os_.Put('0');
-                os_.Put('0');
-                os_.Put(hexDigits[(c >> 4)      ]);
-                os_.Put(hexDigits[(c     ) & 0xF]);
+                *p++ = '0';
+                *p++ = '0';
+                *p++ = hexDigits[(c >> 4)      ];
+                *p++ = hexDigits[(c     ) & 0xF];
             }
         }
-        else if ((encoding_ == ASCII) && (c >= 0x80))
+        else
         {
             // Unicode escape
             unsigned codepoint;
             DecodeUtf8(str,length,i,codepoint);
-            os_.Put("\\u");
+            *p++ = 'u';
             if ((codepoint <= 0xD7FF) || ((codepoint >= 0xE000) && (codepoint <= 0xFFFF)))
             {
-                os_.Put(hexDigits[(codepoint >> 12) & 0xF]);
-                os_.Put(hexDigits[(codepoint >>  8) & 0xF]);
-                os_.Put(hexDigits[(codepoint >>  4) & 0xF]);
-                os_.Put(hexDigits[(codepoint      ) & 0xF]);
+                *p++ = hexDigits[(codepoint >> 12) & 0xF];
+                *p++ = hexDigits[(codepoint >>  8) & 0xF];
+                *p++ = hexDigits[(codepoint >>  4) & 0xF];
+                *p++ = hexDigits[(codepoint      ) & 0xF];
             }
             else
             {
@@ -155,23 +177,23 @@ void JsonWriter::String(const char* str, size_t length, bool copy)
                 unsigned s = codepoint - 0x010000;
                 unsigned lead  = (s >> 10)   + 0xD800;
                 unsigned trail = (s & 0x3FF) + 0xDC00;
-                os_.Put(hexDigits[(lead  >> 12) & 0xF]);
-                os_.Put(hexDigits[(lead  >>  8) & 0xF]);
-                os_.Put(hexDigits[(lead  >>  4) & 0xF]);
-                os_.Put(hexDigits[(lead       ) & 0xF]);
-                os_.Put('\\');
-                os_.Put('u');
-                os_.Put(hexDigits[(trail >> 12) & 0xF]);
-                os_.Put(hexDigits[(trail >>  8) & 0xF]);
-                os_.Put(hexDigits[(trail >>  4) & 0xF]);
-                os_.Put(hexDigits[(trail      ) & 0xF]);
+                *p++ = hexDigits[(lead  >> 12) & 0xF];
+                *p++ = hexDigits[(lead  >>  8) & 0xF];
+                *p++ = hexDigits[(lead  >>  4) & 0xF];
+                *p++ = hexDigits[(lead       ) & 0xF];
+                *p++ = '\\';
+                *p++ = 'u';
+                *p++ = hexDigits[(trail >> 12) & 0xF];
+                *p++ = hexDigits[(trail >>  8) & 0xF];
+                *p++ = hexDigits[(trail >>  4) & 0xF];
+                *p++ = hexDigits[(trail      ) & 0xF];
             }
         }
-        else
-        {
-            os_.Put(c);
-        }
+        out.Commit(p);
+        start = i + 1;
     }
+    if (length > start)
+        os_.Put(str + start, length - start);
     os_.Put('\"');
 }
 
@@ -284,5 +306,37 @@ void JsonWriter::EndArray(size_t elementCount)
     os_.Flush();
 }
 
+void JsonWriter::TypedArray(TypedArrayType type, const void* data, size_t elementCount)
+{
+    log_debug("TypedArray: type=" << type << ", count=" << elementCount);
+    // format the elements into a local buffer to write larger chunks to the stream
+    char buffer[4096];
+    size_t pos = 0;
+    buffer[pos++] = '[';
+    for (size_t i=0; i<elementCount; i++)
+    {
+        if (pos > sizeof(buffer) - 32)
+        {
+            os_.Put(buffer, pos);
+            pos = 0;
+        }
+        if (i != 0)
+            buffer[pos++] = ',';
+        char* str = buffer + pos;
+        switch (type)
+        {
+            case TypedInt32:  pos = internal::I32ToString(static_cast<const int32_t*>(data)[i], str) - buffer; break;
+            case TypedInt64:  pos = internal::I64ToString(static_cast<const int64_t*>(data)[i], str) - buffer; break;
+            case TypedFloat:  pos = internal::FloatToString(static_cast<const float*>(data)[i], str) - buffer; break;
+            case TypedDouble: pos = internal::DoubleToString(static_cast<const double*>(data)[i], str) - buffer; break;
+            case TypedUint8:  pos = internal::U32ToString(static_cast<const uint8_t*>(data)[i], str) - buffer; break;
+            default:          anyrpc_throw(AnyRpcErrorIllegalCall, "Illegal typed array type=" << type);
+        }
+    }
+    buffer[pos++] = ']';
+    os_.Put(buffer, pos);
+    os_.Flush();
+}
+
 
 }
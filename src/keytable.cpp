@@ -0,0 +1,127 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/keytable.h"
+
+#if defined(ANYRPC_THREADING)
+# include <atomic>
+# if defined(__MINGW32__)
+#  include <mutex>
+#  include "anyrpc/internal/mingw.mutex.h"
+# else
+#  include <mutex>
+# endif //defined(__MINGW32__)
+#endif //defined(ANYRPC_THREADING)
+
+namespace anyrpc
+{
+
+// The table uses open addressing with linear probing.  Slots are only ever
+// filled, never changed or emptied, so Find can read them without the lock.
+
+#if defined(ANYRPC_THREADING)
+static std::atomic<const char*> slots[2 * KeyTable::MaxKeys];
+static std::atomic<std::size_t> numKeys(0);
+static std::mutex internMutex;
+#else
+static const char* slots[2 * KeyTable::MaxKeys];
+static std::size_t numKeys = 0;
+#endif //defined(ANYRPC_THREADING)
+
+uint32_t KeyTable::Hash(const char* str, std::size_t length)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (std::size_t i=0; i<length; i++)
+    {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const char* KeyTable::Find(const char* str, std::size_t length)
+{
+    uint32_t slot = Hash(str, length) & (Slots - 1);
+    const char* interned;
+    while ((interned = slots[slot]) != 0)
+    {
+        const Entry* entry = reinterpret_cast<const Entry*>(interned - sizeof(Entry));
+        if ((entry->length == length) && (memcmp(interned, str, length) == 0))
+            return interned;
+        slot = (slot + 1) & (Slots - 1);
+    }
+    return 0;
+}
+
+const char* KeyTable::Intern(const char* str, std::size_t length)
+{
+    log_debug("Intern: length=" << length);
+#if defined(ANYRPC_THREADING)
+    std::lock_guard<std::mutex> lock(internMutex);
+#endif //defined(ANYRPC_THREADING)
+
+    const char* interned = Find(str, length);
+    if (interned != 0)
+        return interned;
+    if (numKeys >= MaxKeys)
+    {
+        log_warn("Key table is full");
+        return 0;
+    }
+
+    // the entry header is followed by the characters with a terminating zero
+    Entry* entry = static_cast<Entry*>(malloc(sizeof(Entry) + length + 1));
+    anyrpc_assert(entry != 0, AnyRpcErrorMemoryAllocation, "Data allocation failed");
+    entry->hash = Hash(str, length);
+    entry->length = static_cast<uint32_t>(length);
+    char* chars = reinterpret_cast<char*>(entry + 1);
+    memcpy(chars, str, length);
+    chars[length] = 0;
+
+    uint32_t slot = entry->hash & (Slots - 1);
+    while (slots[slot] != 0)
+        slot = (slot + 1) & (Slots - 1);
+    slots[slot] = chars;
+    numKeys++;
+    return chars;
+}
+
+std::size_t KeyTable::GetSize()
+{
+    return numKeys;
+}
+
+//! Intern the keys used by the protocols at startup
+static struct ProtocolKeys
+{
+    ProtocolKeys()
+    {
+        static const char* keys[] = { "jsonrpc", "id", "method", "params", "result", "error",
+                                      "code", "message", "data", "faultCode", "faultString" };
+        for (std::size_t i=0; i<sizeof(keys)/sizeof(keys[0]); i++)
+            KeyTable::Intern(keys[i]);
+    }
+} protocolKeys;
+
+} // namespace anyrpc
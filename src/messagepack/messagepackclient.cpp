@@ -29,6 +29,7 @@
 #include "anyrpc/method.h"
 #include "anyrpc/socket.h"
 #include "anyrpc/client.h"
+#include "anyrpc/balancedclient.h"
 #include "anyrpc/messagepack/messagepackwriter.h"
 #include "anyrpc/messagepack/messagepackreader.h"
 #include "anyrpc/messagepack/messagepackclient.h"
@@ -134,7 +135,9 @@ ProcessResponseEnum MessagePackClientHandler::ProcessResponse(char* response, si
                 else if (!fault.IsNull())
                 {
                     result.Assign(fault);
-                    if (result.HasMember("code") && result.HasMember("message"))
+                    static const char* const keys[] = { "code", "message" };
+                    const Value* members[2];
+                    if (result.GetMembers(keys, 2, members) == 2)
                         // standard fault response - keep the connection open
                         processResponse =  ProcessResponseErrorKeepOpen;
                     else
@@ -21,11 +21,13 @@
 #include "anyrpc/api.h"
 #include "anyrpc/logger.h"
 #include "anyrpc/error.h"
+#include "anyrpc/arena.h"
 #include "anyrpc/value.h"
 #include "anyrpc/stream.h"
 #include "anyrpc/handler.h"
 #include "anyrpc/reader.h"
 #include "anyrpc/document.h"
+#include "anyrpc/paramschema.h"
 #include "anyrpc/method.h"
 #include "anyrpc/socket.h"
 #include "anyrpc/connection.h"
@@ -37,6 +39,7 @@
 namespace anyrpc
 {
 
+static bool MessagePackProcessRequest(MethodManager* manager, char* request, size_t length, Stream &response);
 static void MessagePackGenerateResponse(Value& result, Value& id, Value& response);
 static void MessagePackGenerateFaultResponse(int errorCode, std::string const& errorMsg, Value& id, Value& response);
 
@@ -45,6 +48,40 @@ log_define("AnyRPC.RpcHandler");
 ////////////////////////////////////////////////////////////////////////////////
 
 bool MessagePackRpcHandler(MethodManager* manager, char* request, size_t length, Stream &response)
+{
+    bool sendResponse = MessagePackProcessRequest(manager, request, length, response);
+
+    // the values for the request have been destroyed so the arena space can be reused
+    MemoryArena* arena = MemoryArena::GetCurrent();
+    if (arena != 0)
+        arena->Reset();
+    return sendResponse;
+}
+
+//! Find the method and params of a request or notification while it is parsed
+class MessagePackRequestValidator : public RequestValidator
+{
+public:
+    MessagePackRequestValidator(Handler& target, MethodManager* manager) : RequestValidator(target, manager) {}
+
+    bool IsNotification() const { return !mapEnvelope_ && (envelopeSize_ == 3); }
+
+protected:
+    virtual Part EnvelopePart() const
+    {
+        // [type, id, method, params] for a request and [type, method, params] for a notification
+        if (mapEnvelope_ || ((envelopeSize_ != 3) && (envelopeSize_ != 4)))
+            return OtherPart;
+        std::size_t methodPosition = envelopeSize_ - 2;
+        if (position_ == methodPosition)
+            return MethodPart;
+        if (position_ == methodPosition + 1)
+            return ParamsPart;
+        return OtherPart;
+    }
+};
+
+static bool MessagePackProcessRequest(MethodManager* manager, char* request, size_t length, Stream &response)
 {
     log_trace();
     Document doc;
@@ -52,11 +89,30 @@ bool MessagePackRpcHandler(MethodManager* manager, char* request, size_t length,
     Value nullValue;
     nullValue.SetNull();
     bool notification = false;
+    bool paramsValidated = false;
 
     InSituStringStream sstream(request, length);
     MessagePackReader reader(sstream);
-    reader.ParseStream(doc);
-    if (reader.HasParseError())
+    if (!manager->HasParamSchemas())
+        reader.ParseStream(doc);
+    else
+    {
+        // check the params against the schema of the method while they are parsed
+        MessagePackRequestValidator validator(doc, manager);
+        reader.ParseStream(validator);
+        paramsValidated = validator.ParamsValidated();
+        notification = validator.IsNotification();
+    }
+    if (reader.GetParseErrorCode() == AnyRpcErrorInvalidParams)
+    {
+        if (notification)
+            // notification doesn't produce a response message
+            return false;
+        Value& message = doc.GetValue();
+        Value& id = (message.IsArray() && (message.Size() > 1)) ? message[1] : nullValue;
+        MessagePackGenerateFaultResponse(AnyRpcErrorInvalidParams, reader.GetParseErrorStr(), id, valueResponse);
+    }
+    else if (reader.HasParseError())
         MessagePackGenerateFaultResponse(AnyRpcErrorParseError, "Parse error", nullValue, valueResponse);
     else
     {
@@ -85,7 +141,7 @@ bool MessagePackRpcHandler(MethodManager* manager, char* request, size_t length,
                 std::string methodName = method.GetString();
                 try
                 {
-                    if (!manager->ExecuteMethod(methodName, params, result))
+                    if (!manager->ExecuteMethod(methodName, params, result, paramsValidated))
                         MessagePackGenerateFaultResponse(AnyRpcErrorMethodNotFound, "Method not found", id, valueResponse);
                     else
                         MessagePackGenerateResponse(result, id, valueResponse);
@@ -125,7 +181,7 @@ bool MessagePackRpcHandler(MethodManager* manager, char* request, size_t length,
                 std::string methodName = method.GetString();
                 try
                 {
-                    manager->ExecuteMethod(methodName, params, result);
+                    manager->ExecuteMethod(methodName, params, result, paramsValidated);
                     //if (!manager->ExecuteMethod(methodName, params, result))
                     //    GenerateFaultResponse(AnyRpcErrorMethodNotFound, "Method not found", id, valueResponse);
                 }
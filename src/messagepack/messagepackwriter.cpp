@@ -97,24 +97,17 @@ void MessagePackWriter::Int(int i)
         if (i < -(1<<15))
         {
             // use signed 32 representation
-            char buf[4];
-            os_.Put(MessagePackInt32);
-            _msgpack_store32(buf, static_cast<int32_t>(i));
-            os_.Put(buf,4);
+            PutTag32(MessagePackInt32, static_cast<int32_t>(i));
         }
         else if (i < -(1<<7))
         {
             // use signed 16 representation
-            char buf[2];
-            os_.Put(MessagePackInt16);
-            _msgpack_store16(buf, static_cast<int16_t>(i));
-            os_.Put(buf,2);
+            PutTag16(MessagePackInt16, static_cast<int16_t>(i));
         }
         else
         {
             // use signed 8 representation
-            os_.Put(MessagePackInt8);
-            os_.Put(take8_32(i));
+            PutTag8(MessagePackInt8, take8_32(i));
         }
     }
     else if (i < (1<<7))
@@ -145,18 +138,12 @@ void MessagePackWriter::Int64(int64_t i64)
             if (i64 < -(1LL << 31))
             {
                 // use signed 64 representation
-                char buf[8];
-                os_.Put(MessagePackInt64);
-                _msgpack_store64(buf, i64);
-                os_.Put(buf, 8);
+                PutTag64(MessagePackInt64, i64);
             }
             else
             {
                 // use signed 32 representation
-                char buf[4];
-                os_.Put(MessagePackInt32);
-                _msgpack_store32(buf, static_cast<int32_t>(i64));
-                os_.Put(buf, 4);
+                PutTag32(MessagePackInt32, static_cast<int32_t>(i64));
             }
         }
         else
@@ -164,16 +151,12 @@ void MessagePackWriter::Int64(int64_t i64)
             if (i64 < -(1 << 7))
             {
                 // use signed 16 representation
-                char buf[2];
-                os_.Put(MessagePackInt16);
-                _msgpack_store16(buf, static_cast<int16_t>(i64));
-                os_.Put(buf, 2);
+                PutTag16(MessagePackInt16, static_cast<int16_t>(i64));
             }
             else
             {
                 // use signed 8 representation
-                os_.Put(MessagePackInt8);
-                os_.Put(take8_64(i64));
+                PutTag8(MessagePackInt8, take8_64(i64));
             }
         }
     }
@@ -200,10 +183,7 @@ void MessagePackWriter::Float(float f)
     log_debug("Float: " << f);
     union { float f; uint32_t i; } mem;
     mem.f = f;
-    char buf[4];
-    os_.Put(MessagePackFloat32);
-    _msgpack_store32(buf, mem.i);
-    os_.Put(buf,4);
+    PutTag32(MessagePackFloat32, mem.i);
 }
 
 void MessagePackWriter::Double(double d)
@@ -211,14 +191,11 @@ void MessagePackWriter::Double(double d)
     log_debug("Double: " << d);
     union { double f; uint64_t i; } mem;
     mem.f = d;
-    char buf[8];
-    os_.Put(MessagePackFloat64);
 #if defined(__arm__) && !(__ARM_EABI__) // arm-oabi
     // https://github.com/msgpack/msgpack-perl/pull/1
     mem.i = (mem.i & 0xFFFFFFFFUL) << 32UL | (mem.i >> 32UL);
 #endif
-    _msgpack_store64(buf, mem.i);
-    os_.Put(buf,8);
+    PutTag64(MessagePackFloat64, mem.i);
 }
 
 void MessagePackWriter::DateTime(time_t dt)
@@ -259,30 +236,27 @@ void MessagePackWriter::String(const char* str, size_t length, bool copy)
     // output the string type identifier with the length
     if (length < 32)
     {
-        // use fixed string format
-        os_.Put(MessagePackFixStr | static_cast<uint8_t>(length));
+        // use fixed string format, with the string in the same call to the stream
+        char buf[32];
+        buf[0] = static_cast<char>(MessagePackFixStr | static_cast<uint8_t>(length));
+        memcpy(buf + 1, str, length);
+        os_.Put(buf, length + 1);
+        return;
     }
     else if (length < 256)
     {
         // use str 8 representation
-        os_.Put(MessagePackStr8);
-        os_.Put(static_cast<uint8_t>(length));
+        PutTag8(MessagePackStr8, static_cast<uint8_t>(length));
     }
     else if (length < 65536)
     {
         // use str 16 representation
-        char buf[2];
-        os_.Put(MessagePackStr16);
-        _msgpack_store16(buf, static_cast<uint16_t>(length));
-        os_.Put(buf, 2);
+        PutTag16(MessagePackStr16, static_cast<uint16_t>(length));
     }
     else
     {
         // use str 32 representation
-        char buf[4];
-        os_.Put(MessagePackStr32);
-        _msgpack_store32(buf, static_cast<uint32_t>(length));
-        os_.Put(buf, 4);
+        PutTag32(MessagePackStr32, static_cast<uint32_t>(length));
     }
     // output the string characters
     os_.Put(str, length);
@@ -295,24 +269,17 @@ void MessagePackWriter::Binary(const unsigned char* str, size_t length, bool cop
     if (length < 256)
     {
         // use bin 8 representation
-        os_.Put(MessagePackBin8);
-        os_.Put(static_cast<uint8_t>(length));
+        PutTag8(MessagePackBin8, static_cast<uint8_t>(length));
     }
     else if (length < 65536)
     {
         // use bin 16 representation
-        char buf[2];
-        os_.Put(MessagePackBin16);
-        _msgpack_store16(buf, static_cast<uint16_t>(length));
-        os_.Put(buf, 2);
+        PutTag16(MessagePackBin16, static_cast<uint16_t>(length));
     }
     else
     {
         // use bin 32 representation
-        char buf[4];
-        os_.Put(MessagePackBin32);
-        _msgpack_store32(buf, static_cast<uint32_t>(length));
-        os_.Put(buf, 4);
+        PutTag32(MessagePackBin32, static_cast<uint32_t>(length));
     }
     // output the binary data block
     os_.Put((const char*)str, length);
@@ -329,18 +296,12 @@ void MessagePackWriter::StartMap(size_t memberCount)
     else if (memberCount < 65536)
     {
         // use map 16 representation
-        char buf[2];
-        os_.Put(MessagePackMap16);
-        _msgpack_store16(buf, static_cast<uint16_t>(memberCount));
-        os_.Put(buf, 2);
+        PutTag16(MessagePackMap16, static_cast<uint16_t>(memberCount));
     }
     else
     {
         // use map32 representation
-        char buf[4];
-        os_.Put(MessagePackMap32);
-        _msgpack_store32(buf, static_cast<uint32_t>(memberCount));
-        os_.Put(buf, 4);
+        PutTag32(MessagePackMap32, static_cast<uint32_t>(memberCount));
     }
 }
 
@@ -368,18 +329,12 @@ void MessagePackWriter::StartArray(size_t elementCount)
     else if (elementCount < 65536)
     {
         // use array 16 representation
-        char buf[2];
-        os_.Put(MessagePackArray16);
-        _msgpack_store16(buf, static_cast<uint16_t>(elementCount));
-        os_.Put(buf, 2);
+        PutTag16(MessagePackArray16, static_cast<uint16_t>(elementCount));
     }
     else
     {
         // use array 32 representation
-        char buf[4];
-        os_.Put(MessagePackArray32);
-        _msgpack_store32(buf, static_cast<uint32_t>(elementCount));
-        os_.Put(buf, 4);
+        PutTag32(MessagePackArray32, static_cast<uint32_t>(elementCount));
     }
 }
 
@@ -389,6 +344,51 @@ void MessagePackWriter::EndArray(size_t elementCount)
     os_.Flush();
 }
 
+void MessagePackWriter::TypedArray(TypedArrayType type, const void* data, size_t elementCount)
+{
+    log_debug("TypedArray: type=" << type << ", count=" << elementCount);
+    if ((type != TypedFloat) && (type != TypedDouble))
+    {
+        // integers use the compact representation of each value
+        Handler::TypedArray(type, data, elementCount);
+        return;
+    }
+
+    // floating point values have a fixed size so encode them into a local buffer to write larger chunks
+    StartArray(elementCount);
+    char buffer[4096];
+    size_t pos = 0;
+    for (size_t i=0; i<elementCount; i++)
+    {
+        if (pos > sizeof(buffer) - 9)
+        {
+            os_.Put(buffer, pos);
+            pos = 0;
+        }
+        if (type == TypedFloat)
+        {
+            union { float f; uint32_t i; } mem;
+            mem.f = static_cast<const float*>(data)[i];
+            buffer[pos++] = MessagePackFloat32;
+            _msgpack_store32(buffer + pos, mem.i);
+            pos += 4;
+        }
+        else
+        {
+            union { double f; uint64_t i; } mem;
+            mem.f = static_cast<const double*>(data)[i];
+#if defined(__arm__) && !(__ARM_EABI__) // arm-oabi
+            mem.i = (mem.i & 0xFFFFFFFFUL) << 32UL | (mem.i >> 32UL);
+#endif
+            buffer[pos++] = MessagePackFloat64;
+            _msgpack_store64(buffer + pos, mem.i);
+            pos += 8;
+        }
+    }
+    os_.Put(buffer, pos);
+    EndArray(elementCount);
+}
+
 void MessagePackWriter::WriteUint(unsigned u)
 {
     if (u < (1 << 8))
@@ -401,8 +401,7 @@ void MessagePackWriter::WriteUint(unsigned u)
         else
         {
             // use unsigned 8 representation
-            os_.Put(MessagePackUint8);
-            os_.Put(take8_32(u));
+            PutTag8(MessagePackUint8, take8_32(u));
         }
     }
     else
@@ -410,18 +409,12 @@ void MessagePackWriter::WriteUint(unsigned u)
         if (u < (1 << 16))
         {
             // use unsigned 16 representation
-            char buf[2];
-            os_.Put(MessagePackUint16);
-            _msgpack_store16(buf, static_cast<uint16_t>(u));
-            os_.Put(buf, 2);
+            PutTag16(MessagePackUint16, static_cast<uint16_t>(u));
         }
         else
         {
             // unsigned 32 representation
-            char buf[4];
-            os_.Put(MessagePackUint32);
-            _msgpack_store32(buf, static_cast<uint32_t>(u));
-            os_.Put(buf, 4);
+            PutTag32(MessagePackUint32, static_cast<uint32_t>(u));
         }
     }
 }
@@ -438,8 +431,7 @@ void MessagePackWriter::WriteUint64(uint64_t u64)
         else
         {
             // use unsigned 8 representation
-            os_.Put(MessagePackUint8);
-            os_.Put(take8_64(u64));
+            PutTag8(MessagePackUint8, take8_64(u64));
         }
     }
     else
@@ -447,28 +439,49 @@ void MessagePackWriter::WriteUint64(uint64_t u64)
         if (u64 < (1ULL << 16))
         {
             // use unsigned 16 representation
-            char buf[2];
-            os_.Put(MessagePackUint16);
-            _msgpack_store16(buf, static_cast<uint16_t>(u64));
-            os_.Put(buf, 2);
+            PutTag16(MessagePackUint16, static_cast<uint16_t>(u64));
         }
         else if (u64 < (1ULL << 32))
         {
             // use unsigned 32 representation
-            char buf[4];
-            os_.Put(MessagePackUint32);
-            _msgpack_store32(buf, static_cast<uint32_t>(u64));
-            os_.Put(buf, 4);
+            PutTag32(MessagePackUint32, static_cast<uint32_t>(u64));
         }
         else
         {
             // use unsigned 64 representation
-            char buf[8];
-            os_.Put(MessagePackUint64);
-            _msgpack_store64(buf, u64);
-            os_.Put(buf, 8);
+            PutTag64(MessagePackUint64, u64);
         }
     }
 }
 
+void MessagePackWriter::PutTag8(unsigned char tag, char value)
+{
+    char buf[2] = { static_cast<char>(tag), value };
+    os_.Put(buf, 2);
+}
+
+void MessagePackWriter::PutTag16(unsigned char tag, uint16_t value)
+{
+    char buf[3];
+    buf[0] = static_cast<char>(tag);
+    _msgpack_store16(buf + 1, value);
+    os_.Put(buf, 3);
+}
+
+void MessagePackWriter::PutTag32(unsigned char tag, uint32_t value)
+{
+    char buf[5];
+    buf[0] = static_cast<char>(tag);
+    _msgpack_store32(buf + 1, value);
+    os_.Put(buf, 5);
+}
+
+void MessagePackWriter::PutTag64(unsigned char tag, uint64_t value)
+{
+    char buf[9];
+    buf[0] = static_cast<char>(tag);
+    _msgpack_store64(buf + 1, value);
+    os_.Put(buf, 9);
+}
+
 }
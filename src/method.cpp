@@ -21,12 +21,22 @@
 #include "anyrpc/api.h"
 #include "anyrpc/logger.h"
 #include "anyrpc/error.h"
+#include "anyrpc/arena.h"
 #include "anyrpc/value.h"
+#include "anyrpc/handler.h"
+#include "anyrpc/paramschema.h"
 #include "anyrpc/method.h"
+#include "anyrpc/json/jsonlazyvalue.h"
+#include "anyrpc/internal/time.h"
 
 namespace anyrpc
 {
 
+//! Deadline for the request being executed by this thread - zero seconds if no deadline
+static ANYRPC_THREAD_LOCAL struct timeval methodDeadline = { 0, 0 };
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ListMethod::Execute(Value& params, Value& result)
 {
     if (manager_)
@@ -43,7 +53,8 @@ void HelpMethod::Execute(Value& params, Value& result)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-MethodManager::MethodManager()
+MethodManager::MethodManager() :
+    lazyMethods_(0)
 {
     methods_[LIST_METHODS] = new ListMethod(this,LIST_METHODS,LIST_METHODS_HELP);
     methods_[METHOD_HELP] = new HelpMethod(this,METHOD_HELP,METHOD_HELP_HELP);
@@ -56,8 +67,12 @@ MethodManager::~MethodManager()
     {
         if (it->second->DeleteOnRemove())
             delete it->second;  // free the method pointer data
+        else
+            it->second->SetParamSchema(0);
     }
     methods_.clear();
+    for (std::size_t i=0; i<schemas_.size(); i++)
+        delete schemas_[i];
 }
 
 void MethodManager::AddFunction(Function* function, std::string const& name, std::string const& help)
@@ -83,6 +98,8 @@ void MethodManager::AddMethod(Method* method)
     {
         // not found so add new method
         methods_[method->Name()] = method;
+        if (method->LazyParams())
+            lazyMethods_++;
     }
     else
     {
@@ -94,15 +111,93 @@ void MethodManager::AddMethod(Method* method)
     }
 }
 
-bool MethodManager::ExecuteMethod(std::string const& name, Value& params, Value& result)
+template <typename ParamsType>
+void MethodManager::CheckExecute(Method* method, ParamsType& params, bool paramsValidated)
+{
+    if (DeadlineExpired())
+        anyrpc_throw(AnyRpcErrorDeadlineExceeded, "Deadline exceeded before executing method: " + method->Name());
+    const ParamSchema* schema = method->GetParamSchema();
+    if ((schema != 0) && !paramsValidated)
+    {
+        SchemaValidator validator(*schema);
+        params.Traverse(validator);
+    }
+}
+
+bool MethodManager::ExecuteMethod(std::string const& name, Value& params, Value& result, bool paramsValidated)
 {
     MethodMap::const_iterator it = methods_.find(name);
     if (it == methods_.end())
         return false;
+    CheckExecute(it->second, params, paramsValidated);
+    // only the request and response use the arena so the values kept by the method are on the heap
+    ArenaScope heapScope(0);
     it->second->Execute(params,result);
     return true;
 }
 
+#if defined(ANYRPC_INCLUDE_JSON)
+bool MethodManager::ExecuteLazyMethod(std::string const& name, JsonLazyValue& params, Value& result)
+{
+    MethodMap::const_iterator it = methods_.find(name);
+    if (it == methods_.end())
+        return false;
+    if (!it->second->LazyParams())
+        return ExecuteMethod(name, params.GetValue(), result);
+    // the schema is checked against the text of the params without creating a Value
+    CheckExecute(it->second, params, false);
+    ArenaScope heapScope(0);
+    it->second->ExecuteLazy(params,result);
+    return true;
+}
+#endif // defined(ANYRPC_INCLUDE_JSON)
+
+void MethodManager::SetParamSchema(std::string const& name, const ParamSchema& schema)
+{
+    MethodMap::const_iterator it = methods_.find(name);
+    if (it == methods_.end())
+        anyrpc_throw(AnyRpcErrorMethodNotFound, "Unknown method name: " + name);
+    schemas_.push_back(new ParamSchema(schema));
+    it->second->SetParamSchema(schemas_.back());
+}
+
+Method* MethodManager::FindMethod(std::string const& name)
+{
+    MethodMap::const_iterator it = methods_.find(name);
+    if (it == methods_.end())
+        return 0;
+    return it->second;
+}
+
+const ParamSchema* MethodManager::FindParamSchema(std::string const& name) const
+{
+    MethodMap::const_iterator it = methods_.find(name);
+    if (it == methods_.end())
+        return 0;
+    return it->second->GetParamSchema();
+}
+
+void MethodManager::SetDeadline(const struct timeval& deadline)
+{
+    methodDeadline = deadline;
+}
+
+void MethodManager::ClearDeadline()
+{
+    methodDeadline.tv_sec = 0;
+    methodDeadline.tv_usec = 0;
+}
+
+bool MethodManager::DeadlineExpired()
+{
+    if (methodDeadline.tv_sec == 0)
+        return false;
+
+    struct timeval currentTime;
+    gettimeofday( &currentTime, 0 );
+    return (MilliTimeDiff(currentTime, methodDeadline) >= 0);
+}
+
 void MethodManager::ListMethods(Value& params, Value& result)
 {
     int i=0;
@@ -0,0 +1,700 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/value.h"
+#include "anyrpc/handler.h"
+#include "anyrpc/paramschema.h"
+#include "anyrpc/method.h"
+
+namespace anyrpc
+{
+
+static const char* TypeName(ParamSchema::Type type)
+{
+    static const char* const names[] = { "any", "null", "bool", "integer", "number", "string", "binary", "datetime", "array", "map" };
+    return names[type];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ParamSchema::ParamSchema(Type type)
+{
+    Node node;
+    node.type = type;
+    node.hasRange = false;
+    node.min = 0;
+    node.max = 0;
+    node.minLength = 0;
+    node.maxLength = NoNode;
+    node.elements = NoNode;
+    node.otherMembers = false;
+    node.required = 0;
+    nodes_.push_back(node);
+}
+
+ParamSchema& ParamSchema::Range(double min, double max)
+{
+    Node& node = nodes_[0];
+    anyrpc_assert((node.type == IntegerType) || (node.type == NumberType), AnyRpcErrorIllegalCall,
+                  "Range is only for numbers, type=" << TypeName(node.type));
+    node.hasRange = true;
+    node.min = min;
+    node.max = max;
+    return *this;
+}
+
+ParamSchema& ParamSchema::Length(std::size_t min, std::size_t max)
+{
+    Node& node = nodes_[0];
+    anyrpc_assert((node.type == StringType) || (node.type == BinaryType) || (node.type == ArrayType) || (node.type == MapType),
+                  AnyRpcErrorIllegalCall, "Length is not available, type=" << TypeName(node.type));
+    node.minLength = min;
+    node.maxLength = max;
+    return *this;
+}
+
+ParamSchema& ParamSchema::Element(const ParamSchema& schema)
+{
+    anyrpc_assert(nodes_[0].type == ArrayType, AnyRpcErrorIllegalCall, "Element is only for arrays, type=" << TypeName(nodes_[0].type));
+    AddChild("", schema, true);
+    return *this;
+}
+
+ParamSchema& ParamSchema::Elements(const ParamSchema& schema)
+{
+    anyrpc_assert(nodes_[0].type == ArrayType, AnyRpcErrorIllegalCall, "Elements is only for arrays, type=" << TypeName(nodes_[0].type));
+    std::size_t index = AddNodes(schema);
+    nodes_[0].elements = index;
+    return *this;
+}
+
+ParamSchema& ParamSchema::Member(const char* key, const ParamSchema& schema, bool required)
+{
+    anyrpc_assert(nodes_[0].type == MapType, AnyRpcErrorIllegalCall, "Member is only for maps, type=" << TypeName(nodes_[0].type));
+    AddChild(key, schema, required);
+    return *this;
+}
+
+ParamSchema& ParamSchema::OtherMembers(bool allow)
+{
+    anyrpc_assert(nodes_[0].type == MapType, AnyRpcErrorIllegalCall, "OtherMembers is only for maps, type=" << TypeName(nodes_[0].type));
+    nodes_[0].otherMembers = allow;
+    return *this;
+}
+
+std::size_t ParamSchema::FindMember(std::size_t node, const char* key, std::size_t length, std::size_t& hint) const
+{
+    const std::vector<Child>& children = nodes_[node].children;
+    std::size_t size = children.size();
+    for (std::size_t n=0; n<size; n++)
+    {
+        std::size_t i = (hint + n) % size;
+        const std::string& name = children[i].key;
+        if ((name.length() == length) && (memcmp(name.data(), key, length) == 0))
+        {
+            hint = i + 1;
+            return i;
+        }
+    }
+    return NoNode;
+}
+
+std::size_t ParamSchema::AddNodes(const ParamSchema& schema)
+{
+    // copy first in case the schema is being added to itself
+    std::vector<Node> nodes(schema.nodes_);
+    std::size_t base = nodes_.size();
+    for (std::size_t i=0; i<nodes.size(); i++)
+    {
+        Node& node = nodes[i];
+        if (node.elements != NoNode)
+            node.elements += base;
+        for (std::size_t j=0; j<node.children.size(); j++)
+            node.children[j].node += base;
+        nodes_.push_back(node);
+    }
+    return base;
+}
+
+void ParamSchema::AddChild(const char* key, const ParamSchema& schema, bool required)
+{
+    Child child;
+    child.key = key;
+    child.node = AddNodes(schema);
+    child.required = required;
+    nodes_[0].children.push_back(child);
+    if (required)
+        nodes_[0].required++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SchemaValidator::Reset()
+{
+    started_ = false;
+    next_ = ParamSchema::NoNode;
+    stack_.clear();
+    seen_.clear();
+}
+
+std::size_t SchemaValidator::StartValue()
+{
+    std::size_t index;
+    if (stack_.empty())
+    {
+        anyrpc_assert(!started_, AnyRpcErrorInvalidParams, "Value after the end of the params");
+        anyrpc_assert(schema_ != 0, AnyRpcErrorIllegalCall, "No schema to check the params");
+        started_ = true;
+        index = 0;
+    }
+    else
+    {
+        Frame& frame = stack_.back();
+        if (frame.node == ParamSchema::NoNode)
+            return ParamSchema::NoNode;
+        const ParamSchema::Node& node = schema_->GetNode(frame.node);
+        if (node.type == ParamSchema::MapType)
+            index = next_;
+        else
+        {
+            std::size_t element = frame.count++;
+            frame.child = (element < node.children.size()) ? element : ParamSchema::NoNode;
+            if (frame.count > node.maxLength)
+                Mismatch("too many elements");
+            if (frame.child != ParamSchema::NoNode)
+                index = node.children[element].node;
+            else if (node.elements != ParamSchema::NoNode)
+                index = node.elements;
+            else
+                Mismatch("too many elements");
+        }
+    }
+    if ((index == ParamSchema::NoNode) || (schema_->GetNode(index).type == ParamSchema::AnyType))
+        return ParamSchema::NoNode;
+    return index;
+}
+
+std::size_t SchemaValidator::CheckValue(ParamSchema::Type type, std::size_t length)
+{
+    std::size_t index = StartValue();
+    if (index == ParamSchema::NoNode)
+        return index;
+    const ParamSchema::Node& node = schema_->GetNode(index);
+    if ((node.type != type) && !((node.type == ParamSchema::NumberType) && (type == ParamSchema::IntegerType)))
+        Mismatch(std::string("expected ") + TypeName(node.type) + ", found " + TypeName(type));
+    if ((length < node.minLength) || (length > node.maxLength))
+        Mismatch("length out of range");
+    return index;
+}
+
+void SchemaValidator::CheckNumber(ParamSchema::Type type, double d)
+{
+    std::size_t index = CheckValue(type);
+    if (index == ParamSchema::NoNode)
+        return;
+    const ParamSchema::Node& node = schema_->GetNode(index);
+    if (node.hasRange && !((d >= node.min) && (d <= node.max)))
+        Mismatch("out of range");
+}
+
+void SchemaValidator::StartContainer(bool isMap, std::size_t count)
+{
+    std::size_t index = StartValue();
+    if (index != ParamSchema::NoNode)
+    {
+        const ParamSchema::Node& node = schema_->GetNode(index);
+        ParamSchema::Type type = isMap ? ParamSchema::MapType : ParamSchema::ArrayType;
+        if (!isMap && ((node.type == ParamSchema::BinaryType) || (node.type == ParamSchema::DateTimeType)))
+            // extension array that the document converts, the contents aren't checked
+            index = ParamSchema::NoNode;
+        else if (node.type != type)
+            Mismatch(std::string("expected ") + TypeName(node.type) + ", found " + TypeName(type));
+        else if (count > node.maxLength)
+            Mismatch(isMap ? "too many members" : "too many elements");
+    }
+
+    Frame frame;
+    frame.node = index;
+    frame.count = 0;
+    frame.child = ParamSchema::NoNode;
+    frame.hint = 0;
+    frame.seen = seen_.size();
+    frame.required = 0;
+    if (isMap && (index != ParamSchema::NoNode))
+        seen_.resize(seen_.size() + schema_->GetNode(index).children.size(), 0);
+    stack_.push_back(frame);
+}
+
+void SchemaValidator::EndContainer()
+{
+    anyrpc_assert(!stack_.empty(), AnyRpcErrorIllegalCall, "End of a map or array that wasn't started");
+    // remove the frame first so that a fault names the map or array
+    Frame frame = stack_.back();
+    stack_.pop_back();
+    if (frame.node == ParamSchema::NoNode)
+        return;
+
+    const ParamSchema::Node& node = schema_->GetNode(frame.node);
+    if (node.type == ParamSchema::MapType)
+    {
+        if (frame.required < node.required)
+        {
+            for (std::size_t i=0; i<node.children.size(); i++)
+                if (node.children[i].required && !seen_[frame.seen + i])
+                    Mismatch("missing member " + node.children[i].key);
+        }
+        if (frame.count < node.minLength)
+            Mismatch("too few members");
+        seen_.resize(frame.seen);
+    }
+    else if ((frame.count < node.children.size()) || (frame.count < node.minLength))
+        Mismatch("too few elements");
+}
+
+void SchemaValidator::Mismatch(const std::string& reason) const
+{
+    std::ostringstream path;
+    path << "params";
+    for (std::size_t i=0; i<stack_.size(); i++)
+    {
+        const Frame& frame = stack_[i];
+        if (frame.node == ParamSchema::NoNode)
+            break;
+        const ParamSchema::Node& node = schema_->GetNode(frame.node);
+        if (node.type == ParamSchema::MapType)
+        {
+            if (frame.child == ParamSchema::NoNode)
+                break;
+            path << '.' << node.children[frame.child].key;
+        }
+        else if (frame.count > 0)
+            path << '[' << (frame.count - 1) << ']';
+    }
+    anyrpc_throw(AnyRpcErrorInvalidParams, "Invalid parameter " << path.str() << ", " << reason);
+}
+
+void SchemaValidator::Null()
+{
+    CheckValue(ParamSchema::NullType);
+    if (target_)
+        target_->Null();
+}
+
+void SchemaValidator::BoolTrue()
+{
+    CheckValue(ParamSchema::BoolType);
+    if (target_)
+        target_->BoolTrue();
+}
+
+void SchemaValidator::BoolFalse()
+{
+    CheckValue(ParamSchema::BoolType);
+    if (target_)
+        target_->BoolFalse();
+}
+
+void SchemaValidator::DateTime(time_t dt)
+{
+    CheckValue(ParamSchema::DateTimeType);
+    if (target_)
+        target_->DateTime(dt);
+}
+
+void SchemaValidator::String(const char* str, std::size_t length, bool copy)
+{
+    CheckValue(ParamSchema::StringType, length);
+    if (target_)
+        target_->String(str, length, copy);
+}
+
+void SchemaValidator::Binary(const unsigned char* str, std::size_t length, bool copy)
+{
+    CheckValue(ParamSchema::BinaryType, length);
+    if (target_)
+        target_->Binary(str, length, copy);
+}
+
+void SchemaValidator::Int(int i)
+{
+    CheckNumber(ParamSchema::IntegerType, i);
+    if (target_)
+        target_->Int(i);
+}
+
+void SchemaValidator::Uint(unsigned u)
+{
+    CheckNumber(ParamSchema::IntegerType, u);
+    if (target_)
+        target_->Uint(u);
+}
+
+void SchemaValidator::Int64(int64_t i64)
+{
+    CheckNumber(ParamSchema::IntegerType, static_cast<double>(i64));
+    if (target_)
+        target_->Int64(i64);
+}
+
+void SchemaValidator::Uint64(uint64_t u64)
+{
+    CheckNumber(ParamSchema::IntegerType, static_cast<double>(u64));
+    if (target_)
+        target_->Uint64(u64);
+}
+
+void SchemaValidator::Float(float f)
+{
+    CheckNumber(ParamSchema::NumberType, f);
+    if (target_)
+        target_->Float(f);
+}
+
+void SchemaValidator::Double(double d)
+{
+    CheckNumber(ParamSchema::NumberType, d);
+    if (target_)
+        target_->Double(d);
+}
+
+void SchemaValidator::StartMap()
+{
+    StartContainer(true, 0);
+    if (target_)
+        target_->StartMap();
+}
+
+void SchemaValidator::StartMap(std::size_t memberCount)
+{
+    StartContainer(true, memberCount);
+    if (target_)
+        target_->StartMap(memberCount);
+}
+
+void SchemaValidator::Key(const char* str, std::size_t length, bool copy)
+{
+    anyrpc_assert(!stack_.empty(), AnyRpcErrorIllegalCall, "Key outside of a map");
+    Frame& frame = stack_.back();
+    next_ = ParamSchema::NoNode;
+    if (frame.node != ParamSchema::NoNode)
+    {
+        const ParamSchema::Node& node = schema_->GetNode(frame.node);
+        frame.count++;
+        frame.child = schema_->FindMember(frame.node, str, length, frame.hint);
+        if (frame.count > node.maxLength)
+            Mismatch("too many members");
+        if (frame.child != ParamSchema::NoNode)
+        {
+            const ParamSchema::Child& child = node.children[frame.child];
+            if (!seen_[frame.seen + frame.child])
+            {
+                seen_[frame.seen + frame.child] = 1;
+                if (child.required)
+                    frame.required++;
+            }
+            next_ = child.node;
+        }
+        else if (!node.otherMembers)
+            Mismatch("unexpected member " + std::string(str, length));
+    }
+    if (target_)
+        target_->Key(str, length, copy);
+}
+
+void SchemaValidator::EndMap(std::size_t memberCount)
+{
+    EndContainer();
+    if (target_)
+        target_->EndMap(memberCount);
+}
+
+void SchemaValidator::StartArray()
+{
+    StartContainer(false, 0);
+    if (target_)
+        target_->StartArray();
+}
+
+void SchemaValidator::StartArray(std::size_t elementCount)
+{
+    StartContainer(false, elementCount);
+    if (target_)
+        target_->StartArray(elementCount);
+}
+
+void SchemaValidator::EndArray(std::size_t elementCount)
+{
+    EndContainer();
+    if (target_)
+        target_->EndArray(elementCount);
+}
+
+void SchemaValidator::TypedArray(TypedArrayType type, const void* data, std::size_t elementCount)
+{
+    StartContainer(false, elementCount);
+    if (stack_.back().node != ParamSchema::NoNode)
+    {
+        // check each element as if it was a separate number event
+        for (std::size_t i=0; i<elementCount; i++)
+        {
+            switch (type)
+            {
+                case TypedInt32:
+                    CheckNumber(ParamSchema::IntegerType, static_cast<const int32_t*>(data)[i]);
+                    break;
+                case TypedInt64:
+                    CheckNumber(ParamSchema::IntegerType, static_cast<double>(static_cast<const int64_t*>(data)[i]));
+                    break;
+                case TypedUint8:
+                    CheckNumber(ParamSchema::IntegerType, static_cast<const uint8_t*>(data)[i]);
+                    break;
+                case TypedFloat:
+                    CheckNumber(ParamSchema::NumberType, static_cast<const float*>(data)[i]);
+                    break;
+                case TypedDouble:
+                    CheckNumber(ParamSchema::NumberType, static_cast<const double*>(data)[i]);
+                    break;
+                default:
+                    anyrpc_throw(AnyRpcErrorInvalidParams, "Unknown typed array type");
+            }
+        }
+    }
+    EndContainer();
+    if (target_)
+        target_->TypedArray(type, data, elementCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+RequestValidator::RequestValidator(Handler& target, MethodManager* manager) :
+    mapEnvelope_(false), envelopeSize_(0), position_(0), target_(target), manager_(manager), validator_(&target),
+    schema_(0), depth_(0), part_(OtherPart), active_(false), validated_(false), methodFound_(false), paramsFound_(false),
+    repeated_(false)
+{
+}
+
+Handler& RequestValidator::StartValue()
+{
+    if (active_)
+        return validator_;
+    part_ = OtherPart;
+    if (depth_ == 1)
+    {
+        part_ = EnvelopePart();
+        position_++;
+        // the first method and params are executed so a repeated one stops the checks
+        if (part_ == MethodPart)
+        {
+            repeated_ = repeated_ || methodFound_;
+            methodFound_ = true;
+        }
+        else if (part_ == ParamsPart)
+        {
+            repeated_ = repeated_ || paramsFound_;
+            paramsFound_ = true;
+        }
+    }
+    if ((part_ == ParamsPart) && (schema_ != 0) && !repeated_)
+    {
+        validator_.Reset(*schema_);
+        active_ = true;
+        return validator_;
+    }
+    return target_;
+}
+
+Handler& RequestValidator::StartContainer(bool isMap, std::size_t count)
+{
+    Handler& handler = StartValue();
+    if (&handler == &target_)
+    {
+        if (depth_ == 0)
+        {
+            mapEnvelope_ = isMap;
+            envelopeSize_ = count;
+            position_ = 0;
+        }
+        depth_++;
+    }
+    return handler;
+}
+
+Handler& RequestValidator::EndContainer()
+{
+    if (active_)
+        return validator_;
+    depth_--;
+    return target_;
+}
+
+void RequestValidator::EndValue()
+{
+    if (active_ && validator_.IsComplete())
+    {
+        active_ = false;
+        validated_ = true;
+    }
+}
+
+void RequestValidator::Null()
+{
+    StartValue().Null();
+    EndValue();
+}
+
+void RequestValidator::BoolTrue()
+{
+    StartValue().BoolTrue();
+    EndValue();
+}
+
+void RequestValidator::BoolFalse()
+{
+    StartValue().BoolFalse();
+    EndValue();
+}
+
+void RequestValidator::DateTime(time_t dt)
+{
+    StartValue().DateTime(dt);
+    EndValue();
+}
+
+void RequestValidator::String(const char* str, std::size_t length, bool copy)
+{
+    Handler& handler = StartValue();
+    if (!active_ && (part_ == MethodPart) && !repeated_)
+        schema_ = manager_->FindParamSchema(std::string(str, length));
+    handler.String(str, length, copy);
+    EndValue();
+}
+
+void RequestValidator::Binary(const unsigned char* str, std::size_t length, bool copy)
+{
+    StartValue().Binary(str, length, copy);
+    EndValue();
+}
+
+void RequestValidator::Int(int i)
+{
+    StartValue().Int(i);
+    EndValue();
+}
+
+void RequestValidator::Uint(unsigned u)
+{
+    StartValue().Uint(u);
+    EndValue();
+}
+
+void RequestValidator::Int64(int64_t i64)
+{
+    StartValue().Int64(i64);
+    EndValue();
+}
+
+void RequestValidator::Uint64(uint64_t u64)
+{
+    StartValue().Uint64(u64);
+    EndValue();
+}
+
+void RequestValidator::Float(float f)
+{
+    StartValue().Float(f);
+    EndValue();
+}
+
+void RequestValidator::Double(double d)
+{
+    StartValue().Double(d);
+    EndValue();
+}
+
+void RequestValidator::StartMap()
+{
+    StartContainer(true, 0).StartMap();
+}
+
+void RequestValidator::StartMap(std::size_t memberCount)
+{
+    StartContainer(true, memberCount).StartMap(memberCount);
+}
+
+void RequestValidator::Key(const char* str, std::size_t length, bool copy)
+{
+    if (active_)
+        validator_.Key(str, length, copy);
+    else
+    {
+        if (depth_ == 1)
+            key_.assign(str, length);
+        target_.Key(str, length, copy);
+    }
+}
+
+void RequestValidator::MapSeparator()
+{
+    if (active_)
+        validator_.MapSeparator();
+    else
+        target_.MapSeparator();
+}
+
+void RequestValidator::EndMap(std::size_t memberCount)
+{
+    EndContainer().EndMap(memberCount);
+    EndValue();
+}
+
+void RequestValidator::StartArray()
+{
+    StartContainer(false, 0).StartArray();
+}
+
+void RequestValidator::StartArray(std::size_t elementCount)
+{
+    StartContainer(false, elementCount).StartArray(elementCount);
+}
+
+void RequestValidator::ArraySeparator()
+{
+    if (active_)
+        validator_.ArraySeparator();
+    else
+        target_.ArraySeparator();
+}
+
+void RequestValidator::EndArray(std::size_t elementCount)
+{
+    EndContainer().EndArray(elementCount);
+    EndValue();
+}
+
+void RequestValidator::TypedArray(TypedArrayType type, const void* data, std::size_t elementCount)
+{
+    StartValue().TypedArray(type, data, elementCount);
+    EndValue();
+}
+
+} // namespace anyrpc
@@ -48,6 +48,7 @@ Server::Server()
     exit_ = false;
     working_ = false;
     maxConnections_ = 8;
+    arenaBlockSize_ = 0;
     port_ = 0;
 
 #if defined(ANYRPC_THREADING)
@@ -107,9 +108,10 @@ bool Server::BindAndListen(int port, int backlog)
     return true;
 }
 
-void Server::AddHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType)
+void Server::AddHandler(RpcHandler* handler, std::string requestContentType, std::string responseContentType,
+                        RpcParserFactory* parserFactory)
 {
-    handlers_.push_back(RpcContentHandler(handler,requestContentType,responseContentType));
+    handlers_.push_back(RpcContentHandler(handler,requestContentType,responseContentType,parserFactory));
 }
 
 void Server::AddAllHandlers()
@@ -117,7 +119,7 @@ void Server::AddAllHandlers()
 #if defined(ANYRPC_REGEX)
 // Need c++11 compiler to support regular expression
 # if defined(ANYRPC_INCLUDE_JSON)
-    AddHandler( &JsonRpcHandler, "(.*)(json-rpc)", "application/json-rpc" );
+    AddHandler( &JsonRpcHandler, "(.*)(json-rpc)", "application/json-rpc", &JsonRpcCreateParser );
 # endif // defined(ANYRPC_INCLUDE_JSON)
 
 # if defined(ANYRPC_INCLUDE_XML)
@@ -131,7 +133,7 @@ void Server::AddAllHandlers()
 #else
 // Without c++11 compiler, use sub string find
 # if defined(ANYRPC_INCLUDE_JSON)
-    AddHandler( &JsonRpcHandler, "json-rpc", "application/json-rpc" );
+    AddHandler( &JsonRpcHandler, "json-rpc", "application/json-rpc", &JsonRpcCreateParser );
 # endif // defined(ANYRPC_INCLUDE_JSON)
 
 # if defined(ANYRPC_INCLUDE_XML)
@@ -342,6 +344,8 @@ void ServerST::AcceptConnection()
     // Listen for input on this source when we are in work()
     log_info("Creating a connection, fd=" << fd);
     Connection* connection = CreateConnection(fd);
+    if (arenaBlockSize_ > 0)
+        connection->EnableArena(arenaBlockSize_);
     connections_.push_back( connection );
 }
 
@@ -488,6 +492,8 @@ void ServerMT::AcceptConnection()
     {
         log_info("Creating a connection: " << fd);
         Connection* connection = CreateConnection(fd);
+        if (arenaBlockSize_ > 0)
+            connection->EnableArena(arenaBlockSize_);
         connections_.push_back(connection);
         connection->StartThread();
     }
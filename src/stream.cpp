@@ -22,6 +22,8 @@
 #include "anyrpc/logger.h"
 #include "anyrpc/error.h"
 #include "anyrpc/stream.h"
+#include "anyrpc/internal/itoa.h"
+#include "anyrpc/internal/dtoa.h"
 
 namespace anyrpc
 {
@@ -100,6 +102,23 @@ void WriteFileStream::Put(const char *str, size_t n)
     }
 }
 
+char* WriteFileStream::Reserve(size_t length)
+{
+    // the space must fit in the buffer with room for the character that triggers the flush
+    if (length >= bufferSize_)
+        return 0;
+    if (static_cast<size_t>(bufferLast_ - current_) <= length)
+        Flush();
+    return current_;
+}
+
+void WriteFileStream::Commit(size_t length)
+{
+    current_ += length;
+    if (current_ == bufferLast_)
+        Flush();
+}
+
 void WriteFileStream::Flush()
 {
     if (current_ > buffer_)
@@ -297,7 +316,9 @@ void InSituStringStream::Put(const char *str, size_t n)
     {
         anyrpc_assert( src_ >=  (dst_ + n), AnyRpcErrorBufferOverrun, "Dst will overrun src: dst_=" << (void*)dst_ << ", src_=" << (void*)src_ << ", len=" << n );
         n = std::min(static_cast<size_t>(src_ - dst_), n);
-        memcpy(dst_,str,n);
+        // the data may come from the same buffer when it was read with PeekBuffer
+        if (dst_ != str)
+            memmove(dst_,str,n);
         dst_ += n;
     }
 }
@@ -384,6 +405,21 @@ void WriteSegmentedStream::Put(const char *str, size_t n)
     }
 }
 
+char* WriteSegmentedStream::Reserve(size_t length)
+{
+    // the space must be in a single segment, so start a new one if it doesn't fit
+    if (buffers_.back().capacity_ - buffers_.back().used_ < length)
+        AddBuffer(length);
+    BufferSegment& backBuffer = buffers_.back();
+    return backBuffer.buffer_ + backBuffer.used_;
+}
+
+void WriteSegmentedStream::Commit(size_t length)
+{
+    buffers_.back().used_ += length;
+    length_ += length;
+}
+
 const char* WriteSegmentedStream::GetBuffer(size_t offset, size_t& segmentLength)
 {
     segmentLength = 0;
@@ -410,10 +446,11 @@ const char* WriteSegmentedStream::GetBuffer(size_t offset, size_t& segmentLength
     return 0;
 }
 
-void WriteSegmentedStream::AddBuffer()
+void WriteSegmentedStream::AddBuffer(size_t minCapacity)
 {
-    // allocate new buffer and put at the end of the list
-    buffers_.push_back(BufferSegment(static_cast<char*>(malloc(nextCapacity_)), nextCapacity_));
+    // allocate new buffer and put at the end of the list, leaving room for the null termination
+    size_t capacity = std::max(nextCapacity_, minCapacity + 1);
+    buffers_.push_back(BufferSegment(static_cast<char*>(malloc(capacity)), capacity));
     // double the capacity for the next buffer
     nextCapacity_ = std::min( 2*nextCapacity_, maxBufferSize_ );
 }
@@ -442,44 +479,49 @@ anyrpc::Stream& operator<<(anyrpc::Stream& os, const std::string& str)
 
 anyrpc::Stream& operator<<(anyrpc::Stream& os, int i)
 {
-    os.Put(std::to_string(i));
+    char buffer[anyrpc::internal::IntegerStringSize];
+    os.Put( buffer, anyrpc::internal::I32ToString(i, buffer) - buffer );
     return os;
 }
 
 anyrpc::Stream& operator<<(anyrpc::Stream& os, unsigned int u)
 {
-    os.Put(std::to_string(u));
+    char buffer[anyrpc::internal::IntegerStringSize];
+    os.Put( buffer, anyrpc::internal::U32ToString(u, buffer) - buffer );
     return os;
 }
 
 anyrpc::Stream& operator<<(anyrpc::Stream& os, long int li)
 {
-    os.Put(std::to_string(li));
+    char buffer[anyrpc::internal::IntegerStringSize];
+    os.Put( buffer, anyrpc::internal::I64ToString(static_cast<int64_t>(li), buffer) - buffer );
     return os;
 }
 
 anyrpc::Stream& operator<<(anyrpc::Stream& os, unsigned long int uli)
 {
-    os.Put(std::to_string(uli));
+    char buffer[anyrpc::internal::IntegerStringSize];
+    os.Put( buffer, anyrpc::internal::U64ToString(static_cast<uint64_t>(uli), buffer) - buffer );
     return os;
 }
 
 anyrpc::Stream& operator<<(anyrpc::Stream& os, long long int lli)
 {
-    os.Put(std::to_string(lli));
+    char buffer[anyrpc::internal::IntegerStringSize];
+    os.Put( buffer, anyrpc::internal::I64ToString(static_cast<int64_t>(lli), buffer) - buffer );
     return os;
 }
 
 anyrpc::Stream& operator<<(anyrpc::Stream& os, unsigned long long int ulli)
 {
-    os.Put(std::to_string(ulli));
+    char buffer[anyrpc::internal::IntegerStringSize];
+    os.Put( buffer, anyrpc::internal::U64ToString(static_cast<uint64_t>(ulli), buffer) - buffer );
     return os;
 }
 
 anyrpc::Stream& operator<<(anyrpc::Stream& os, double d)
 {
-    char buffer[25];
-    int length = snprintf(buffer, sizeof(buffer), "%g", d);
-    os.Put( buffer, length );
+    char buffer[anyrpc::internal::DoubleStringSize];
+    os.Put( buffer, anyrpc::internal::DoubleToString(d, buffer) - buffer );
     return os;
 }
@@ -0,0 +1,280 @@
+// Copyright (C) 2015 SRG Technology, LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "anyrpc/api.h"
+#include "anyrpc/logger.h"
+#include "anyrpc/error.h"
+#include "anyrpc/value.h"
+#include "anyrpc/handler.h"
+#include "anyrpc/structbinding.h"
+
+namespace anyrpc
+{
+
+void FieldType::TypeMismatch(const char* found) const
+{
+    anyrpc_throw(AnyRpcErrorInvalidParams, "Invalid field, expected " << Name() << ", found " << found);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+StructType::~StructType()
+{
+    for (std::size_t i=0; i<fields_.size(); i++)
+        delete fields_[i].access;
+    for (std::size_t i=0; i<ownedTypes_.size(); i++)
+        delete ownedTypes_[i];
+}
+
+void StructType::AddFieldAccess(const char* name, FieldAccess* access)
+{
+    Field field;
+    field.name = name;
+    field.access = access;
+    fields_.push_back(field);
+}
+
+const FieldType& StructType::AddOwnedType(FieldType* type)
+{
+    ownedTypes_.push_back(type);
+    return *type;
+}
+
+const FieldAccess* StructType::FindField(const char* key, std::size_t length, std::size_t& hint) const
+{
+    std::size_t size = fields_.size();
+    for (std::size_t n=0; n<size; n++)
+    {
+        std::size_t i = (hint + n) % size;
+        const std::string& name = fields_[i].name;
+        if ((name.length() == length) && (memcmp(name.data(), key, length) == 0))
+        {
+            hint = i + 1;
+            return fields_[i].access;
+        }
+    }
+    return 0;
+}
+
+void StructType::Write(const void* object, Handler& handler) const
+{
+    std::size_t size = fields_.size();
+    handler.StartMap(size);
+    for (std::size_t i=0; i<size; i++)
+    {
+        const Field& field = fields_[i];
+        handler.Key(field.name.data(), field.name.length());
+        field.access->GetType().Write(field.access->Get(object), handler);
+        if (i != (size-1))
+            handler.MapSeparator();
+    }
+    handler.EndMap(size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void StructReader::Reset()
+{
+    rootStarted_ = false;
+    skipDepth_ = 0;
+    stack_.clear();
+}
+
+bool StructReader::NextTarget(const FieldType*& type, void*& object)
+{
+    if (skipDepth_ > 0)
+        return false;
+    if (stack_.empty())
+    {
+        anyrpc_assert(!rootStarted_, AnyRpcErrorInvalidParams, "Value after the end of the struct");
+        rootStarted_ = true;
+        type = rootType_;
+        object = root_;
+        return true;
+    }
+    Frame& frame = stack_.back();
+    if (frame.type->GetStructType() != 0)
+    {
+        type = frame.memberType;
+        object = frame.member;
+        return (type != 0);
+    }
+    type = frame.type->GetElementType();
+    object = frame.type->AppendElement(frame.object);
+    return true;
+}
+
+void StructReader::Null()
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->Null(object);
+}
+
+void StructReader::BoolTrue()
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->Bool(object, true);
+}
+
+void StructReader::BoolFalse()
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->Bool(object, false);
+}
+
+void StructReader::DateTime(time_t dt)
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->Int64(object, static_cast<int64_t>(dt));
+}
+
+void StructReader::String(const char* str, std::size_t length, bool /* copy */)
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->String(object, str, length);
+}
+
+void StructReader::Binary(const unsigned char* str, std::size_t length, bool /* copy */)
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->String(object, reinterpret_cast<const char*>(str), length);
+}
+
+void StructReader::Int(int i)
+{
+    Int64(i);
+}
+
+void StructReader::Uint(unsigned u)
+{
+    Uint64(u);
+}
+
+void StructReader::Int64(int64_t i64)
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->Int64(object, i64);
+}
+
+void StructReader::Uint64(uint64_t u64)
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->Uint64(object, u64);
+}
+
+void StructReader::Double(double d)
+{
+    const FieldType* type;
+    void* object;
+    if (NextTarget(type, object))
+        type->Double(object, d);
+}
+
+void StructReader::StartMap()
+{
+    const FieldType* type;
+    void* object;
+    if (!NextTarget(type, object))
+    {
+        skipDepth_++;
+        return;
+    }
+    anyrpc_assert(type->GetStructType() != 0, AnyRpcErrorInvalidParams, "Invalid field, expected " << type->Name() << ", found map");
+    Frame frame = { type, object, 0, 0, 0 };
+    stack_.push_back(frame);
+}
+
+void StructReader::Key(const char* str, std::size_t length, bool /* copy */)
+{
+    if (skipDepth_ > 0)
+        return;
+    Frame& frame = stack_.back();
+    const FieldAccess* access = frame.type->GetStructType()->FindField(str, length, frame.hint);
+    if (access)
+    {
+        frame.memberType = &access->GetType();
+        frame.member = access->Get(frame.object);
+    }
+    else
+    {
+        log_debug("Skip key: " << std::string(str, length));
+        frame.memberType = 0;
+        frame.member = 0;
+    }
+}
+
+void StructReader::EndMap(std::size_t /* memberCount */)
+{
+    if (skipDepth_ > 0)
+        skipDepth_--;
+    else
+        stack_.pop_back();
+}
+
+void StructReader::StartArray()
+{
+    StartArrayInternal(0);
+}
+
+void StructReader::StartArray(std::size_t elementCount)
+{
+    StartArrayInternal(elementCount);
+}
+
+void StructReader::StartArrayInternal(std::size_t elementCount)
+{
+    const FieldType* type;
+    void* object;
+    if (!NextTarget(type, object))
+    {
+        skipDepth_++;
+        return;
+    }
+    anyrpc_assert(type->GetElementType() != 0, AnyRpcErrorInvalidParams, "Invalid field, expected " << type->Name() << ", found array");
+    type->StartArray(object, elementCount);
+    Frame frame = { type, object, 0, 0, 0 };
+    stack_.push_back(frame);
+}
+
+void StructReader::EndArray(std::size_t /* elementCount */)
+{
+    if (skipDepth_ > 0)
+        skipDepth_--;
+    else
+        stack_.pop_back();
+}
+
+} // namespace anyrpc
@@ -21,9 +21,12 @@
 #include "anyrpc/api.h"
 #include "anyrpc/logger.h"
 #include "anyrpc/error.h"
+#include "anyrpc/arena.h"
+#include "anyrpc/keytable.h"
 #include "anyrpc/value.h"
 #include "anyrpc/stream.h"
 #include "anyrpc/handler.h"
+#include "anyrpc/sharedvalue.h"
 #include "anyrpc/internal/base64.h"
 #include "anyrpc/internal/time.h"
 #include "anyrpc/internal/unicode.h"
@@ -56,7 +59,7 @@ Value::Value(ValueType type)
     log_debug("Construct Type: " << type);
     static const unsigned defaultFlags[ValueTypeSize] =
             { InvalidFlag, NullFlag, FalseFlag, TrueFlag, MapFlag, ArrayFlag,
-              ShortStringFlag, NumberAnyFlag, DateTimeType, ShortBinaryFlag };
+              ShortStringFlag, NumberAnyFlag, DateTimeType, ShortBinaryFlag, InvalidFlag };
 
     anyrpc_assert(type < ValueTypeSize, AnyRpcErrorValueAccess, "Illegal type=" << type);
     if (type >= ValueTypeSize)
@@ -257,20 +260,28 @@ Value::~Value()
         }
         else if (IsArray())
         {
-            // destroy the elements and then free the allocated space
-            for (Value* v = data_.a.elements; v != data_.a.elements + data_.a.size; ++v)
-                v->~Value();
-            free(data_.a.elements);
+            // destroy the elements and then free the allocated space, typed array elements are only numbers
+            if (!IsTypedArray())
+                for (Value* v = data_.a.GetElements(); v != data_.a.GetElements() + data_.a.size; ++v)
+                    v->~Value();
+            if ((flags_ & ArenaFlag) == 0)
+                free(data_.a.GetElements());
         }
         else if (IsMap())
         {
             // destroy the keys and values and then free the allocated space
-            for (Member* m = data_.m.members; m != data_.m.members + data_.m.size; ++m)
+            for (Member* m = data_.m.GetElements(); m != data_.m.GetElements() + data_.m.size; ++m)
             {
                 m->key.~Value();
                 m->value.~Value();
             }
-            free(data_.m.members);
+            if ((flags_ & ArenaFlag) == 0)
+                free(data_.m.GetElements());
+        }
+        else if (IsShared())
+        {
+            // remove the reference which may delete the shared data
+            data_.sv->Release();
         }
     }
     flags_ = InvalidFlag;
@@ -402,27 +413,31 @@ void Value::AddMemberCheckCapacity()
         anyrpc_assert(IsMap(), AnyRpcErrorValueAccess, "Not map, type=" << GetType());
 
     Map& m = data_.m;
-    if (m.size >= m.capacity)
+    if (m.size >= m.GetCapacity())
     {
-        if (m.capacity == 0)
+        if (m.GetCapacity() == 0)
         {
-            m.capacity = DefaultMapCapacity;
-            m.members = reinterpret_cast<Member*>(malloc(m.capacity*sizeof(Member)));
+            m.SetCapacity(DefaultMapCapacity);
+            m.SetElements(reinterpret_cast<Member*>(AllocateData(MapAllocationSize(m.GetCapacity()))));
         }
         else
         {
-            uint32_t newCapacity = m.capacity + (m.capacity + 3) / 4;  // grow by 25%, assumes this will still be 32-bits
+            uint32_t newCapacity = RoundCapacity(m.GetCapacity() + (m.GetCapacity() + 3) / 4);  // grow by 25%, assumes this will still be 32-bits
             if (newCapacity > MaxMapCapacity)   // gcc didn't like using std::max() with MaxMapCapacity
                 newCapacity = MaxMapCapacity;
-            m.capacity = newCapacity;
-            m.members = reinterpret_cast<Member*>(realloc(m.members, m.capacity * sizeof(Member)));
+            m.SetElements(reinterpret_cast<Member*>(ReallocateData(m.GetElements(), MapAllocationSize(m.GetCapacity()), MapAllocationSize(newCapacity))));
+            m.SetCapacity(newCapacity);
         }
+        anyrpc_assert(m.GetElements() != 0, AnyRpcErrorMemoryAllocation, "Data allocation failed");
+        // the hash index follows the members so it needs to be rebuilt after a change in capacity
+        if (HashIndexSlots(m.GetCapacity()) > 0)
+            *reinterpret_cast<uint32_t*>(m.GetElements() + m.GetCapacity()) = 0;
     }
-    anyrpc_assert(m.size < m.capacity, AnyRpcErrorMemoryAllocation, "Too many members, size=" << m.size << ", capacity=" << m.capacity);
+    anyrpc_assert(m.size < m.GetCapacity(), AnyRpcErrorMemoryAllocation, "Too many members, size=" << m.size << ", capacity=" << m.GetCapacity());
 
     // initialize the next member as invalid
-    data_.m.members[m.size].key.flags_ = InvalidFlag;
-    data_.m.members[m.size].value.flags_ = InvalidFlag;
+    data_.m.GetElements()[m.size].key.flags_ = InvalidFlag;
+    data_.m.GetElements()[m.size].value.flags_ = InvalidFlag;
 }
 
 Value& Value::AddMember(Value& key, Value& value, bool copy)
@@ -430,41 +445,64 @@ Value& Value::AddMember(Value& key, Value& value, bool copy)
     log_debug("AddMember");
     anyrpc_assert(key.IsString(), AnyRpcErrorValueAccess, "Key is not string, type=" << key.GetType());
     AddMemberCheckCapacity();
-    data_.m.members[data_.m.size].key.Set(key,copy);
-    data_.m.members[data_.m.size].value.Set(value,copy);
+    data_.m.GetElements()[data_.m.size].key.SetKey(key,copy);
+    data_.m.GetElements()[data_.m.size].value.Set(value,copy);
     data_.m.size++;
-    return data_.m.members[data_.m.size-1].value;
+    return data_.m.GetElements()[data_.m.size-1].value;
 }
 
 Value& Value::AddMember(const char* str, std::size_t length, Value& value, bool copy)
 {
     log_debug("AddMember");
     AddMemberCheckCapacity();
-    data_.m.members[data_.m.size].key.SetString(str, length, copy);
-    data_.m.members[data_.m.size].value.Set(value,copy);
+    data_.m.GetElements()[data_.m.size].key.SetKey(str, length, copy);
+    data_.m.GetElements()[data_.m.size].value.Set(value,copy);
+    data_.m.size++;
+    return data_.m.GetElements()[data_.m.size-1].value;
+}
+
+#if ANYRPC_HAS_RVALUE_REFS
+Value& Value::AddMember(Value& key, Value&& value, bool copy)
+{
+    log_debug("AddMember");
+    anyrpc_assert(key.IsString(), AnyRpcErrorValueAccess, "Key is not string, type=" << key.GetType());
+    AddMemberCheckCapacity();
+    data_.m.GetElements()[data_.m.size].key.SetKey(key,copy);
+    data_.m.GetElements()[data_.m.size].value.RawAssign(value);
+    data_.m.size++;
+    return data_.m.GetElements()[data_.m.size-1].value;
+}
+
+Value& Value::AddMember(const char* str, std::size_t length, Value&& value, bool copy)
+{
+    log_debug("AddMember");
+    AddMemberCheckCapacity();
+    data_.m.GetElements()[data_.m.size].key.SetKey(str, length, copy);
+    data_.m.GetElements()[data_.m.size].value.RawAssign(value);
     data_.m.size++;
-    return data_.m.members[data_.m.size-1].value;
+    return data_.m.GetElements()[data_.m.size-1].value;
 }
+#endif
 
 Value& Value::AddMember(Value& key, bool copy)
 {
     log_debug("AddMember, key only");
     anyrpc_assert(key.IsString(), AnyRpcErrorValueAccess, "Key is not string, type=" << key.GetType());
     AddMemberCheckCapacity();
-    data_.m.members[data_.m.size].key.Set(key,copy);
-    data_.m.members[data_.m.size].value.SetInvalid();
+    data_.m.GetElements()[data_.m.size].key.SetKey(key,copy);
+    data_.m.GetElements()[data_.m.size].value.SetInvalid();
     data_.m.size++;
-    return data_.m.members[data_.m.size-1].value;
+    return data_.m.GetElements()[data_.m.size-1].value;
 }
 
 Value& Value::AddMember(const char* str, std::size_t length, bool copy)
 {
     log_debug("AddMember, key only");
     AddMemberCheckCapacity();
-    data_.m.members[data_.m.size].key.SetString(str, length, copy);
-    data_.m.members[data_.m.size].value.SetInvalid();
+    data_.m.GetElements()[data_.m.size].key.SetKey(str, length, copy);
+    data_.m.GetElements()[data_.m.size].value.SetInvalid();
     data_.m.size++;
-    return data_.m.members[data_.m.size-1].value;
+    return data_.m.GetElements()[data_.m.size-1].value;
 }
 
 bool Value::HasMember(const char* str)
@@ -486,13 +524,231 @@ MemberIterator Value::FindMember(const Value& key)
     if (!IsMap())
         return MemberIterator(0);
 
+    // interned keys only need to compare the string pointers
+    const char* interned = key.IsInterned() ? key.data_.s.str : KeyTable::Find(key.GetString(), key.GetStringLength());
+
+    if (HashIndexSlots(data_.m.GetCapacity()) > 0)
+        return MemberIterator(FindMemberIndexed(key, interned));
+
     MemberIterator it;
     for (it=MemberBegin(); it!=MemberEnd(); it++)
-        if (key.StringEqual(it->key))
+        if (KeyEqual(key, interned, it->key))
             break;
     return it;
 }
 
+const Member* Value::FindMemberConst(const Value& key, const char* interned) const
+{
+    const Member* members = data_.m.GetElements();
+    if (HashIndexSlots(data_.m.GetCapacity()) > 0)
+    {
+        const uint32_t* indexed = reinterpret_cast<const uint32_t*>(members + data_.m.GetCapacity());
+        if ((*indexed == data_.m.size) && (data_.m.size > 0))
+        {
+            const uint32_t* slots = indexed + 1;
+            const uint32_t mask = HashIndexSlots(data_.m.GetCapacity()) - 1;
+            uint32_t slot = ((interned != 0) ? KeyTable::GetHash(interned) : HashKey(key)) & mask;
+            while (slots[slot] != 0)
+            {
+                const Member* member = members + slots[slot] - 1;
+                if (KeyEqual(key, interned, member->key))
+                    return member;
+                slot = (slot + 1) & mask;
+            }
+            return 0;
+        }
+    }
+
+    for (uint32_t i=0; i<data_.m.size; i++)
+        if (KeyEqual(key, interned, members[i].key))
+            return members + i;
+    return 0;
+}
+
+const Value* Value::Get(const char* str) const
+{
+    log_debug("Get: " << str);
+    if (IsShared())
+        return data_.sv->GetValue().Get(str);
+    if (!IsMap())
+        return 0;
+
+    Value key(str, false);
+    const Member* member = FindMemberConst(key, KeyTable::Find(key.GetString(), key.GetStringLength()));
+    return (member != 0) ? &member->value : 0;
+}
+
+std::size_t Value::GetMembers(const char* const keys[], std::size_t count, const Value* values[]) const
+{
+    log_debug("GetMembers: count=" << count);
+    if (IsShared())
+        return data_.sv->GetValue().GetMembers(keys, count, values);
+    for (std::size_t k=0; k<count; k++)
+        values[k] = 0;
+    if (!IsMap())
+        return 0;
+
+    // resolve the keys once before searching the members, in groups that fit on the stack
+    const std::size_t maxKeys = 16;
+    if (count > maxKeys)
+        return GetMembers(keys, maxKeys, values) + GetMembers(keys + maxKeys, count - maxKeys, values + maxKeys);
+    Value keyValues[maxKeys];
+    const char* interned[maxKeys];
+    for (std::size_t k=0; k<count; k++)
+    {
+        keyValues[k].SetString(keys[k], false);
+        interned[k] = KeyTable::Find(keys[k], keyValues[k].GetStringLength());
+    }
+
+    std::size_t found = 0;
+    if (HashIndexSlots(data_.m.GetCapacity()) > 0)
+    {
+        // large maps search for each key
+        for (std::size_t k=0; k<count; k++)
+        {
+            const Member* member = FindMemberConst(keyValues[k], interned[k]);
+            if (member != 0)
+            {
+                values[k] = &member->value;
+                found++;
+            }
+        }
+        return found;
+    }
+
+    const Member* members = data_.m.GetElements();
+    for (uint32_t i=0; (i<data_.m.size) && (found<count); i++)
+    {
+        for (std::size_t k=0; k<count; k++)
+        {
+            if ((values[k] == 0) && KeyEqual(keyValues[k], interned[k], members[i].key))
+            {
+                values[k] = &members[i].value;
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+bool Value::KeyEqual(const Value& key, const char* interned, const Value& memberKey)
+{
+    // an interned member key can only match the same interned string since any string
+    // in the table is interned when the member is added
+    if (memberKey.flags_ & InternedFlag)
+        return memberKey.data_.s.str == interned;
+    // the member was added before the key was interned or is a regular key
+    return key.StringEqual(memberKey);
+}
+
+void Value::SetKey(const char* str, std::size_t length, bool copy)
+{
+    const char* interned = KeyTable::Find(str, length);
+    if (interned == 0)
+    {
+        SetString(str, length, copy);
+        return;
+    }
+    this->~Value();
+    flags_ = InternedStringFlag;
+    data_.s.str = interned;
+    data_.s.length = length;
+}
+
+void Value::SetKey(Value& key, bool copy)
+{
+    if (key.IsInterned())
+    {
+        data_ = key.data_;
+        flags_ = key.flags_;
+        return;
+    }
+    const char* interned = KeyTable::Find(key.GetString(), key.GetStringLength());
+    if (interned == 0)
+    {
+        Set(key, copy);
+        return;
+    }
+    flags_ = InternedStringFlag;
+    data_.s.str = interned;
+    data_.s.length = key.GetStringLength();
+    // the key is consumed the same as with Set when it isn't copied
+    if (!copy)
+        key.SetNull();
+}
+
+uint32_t Value::RoundCapacity(std::size_t capacity)
+{
+#if defined(ANYRPC_PACKED_VALUE)
+    // capacities that don't fit in 15 bits are stored in units of 1024
+    if (capacity >= 0x8000)
+        return static_cast<uint32_t>((capacity + 1023) & ~static_cast<std::size_t>(1023));
+#endif
+    return static_cast<uint32_t>(capacity);
+}
+
+// The hash index is stored after the members in the same allocation.  The first word is
+// the number of members that have been added to the index and it is reset to zero
+// whenever the allocation changes.  Each slot holds the member position plus one so
+// that zero marks an empty slot.  Collisions use linear probing.
+
+std::size_t Value::MapAllocationSize(uint32_t capacity)
+{
+    return capacity * sizeof(Member) + ((HashIndexSlots(capacity) > 0) ? (HashIndexSlots(capacity) + 1) * sizeof(uint32_t) : 0);
+}
+
+uint32_t Value::HashIndexSlots(uint32_t capacity)
+{
+    if (capacity < HashIndexMinCapacity)
+        return 0;
+
+    // keep the load factor at or below 0.5
+    uint32_t slots = HashIndexMinCapacity;
+    while (slots < 2 * capacity)
+        slots <<= 1;
+    return slots;
+}
+
+uint32_t Value::HashKey(const Value& key)
+{
+    // the same hash is stored with interned keys
+    if (key.flags_ & InternedFlag)
+        return KeyTable::GetHash(key.data_.s.str);
+    return KeyTable::Hash(key.GetString(), key.GetStringLength());
+}
+
+Member* Value::FindMemberIndexed(const Value& key, const char* interned)
+{
+    uint32_t* indexed = reinterpret_cast<uint32_t*>(data_.m.GetElements() + data_.m.GetCapacity());
+    uint32_t* slots = indexed + 1;
+    const uint32_t mask = HashIndexSlots(data_.m.GetCapacity()) - 1;
+
+    if (*indexed == 0)
+        memset(slots, 0, (mask + 1) * sizeof(uint32_t));
+
+    // add the members since the last search
+    for (; *indexed < data_.m.size; (*indexed)++)
+    {
+        const Value& memberKey = data_.m.GetElements()[*indexed].key;
+        uint32_t slot = HashKey(memberKey) & mask;
+        while ((slots[slot] != 0) && !memberKey.StringEqual(data_.m.GetElements()[slots[slot]-1].key))
+            slot = (slot + 1) & mask;
+        if (slots[slot] == 0)       // keep the first member for duplicate keys
+            slots[slot] = *indexed + 1;
+    }
+
+    uint32_t slot = ((interned != 0) ? KeyTable::GetHash(interned) : HashKey(key)) & mask;
+    while (slots[slot] != 0)
+    {
+        Member* member = data_.m.GetElements() + slots[slot] - 1;
+        if (KeyEqual(key, interned, member->key))
+            return member;
+        slot = (slot + 1) & mask;
+    }
+    return data_.m.GetElements() + data_.m.size;
+}
+
 MemberIterator Value::FindMember(const char* str)
 {
     Value key(str,false);
@@ -521,14 +777,14 @@ MemberIterator Value::MemberBegin()
 {
     anyrpc_assert(IsMap(), AnyRpcErrorValueAccess, "Not map, type=" << GetType());
     if (!IsMap()) return MemberIterator(0);
-    return MemberIterator(data_.m.members);
+    return MemberIterator(data_.m.GetElements());
 }
 
 MemberIterator Value::MemberEnd()
 {
     anyrpc_assert(IsMap(), AnyRpcErrorValueAccess, "Not map, type=" << GetType());
     if (!IsMap()) return MemberIterator(0);
-    return MemberIterator(data_.m.members + data_.m.size);
+    return MemberIterator(data_.m.GetElements() + data_.m.size);
 }
 
 #if defined(ANYRPC_WCHAR)
@@ -536,20 +792,20 @@ Value& Value::AddMember(const wchar_t* ws, std::size_t length, Value& value, boo
 {
     log_debug("AddMember");
     AddMemberCheckCapacity();
-    data_.m.members[data_.m.size].key.SetString(ws, length);
-    data_.m.members[data_.m.size].value.Set(value,copy);
+    data_.m.GetElements()[data_.m.size].key.SetString(ws, length);
+    data_.m.GetElements()[data_.m.size].value.Set(value,copy);
     data_.m.size++;
-    return data_.m.members[data_.m.size-1].value;
+    return data_.m.GetElements()[data_.m.size-1].value;
 }
 
 Value& Value::AddMember(const wchar_t* ws, std::size_t length, bool copy)
 {
     log_debug("AddMember, key only");
     AddMemberCheckCapacity();
-    data_.m.members[data_.m.size].key.SetString(ws, length);
-    data_.m.members[data_.m.size].value.SetInvalid();
+    data_.m.GetElements()[data_.m.size].key.SetString(ws, length);
+    data_.m.GetElements()[data_.m.size].value.SetInvalid();
     data_.m.size++;
-    return data_.m.members[data_.m.size-1].value;
+    return data_.m.GetElements()[data_.m.size-1].value;
 }
 
 bool Value::HasMember(const wchar_t* ws)
@@ -606,8 +862,12 @@ Value& Value::SetArray(std::size_t capacity)
     anyrpc_assert(capacity < MaxArrayCapacity, AnyRpcErrorMemoryAllocation, "Too many elements, size=" << capacity << ", capacity=" << MaxArrayCapacity);
 
     // allocate the data and set to invalid
-    data_.a.elements = (Value*)calloc(capacity, sizeof(Value));
-    data_.a.capacity = static_cast<uint32_t>(capacity);
+    uint32_t roundedCapacity = RoundCapacity(capacity);
+    data_.a.SetElements((Value*)AllocateData(roundedCapacity * sizeof(Value)));
+    anyrpc_assert((data_.a.GetElements() != 0) || (capacity == 0), AnyRpcErrorMemoryAllocation, "Data allocation failed");
+    if (data_.a.GetElements() != 0)
+        memset(data_.a.GetElements(), 0, roundedCapacity * sizeof(Value));
+    data_.a.SetCapacity(roundedCapacity);
     data_.a.size = static_cast<uint32_t>(capacity);
     return *this;
 }
@@ -616,8 +876,9 @@ void Value::Clear()
 {
     log_debug("Clear");
     anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType());
-    for (size_t i = 0; i < data_.a.size; ++i)
-        data_.a.elements[i].~Value();
+    if (!IsTypedArray())
+        for (size_t i = 0; i < data_.a.size; ++i)
+            data_.a.GetElements()[i].~Value();
     data_.a.size = 0;
 }
 
@@ -626,10 +887,12 @@ Value& Value::operator[](std::size_t index)
     if (IsInvalid())
         SetArray();
     anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType());
+    if (IsTypedArray())
+        ExpandTypedArray();
     if (index >= data_.a.size)
         SetSize(index+1);
     anyrpc_assert(index < data_.a.size, AnyRpcErrorIllegalArrayAccess, "Illegal index, size=" << data_.a.size << ", index=" << index);
-    return data_.a.elements[index];
+    return data_.a.GetElements()[index];
 }
 
 Value& Value::Reserve(size_t newCapacity)
@@ -637,11 +900,14 @@ Value& Value::Reserve(size_t newCapacity)
     log_debug("Reserve: newCapacity=" << newCapacity);
     anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType());
     anyrpc_assert(newCapacity < MaxArrayCapacity, AnyRpcErrorMemoryAllocation, "Too many elements, size=" << newCapacity << ", capacity=" << MaxArrayCapacity);
+    if (IsTypedArray())
+        ExpandTypedArray();
 
-    if (newCapacity > data_.a.capacity)
+    if (newCapacity > data_.a.GetCapacity())
     {
-        data_.a.elements = (Value*)realloc(data_.a.elements, newCapacity * sizeof(Value));
-        data_.a.capacity = static_cast<uint32_t>(newCapacity);
+        newCapacity = RoundCapacity(newCapacity);
+        data_.a.SetElements((Value*)ReallocateData(data_.a.GetElements(), data_.a.GetCapacity() * sizeof(Value), newCapacity * sizeof(Value)));
+        data_.a.SetCapacity(static_cast<uint32_t>(newCapacity));
     }
     return *this;
 }
@@ -653,33 +919,170 @@ Value& Value::SetSize(size_t newSize)
         SetArray();
     anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType());
     anyrpc_assert(newSize < MaxArrayCapacity, AnyRpcErrorMemoryAllocation, "Too many elements, size=" << newSize << ", capacity=" << MaxArrayCapacity);
+    if (IsTypedArray())
+        ExpandTypedArray();
 
-    if (newSize > data_.a.capacity)
+    if (newSize > data_.a.GetCapacity())
     {
-        data_.a.elements = (Value*)realloc(data_.a.elements, newSize * sizeof(Value));
-        data_.a.capacity = static_cast<uint32_t>(newSize);
+        uint32_t newCapacity = RoundCapacity(newSize);
+        data_.a.SetElements((Value*)ReallocateData(data_.a.GetElements(), data_.a.GetCapacity() * sizeof(Value), newCapacity * sizeof(Value)));
+        data_.a.SetCapacity(newCapacity);
     }
     if (newSize > data_.a.size)
     {
         for (size_t i=data_.a.size; i<newSize; i++)
-            data_.a.elements[i].flags_ = InvalidFlag;
+            data_.a.GetElements()[i].flags_ = InvalidFlag;
     }
     else
     {
         for (size_t i=newSize; i<data_.a.size; i++)
-            data_.a.elements[i].~Value();
+            data_.a.GetElements()[i].~Value();
     }
     data_.a.size = static_cast<uint32_t>(newSize);
     return *this;
 }
 
+Value& Value::SetTypedArray(TypedArrayType type, std::size_t size)
+{
+    log_debug("SetTypedArray: type=" << type << ", size=" << size);
+    anyrpc_assert((type > TypedNone) && (type < TypedArrayTypeSize), AnyRpcErrorValueAccess, "Illegal typed array type=" << type);
+    anyrpc_assert(size < MaxArrayCapacity, AnyRpcErrorMemoryAllocation, "Too many elements, size=" << size << ", capacity=" << MaxArrayCapacity);
+    this->~Value();
+    new (this) Value(ArrayType);
+    flags_ |= type << TypedArrayShift;
+
+    uint32_t capacity = RoundCapacity(size);
+    std::size_t bytes = capacity * TypedArrayElementSize(type);
+    data_.a.SetElements(static_cast<Value*>(AllocateData(bytes)));
+    anyrpc_assert((data_.a.GetElements() != 0) || (size == 0), AnyRpcErrorMemoryAllocation, "Data allocation failed");
+    if (data_.a.GetElements() != 0)
+        memset(data_.a.GetElements(), 0, bytes);
+    data_.a.SetCapacity(capacity);
+    data_.a.size = static_cast<uint32_t>(size);
+    return *this;
+}
+
+Value& Value::SetTypedArray(TypedArrayType type, const void* data, std::size_t size)
+{
+    SetTypedArray(type, size);
+    if (size > 0)
+        memcpy(data_.a.GetElements(), data, size * TypedArrayElementSize(type));
+    return *this;
+}
+
+std::size_t Value::TypedArrayElementSize(TypedArrayType type)
+{
+    static const std::size_t elementSize[TypedArrayTypeSize] =
+            { 0, sizeof(int32_t), sizeof(int64_t), sizeof(float), sizeof(double), sizeof(uint8_t) };
+    return (type < TypedArrayTypeSize) ? elementSize[type] : 0;
+}
+
+bool Value::PackTypedArray()
+{
+    if (!IsArray() || IsTypedArray() || (data_.a.size == 0))
+        return false;
+
+    // the type of the first element determines the requirement for the others
+    Value* elements = data_.a.GetElements();
+    uint32_t size = data_.a.size;
+    TypedArrayType type;
+    unsigned required;
+    if (elements[0].IsDouble())
+        { type = TypedDouble; required = DoubleFlag; }
+    else if (elements[0].IsFloat())
+        { type = TypedFloat; required = FloatFlag; }
+    else if (elements[0].IsInt())
+        { type = TypedInt32; required = IntFlag; }
+    else if (elements[0].IsInt64())
+        { type = TypedInt64; required = Int64Flag; }
+    else
+        return false;
+
+    for (uint32_t i=1; i<size; i++)
+    {
+        if ((elements[i].flags_ & required) == 0)
+        {
+            // integers that don't all fit in 32 bits may still fit in 64 bits
+            if ((type != TypedInt32) || !elements[i].IsInt64())
+                return false;
+            type = TypedInt64;
+            required = Int64Flag;
+            i = 0;
+        }
+        else if ((type == TypedFloat) && elements[i].IsDouble())
+            return false;
+    }
+
+    // the elements are only numbers so they don't need to be destroyed
+    bool arenaElements = (flags_ & ArenaFlag) != 0;
+    flags_ = ArrayFlag | (type << TypedArrayShift);
+    uint32_t capacity = RoundCapacity(size);
+    void* data = AllocateData(capacity * TypedArrayElementSize(type));
+    anyrpc_assert(data != 0, AnyRpcErrorMemoryAllocation, "Data allocation failed");
+    for (uint32_t i=0; i<size; i++)
+    {
+        switch (type)
+        {
+            case TypedInt32:  static_cast<int32_t*>(data)[i] = elements[i].data_.n.i.i; break;
+            case TypedInt64:  static_cast<int64_t*>(data)[i] = elements[i].data_.n.i64; break;
+            case TypedFloat:  static_cast<float*>(data)[i] = elements[i].data_.n.f; break;
+            default:          static_cast<double*>(data)[i] = elements[i].data_.n.d; break;
+        }
+    }
+    if (!arenaElements)
+        free(elements);
+    data_.a.SetElements(static_cast<Value*>(data));
+    data_.a.SetCapacity(capacity);
+    return true;
+}
+
+Value& Value::ExpandTypedArray()
+{
+    log_debug("ExpandTypedArray");
+    if (!IsTypedArray())
+        return *this;
+
+    // allocate the Value elements while the typed data is still accessible
+    void* data = data_.a.GetElements();
+    bool arenaData = (flags_ & ArenaFlag) != 0;
+    flags_ &= ~ArenaFlag;
+    uint32_t capacity = RoundCapacity(data_.a.size);
+    Value* elements = static_cast<Value*>(AllocateData(capacity * sizeof(Value)));
+    anyrpc_assert((elements != 0) || (data_.a.size == 0), AnyRpcErrorMemoryAllocation, "Data allocation failed");
+    for (uint32_t i=0; i<data_.a.size; i++)
+        new (elements + i) Value(TypedArrayElement(i));
+
+    if (!arenaData)
+        free(data);
+    flags_ &= ~TypedArrayMask;
+    data_.a.SetElements(elements);
+    data_.a.SetCapacity(capacity);
+    return *this;
+}
+
+Value Value::TypedArrayElement(std::size_t index) const
+{
+    const void* data = data_.a.GetElements();
+    switch (GetTypedArrayType())
+    {
+        case TypedInt32:    return Value(static_cast<int>(static_cast<const int32_t*>(data)[index]));
+        case TypedInt64:    return Value(static_cast<const int64_t*>(data)[index]);
+        case TypedFloat:    return Value(static_cast<const float*>(data)[index]);
+        case TypedDouble:   return Value(static_cast<const double*>(data)[index]);
+        case TypedUint8:    return Value(static_cast<unsigned>(static_cast<const uint8_t*>(data)[index]));
+        default:            return Value();
+    }
+}
+
 Value& Value::PushBack(Value& value)
 {
     log_debug("PushBack");
     anyrpc_assert(IsArray(), AnyRpcErrorValueAccess, "Not Array, type=" << GetType());
-    if (data_.a.size >= data_.a.capacity)
-        Reserve( (data_.a.capacity == 0) ? DefaultArrayCapacity : (data_.a.capacity + (data_.a.capacity + 1) / 2));
-    data_.a.elements[data_.a.size++].RawAssign(value);
+    if (IsTypedArray())
+        ExpandTypedArray();
+    if (data_.a.size >= data_.a.GetCapacity())
+        Reserve( (data_.a.GetCapacity() == 0) ? DefaultArrayCapacity : (data_.a.GetCapacity() + (data_.a.GetCapacity() + 1) / 2));
+    data_.a.GetElements()[data_.a.size++].RawAssign(value);
     return *this;
 }
 
@@ -857,11 +1260,14 @@ void Value::CopyString(const char* s, size_t length)
     }
     else
     {
-        str = (char *) malloc((length + 1) * sizeof(char));
+        flags_ = CopyStringFlag;
+        str = (char *) AllocateData((length + 1) * sizeof(char));
         anyrpc_assert(str != 0, AnyRpcErrorMemoryAllocation, "Data allocation failed");
         if (str == 0)
+        {
+            flags_ = NullFlag;
             return;
-        flags_ = CopyStringFlag;
+        }
         data_.s.length = length;
         data_.s.str = str;
     }
@@ -881,17 +1287,52 @@ void Value::CopyBinary(const unsigned char* s, size_t length)
     }
     else
     {
-        str = (char *) malloc(length);
+        flags_ = CopyBinaryFlag;
+        str = (char *) AllocateData(length);
         anyrpc_assert(str != 0, AnyRpcErrorMemoryAllocation, "Data allocation failed");
         if (str == 0)
+        {
+            flags_ = NullFlag;
             return;
-        flags_ = CopyBinaryFlag;
+        }
         data_.s.length = length;
         data_.s.str = str;
     }
     std::memcpy(str, s, length);
 }
 
+// Allocate from the current arena if there is one.  The flags_ must already be set
+// for the type since the ArenaFlag is added to them.
+void* Value::AllocateData(std::size_t size)
+{
+    MemoryArena* arena = MemoryArena::GetCurrent();
+    if (arena == 0)
+        return malloc(size);
+    flags_ |= ArenaFlag;
+    return arena->Malloc(size);
+}
+
+void* Value::ReallocateData(void* ptr, std::size_t oldSize, std::size_t newSize)
+{
+    if (ptr == 0)
+        return AllocateData(newSize);
+    if ((flags_ & ArenaFlag) == 0)
+        return realloc(ptr, newSize);
+
+    MemoryArena* arena = MemoryArena::GetCurrent();
+    if (arena != 0)
+        return arena->Realloc(ptr, oldSize, newSize);
+
+    // the arena is no longer current so move the data to the heap
+    void* newPtr = malloc(newSize);
+    if (newPtr != 0)
+    {
+        memcpy(newPtr, ptr, std::min(oldSize, newSize));
+        flags_ &= ~ArenaFlag;
+    }
+    return newPtr;
+}
+
 // Assignment without calling destructor
 void Value::RawAssign(Value& rhs)
 {
@@ -986,7 +1427,10 @@ std::ostream& Value::WriteStreamInternal(std::ostream& os) const
             os << "[";
             for (size_t i=0; i<data_.a.size; i++)
             {
-                data_.a.elements[i].WriteStreamInternal(os);
+                if (IsTypedArray())
+                    TypedArrayElement(i).WriteStreamInternal(os);
+                else
+                    data_.a.GetElements()[i].WriteStreamInternal(os);
                 if (i != (data_.a.size-1))
                     os << ",";
             }
@@ -996,14 +1440,17 @@ std::ostream& Value::WriteStreamInternal(std::ostream& os) const
             os << "{";
             for (size_t i=0; i<data_.m.size; i++)
             {
-                data_.m.members[i].key.WriteStreamInternal(os);
+                data_.m.GetElements()[i].key.WriteStreamInternal(os);
                 os << ":";
-                data_.m.members[i].value.WriteStreamInternal(os);
+                data_.m.GetElements()[i].value.WriteStreamInternal(os);
                 if (i != (data_.m.size-1))
                     os << ",";
             }
             os << "}";
             break;
+        case SharedType:
+            data_.sv->GetValue().WriteStreamInternal(os);
+            break;
         default:
             break;
     }
@@ -1057,10 +1504,15 @@ void Value::TraverseInternal(Handler& handler) const
             handler.Binary( GetBinary(), GetBinaryLength() );
             break;
         case ArrayType:
+            if (IsTypedArray())
+            {
+                handler.TypedArray(GetTypedArrayType(), data_.a.GetElements(), data_.a.size);
+                break;
+            }
             handler.StartArray(data_.a.size);
             for (size_t i=0; i<data_.a.size; i++)
             {
-                data_.a.elements[i].TraverseInternal(handler);
+                data_.a.GetElements()[i].TraverseInternal(handler);
                 if (i != (data_.a.size-1))
                     handler.ArraySeparator();
             }
@@ -1070,7 +1522,7 @@ void Value::TraverseInternal(Handler& handler) const
             handler.StartMap(data_.m.size);
             for (size_t i=0; i<data_.m.size; i++)
             {
-                Member *member = &data_.m.members[i];
+                Member *member = &data_.m.GetElements()[i];
                 anyrpc_assert(member->key.IsString(), AnyRpcErrorValueAccess, "Key is not string, type=" << member->key.GetType());
                 handler.Key( member->key.GetString(), member->key.GetStringLength() );
                 member->value.TraverseInternal(handler);
@@ -1079,11 +1531,32 @@ void Value::TraverseInternal(Handler& handler) const
             }
             handler.EndMap(data_.m.size);
             break;
+        case SharedType:
+            data_.sv->GetValue().TraverseInternal(handler);
+            break;
         default:
             break;
     }
 }
 
+Value& Value::SetShared(SharedValue* shared)
+{
+    log_debug("SetShared");
+    anyrpc_assert(shared != 0, AnyRpcErrorValueAccess, "No shared value");
+    // add the reference first in case this already references the shared value
+    shared->AddRef();
+    this->~Value();
+    flags_ = SharedFlag;
+    data_.sv = shared;
+    return *this;
+}
+
+const Value& Value::GetShared() const
+{
+    anyrpc_assert(IsShared(), AnyRpcErrorValueAccess, "Not shared, type=" << GetType());
+    return data_.sv->GetValue();
+}
+
 void Value::Set(Value& value, bool copy)
 {
     if (copy)
@@ -1112,6 +1585,13 @@ void Value::CopyInternal(const Value& value)
             flags_ = value.flags_;
             break;
         case StringType:
+            if (value.flags_ & InternedFlag)
+            {
+                // interned strings are never freed so the reference can be copied
+                data_ = value.data_;
+                flags_ = value.flags_;
+                break;
+            }
             SetString( (value.flags_ & InlineStrFlag) ? value.data_.ss.str : value.data_.s.str,
                        (value.flags_ & InlineStrFlag) ? value.data_.ss.GetLength() : value.data_.s.length );
             break;
@@ -1120,14 +1600,25 @@ void Value::CopyInternal(const Value& value)
                        (value.flags_ & InlineStrFlag) ? value.data_.ss.GetLength() : value.data_.s.length );
             break;
         case ArrayType:
+            if (value.IsTypedArray())
+            {
+                SetTypedArray(value.GetTypedArrayType(), value.data_.a.GetElements(), value.data_.a.size);
+                break;
+            }
             SetArray(value.data_.a.size);
             for (size_t i=0; i<value.data_.a.size; i++)
-                data_.a.elements[i].CopyInternal(value.data_.a.elements[i]);
+                data_.a.GetElements()[i].CopyInternal(value.data_.a.GetElements()[i]);
+            break;
+        case SharedType:
+            // the data is immutable so only another reference is needed
+            data_.sv = value.data_.sv;
+            flags_ = SharedFlag;
+            data_.sv->AddRef();
             break;
         case MapType:
             SetMap();
             for (size_t i=0; i<value.data_.m.size; i++)
-                AddMember(value.data_.m.members[i].key.GetString(), value.data_.m.members[i].value);
+                AddMember(value.data_.m.GetElements()[i].key.GetString(), value.data_.m.GetElements()[i].value);
             break;
         default:
             break;
@@ -1164,7 +1655,7 @@ bool Value::ConvertBase64()
     }
 
     // convert to binary type
-    flags_ = (flags_ & (CopyFlag | InlineStrFlag)) | BinaryType | BinaryFlag;
+    flags_ = (flags_ & (CopyFlag | InlineStrFlag | ArenaFlag)) | BinaryType | BinaryFlag;
 
     if (flags_ == ShortBinaryFlag)
         data_.ss.SetLength(convertedLength);
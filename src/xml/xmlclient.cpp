@@ -29,6 +29,7 @@
 #include "anyrpc/method.h"
 #include "anyrpc/socket.h"
 #include "anyrpc/client.h"
+#include "anyrpc/balancedclient.h"
 #include "anyrpc/xml/xmlwriter.h"
 #include "anyrpc/xml/xmlreader.h"
 #include "anyrpc/xml/xmlclient.h"
@@ -39,6 +40,18 @@ namespace anyrpc
 //! Only need one instance of the XmlClientHandler since there is no local storage.
 static XmlClientHandler XmlClientHandler;
 
+//! Get the fields of a fault struct with a single pass through the members
+static bool XmlGetFault(Value& value, int& faultCode, std::string& faultString)
+{
+    static const char* const keys[] = { "faultCode", "faultString" };
+    const Value* members[2];
+    if ((value.GetMembers(keys, 2, members) != 2) || !members[0]->IsInt() || !members[1]->IsString())
+        return false;
+    faultCode = members[0]->GetInt();
+    faultString.assign(members[1]->GetString(), members[1]->GetStringLength());
+    return true;
+}
+
 XmlHttpClient::XmlHttpClient() : HttpClient(&XmlClientHandler, "text/xml") {}
 
 XmlHttpClient::XmlHttpClient(const char* host, int port) :
@@ -110,10 +123,12 @@ ProcessResponseEnum XmlClientHandler::ProcessResponse(char* response, size_t len
         {
             // looks like a fault response - verify that it is properly formated
             result.Assign( doc.GetValue() );
-            if (result.HasMember("faultCode") && result.HasMember("faultString"))
+            int faultCode;
+            std::string faultString;
+            if (XmlGetFault(result, faultCode, faultString))
             {
                 // standard xmlrpc fault codes - copy fault codes to the standard names
-                GenerateFaultResult(result["faultCode"].GetInt(), result["faultString"].GetString(), result);
+                GenerateFaultResult(faultCode, faultString, result);
                 // keep the connection open
                 processResponse =  ProcessResponseErrorKeepOpen;
             }
@@ -139,4 +154,112 @@ ProcessResponseEnum XmlClientHandler::ProcessResponse(char* response, size_t len
     return processResponse;
 }
 
+bool XmlClientHandler::GenerateBatchRequest(Batch& batch, Stream& os, std::vector<unsigned>& requestIds)
+{
+    log_trace();
+
+    // system.multicall has a single param with an array of structs for each call
+    Value calls;
+    calls.SetSize(batch.GetSize());
+    std::vector<bool> arrayParams(batch.GetSize());
+    for (std::size_t i=0; i<batch.GetSize(); i++)
+    {
+        calls[i]["methodName"] = batch.GetMethod(i);
+        Value& params = batch.GetParams(i);
+        arrayParams[i] = params.IsArray();
+        if (arrayParams[i])
+            calls[i]["params"].Assign(params);
+        else
+            calls[i]["params"].SetSize(1)[0].Assign(params);
+    }
+    requestIds.assign(batch.GetSize(), 0);
+
+    os.Put("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\r\n");
+    os.Put("<methodCall><methodName>system.multicall</methodName><params><param>");
+    XmlWriter xmlStrWriter(os);
+    calls.Traverse(xmlStrWriter);
+    os.Put("</param></params></methodCall>");
+
+    // move the params back so they are still available in the batch
+    for (std::size_t i=0; i<batch.GetSize(); i++)
+    {
+        if (arrayParams[i])
+            batch.GetParams(i).Assign(calls[i]["params"]);
+        else
+            batch.GetParams(i).Assign(calls[i]["params"][0]);
+    }
+
+    return true;
+}
+
+ProcessResponseEnum XmlClientHandler::ProcessBatchResponse(char* response, size_t length, Batch& batch, std::vector<unsigned>& /* requestIds */)
+{
+    log_trace();
+    ProcessResponseEnum processResponse = ProcessResponseErrorClose;
+    Value result;
+    try
+    {
+        Document doc;
+
+        InSituStringStream sstream(response, length);
+        XmlReader reader(sstream);
+
+        reader.ParseResponse(doc);
+        Value& value = doc.GetValue();
+        int faultCode;
+        std::string faultString;
+        if (reader.HasParseError())
+        {
+            std::stringstream message;
+            message << "Response parse error, offset=" << reader.GetErrorOffset();
+            message << ", code=" << reader.GetParseErrorCode();
+            message << ", message=" << reader.GetParseErrorStr();
+            GenerateFaultResult(AnyRpcErrorResponseParseError, message.str(), result);
+        }
+        else if (XmlGetFault(value, faultCode, faultString))
+        {
+            // the entire multicall failed
+            GenerateFaultResult(faultCode, faultString, result);
+            processResponse =  ProcessResponseErrorKeepOpen;
+        }
+        else if (!value.IsArray() || (value.Size() != 1) ||
+                 !value[0].IsArray() || (value[0].Size() != batch.GetSize()))
+            GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, wrong field types", result);
+        else
+        {
+            // each result is either an array with a single value or a fault struct
+            processResponse = ProcessResponseSuccess;
+            Value& results = value[0];
+            for (std::size_t i=0; i<batch.GetSize(); i++)
+            {
+                Value singleResult;
+                Value& single = results[i];
+                if (single.IsArray() && (single.Size() == 1))
+                {
+                    // the result references the receive buffer which is reused for the next response
+                    singleResult.Copy(single[0]);
+                    batch.SetResult(i, singleResult, true);
+                    continue;
+                }
+                if (XmlGetFault(single, faultCode, faultString))
+                    GenerateFaultResult(faultCode, faultString, singleResult);
+                else
+                    GenerateFaultResult(AnyRpcErrorInvalidResponse, "Invalid response, wrong field types", singleResult);
+                batch.SetResult(i, singleResult, false);
+                processResponse = ProcessResponseErrorKeepOpen;
+            }
+            return processResponse;
+        }
+    }
+    catch (AnyRpcException &fault)
+    {
+        std::stringstream buffer;
+        buffer << "Unhandled system error, Code:" << fault.GetCode() << ", Message:" << fault.GetMessage();
+        GenerateFaultResult(AnyRpcErrorSystemError, buffer.str(), result);
+    }
+
+    batch.SetAllResults(result, false);
+    return processResponse;
+}
+
 } // namespace anyrpc
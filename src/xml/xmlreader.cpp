@@ -528,7 +528,6 @@ void XmlReader::ParseNumber(int tag)
     unsigned i = 0;
     uint64_t i64 = 0;
     bool use64bit = false;
-    int significandDigit = 0;
     if (is_.Peek() == '0')
     {
         i = 0;
@@ -550,7 +549,6 @@ void XmlReader::ParseNumber(int tag)
                     }
                 }
                 i = i * 10 + static_cast<unsigned>(is_.Get() - '0');
-                significandDigit++;
             }
         else
             while (isdigit(is_.Peek()))
@@ -564,7 +562,6 @@ void XmlReader::ParseNumber(int tag)
                     }
                 }
                 i = i * 10 + static_cast<unsigned>(is_.Get() - '0');
-                significandDigit++;
             }
     }
     else
@@ -572,7 +569,7 @@ void XmlReader::ParseNumber(int tag)
 
     // Parse 64bit int
     bool useDouble = false;
-    double d = 0.0;
+    internal::DecimalDigits digits;
     if (use64bit)
     {
         if (minus)
@@ -581,12 +578,10 @@ void XmlReader::ParseNumber(int tag)
                  if (i64 >= ANYRPC_UINT64_C2(0x0CCCCCCC, 0xCCCCCCCC)) // 2^63 = 9223372036854775808
                     if ((i64 != ANYRPC_UINT64_C2(0x0CCCCCCC, 0xCCCCCCCC)) || (is_.Peek() > '8'))
                     {
-						d = static_cast<double>(i64);
                         useDouble = true;
                         break;
                     }
                 i64 = i64 * 10 + static_cast<unsigned>(is_.Get() - '0');
-                significandDigit++;
             }
         else
             while (isdigit(is_.Peek()))
@@ -594,22 +589,26 @@ void XmlReader::ParseNumber(int tag)
                 if (i64 >= ANYRPC_UINT64_C2(0x19999999, 0x99999999)) // 2^64 - 1 = 18446744073709551615
                     if ((i64 != ANYRPC_UINT64_C2(0x19999999, 0x99999999)) || (is_.Peek() > '5'))
                     {
-						d = static_cast<double>(i64);
                         useDouble = true;
                         break;
                     }
                 i64 = i64 * 10 + static_cast<unsigned>(is_.Get() - '0');
-                significandDigit++;
             }
     }
 
     // Force double for big integer
+    bool exactSignificand = false;      // i64 holds all of the non-zero digits for the Eisel-Lemire conversion
+    int expInt = 0;                     // integer digits that are not in i64
     if (useDouble) {
+        exactSignificand = true;
         while (isdigit(is_.Peek()))
         {
-            if (d >= 1.7976931348623157e307) // DBL_MAX / 10.0
+            if (expInt >= 309)
                 anyrpc_throw(AnyRpcErrorNumberTooBig, "Number too big to be stored in double");
-            d = d * 10 + (is_.Get() - '0');
+            char c = is_.Get();
+            exactSignificand = exactSignificand && (c == '0');
+            expInt++;
+            digits.Append(c);
         }
     }
 
@@ -624,41 +623,28 @@ void XmlReader::ParseNumber(int tag)
 
         if (!useDouble)
         {
-#if ANYRPC_64BIT
-            // Use i64 to store significand in 64-bit architecture
+            // Use i64 to store the significand
             if (!use64bit)
                 i64 = i;
 
             while (isdigit(is_.Peek()))
             {
-                if (i64 > ANYRPC_UINT64_C2(0x1FFFFF, 0xFFFFFFFF)) // 2^53 - 1 for fast path
+                if (i64 >= ANYRPC_UINT64_C2(0x19999999, 0x99999999)) // another digit could overflow
                     break;
-                else
-                {
-                    i64 = i64 * 10 + static_cast<unsigned>(is_.Get() - '0');
-                    --expFrac;
-                    if (i64 != 0)
-                        significandDigit++;
-                }
+                i64 = i64 * 10 + static_cast<unsigned>(is_.Get() - '0');
+                --expFrac;
             }
 
-            d = (double)i64;
-#else
-            // Use double to store significand in 32-bit architecture
-            d = use64bit ? (double)i64 : (double)i;
-#endif
+            exactSignificand = !isdigit(is_.Peek());
             useDouble = true;
         }
+        else
+            exactSignificand = false;
+        // keep the digits that don't fit in i64 for the exact conversion
         while (isdigit(is_.Peek()))
         {
-            if (significandDigit < 17) {
-                d = d * 10.0 + (is_.Get() - '0');
-                --expFrac;
-                if (d != 0.0)
-                    significandDigit++;
-            }
-            else
-                is_.Get();
+            digits.Append(is_.Get());
+            --expFrac;
         }
     }
 
@@ -668,7 +654,9 @@ void XmlReader::ParseNumber(int tag)
     {
         if (!useDouble)
         {
-			d = use64bit ? static_cast<double>(i64) : i;
+            if (!use64bit)
+                i64 = i;
+            exactSignificand = true;
             useDouble = true;
         }
         is_.Get();
@@ -703,7 +691,10 @@ void XmlReader::ParseNumber(int tag)
     if (useDouble)
     {
         int p = exp + expFrac;
-        d = internal::StrtodNormalPrecision(d, p);
+        double d;
+        // the numbers with more digits or near the ends of the range need the exact conversion
+        if ((!exactSignificand || !internal::EiselLemire(i64, p + expInt, d)) && !internal::StrtodExact(i64, digits, p, d))
+            anyrpc_throw(AnyRpcErrorNumberTooBig, "Number too big to be stored in double");
 
         if (tag != doubleTag)
             anyrpc_throw(AnyRpcErrorTagInvalid, PARSE_ERROR_FOUND_EXPECTED(tag,doubleTag));
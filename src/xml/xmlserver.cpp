@@ -21,6 +21,7 @@
 #include "anyrpc/api.h"
 #include "anyrpc/logger.h"
 #include "anyrpc/error.h"
+#include "anyrpc/arena.h"
 #include "anyrpc/value.h"
 #include "anyrpc/stream.h"
 #include "anyrpc/handler.h"
@@ -37,6 +38,7 @@
 namespace anyrpc
 {
 
+static bool XmlProcessRequest(MethodManager* manager, char* request, size_t length, Stream &response);
 static void XmlExecuteMultiCall(MethodManager* manager, Value &params, Value &result);
 static void XmlGenerateResponse(Value &result, Stream &response);
 static void XmlGenerateFaultResponse(int errorCode, std::string const& errorMsg, Stream &response);
@@ -47,6 +49,17 @@ log_define("AnyRPC.RpcHandler");
 ////////////////////////////////////////////////////////////////////////////////
 
 bool XmlRpcHandler(MethodManager* manager, char* request, size_t length, Stream &response)
+{
+    bool sendResponse = XmlProcessRequest(manager, request, length, response);
+
+    // the values for the request have been destroyed so the arena space can be reused
+    MemoryArena* arena = MemoryArena::GetCurrent();
+    if (arena != 0)
+        arena->Reset();
+    return sendResponse;
+}
+
+static bool XmlProcessRequest(MethodManager* manager, char* request, size_t length, Stream &response)
 {
     InSituStringStream sstream(request, length);
     XmlReader reader(sstream);
@@ -108,18 +121,17 @@ static void XmlExecuteMultiCall(MethodManager* manager, Value &params, Value &re
         Value singleParams;
         singleParams.Assign(params[i]);
         log_debug("Execute index " << i << ": params= " << singleParams);
-        if (!singleParams.IsMap() ||
-            !singleParams.HasMember("methodName") ||
-            !singleParams["methodName"].IsString() ||
-            !singleParams.HasMember("params"))
+        static const char* const keys[] = { "methodName", "params" };
+        Value* members[2];
+        if ((singleParams.GetMembers(keys, 2, members) != 2) ||
+            !members[0]->IsString())
             XmlGenerateFaultValue(AnyRpcErrorInvalidRequest, "Invalid request", result[i]);
         else
         {
             Value singleResult;
-            Value methodName = singleParams["methodName"];
             try
             {
-                if (manager->ExecuteMethod(methodName.GetString(),singleParams["params"],singleResult))
+                if (manager->ExecuteMethod(members[0]->GetString(),*members[1],singleResult))
                 {
                     if (singleResult.IsInvalid())
                         singleResult = "";
@@ -26,7 +26,9 @@
 #include "anyrpc/handler.h"
 #include "anyrpc/internal/base64.h"
 #include "anyrpc/internal/time.h"
-#include "anyrpc/internal/strtod.h"
+#include "anyrpc/internal/itoa.h"
+#include "anyrpc/internal/dtoa.h"
+#include "anyrpc/internal/strscan.h"
 #include "anyrpc/xml/xmlwriter.h"
 
 #include <limits>
@@ -34,6 +36,19 @@
 namespace anyrpc
 {
 
+namespace
+{
+
+//! Copy a string literal without its null termination and return the end
+template <std::size_t N>
+inline char* AppendString(char* p, const char (&str)[N])
+{
+    memcpy(p, str, N - 1);
+    return p + N - 1;
+}
+
+} // namespace
+
 void XmlWriter::Null()
 {
     log_debug("Null");
@@ -55,53 +70,60 @@ void XmlWriter::BoolFalse()
 void XmlWriter::Int(int i)
 {
     log_debug("Int: " << i);
-    os_.Put("<value><i4>");
-    os_ << i;
-    os_.Put("</i4></value>");
+    StreamReservation<internal::IntegerStringSize + 32> out(os_);
+    char* p = AppendString(out.Begin(), "<value><i4>");
+    p = internal::I32ToString(i, p);
+    out.Commit( AppendString(p, "</i4></value>") );
 }
 
 void XmlWriter::Uint(unsigned u)
 {
     log_debug("Uint: " << u);
-    os_.Put("<value><i4>");
-    os_ << u;
-    os_.Put("</i4></value>");
+    StreamReservation<internal::IntegerStringSize + 32> out(os_);
+    char* p = AppendString(out.Begin(), "<value><i4>");
+    p = internal::U32ToString(u, p);
+    out.Commit( AppendString(p, "</i4></value>") );
 }
 
 void XmlWriter::Int64(int64_t i64)
 {
     log_debug("Int64: " << i64);
-    os_.Put("<value><i8>");
-    os_ << i64;
-    os_.Put("</i8></value>");
+    StreamReservation<internal::IntegerStringSize + 32> out(os_);
+    char* p = AppendString(out.Begin(), "<value><i8>");
+    p = internal::I64ToString(i64, p);
+    out.Commit( AppendString(p, "</i8></value>") );
 }
 
 void XmlWriter::Uint64(uint64_t u64)
 {
     log_debug("Uint64: " << u64);
-    os_.Put("<value><i8>");
-    os_ << u64;
-    os_.Put("</i8></value>");
+    StreamReservation<internal::IntegerStringSize + 32> out(os_);
+    char* p = AppendString(out.Begin(), "<value><i8>");
+    p = internal::U64ToString(u64, p);
+    out.Commit( AppendString(p, "</i8></value>") );
 }
 
 void XmlWriter::Double(double d)
 {
     log_debug("Double: " << d);
-    os_.Put("<value><double>");
-    if (precision_ > 0)
+    // format into a local buffer since the fixed format can be long
+    char buffer[internal::FixedDoubleStringSize + 40];
+    char* p = AppendString(buffer, "<value><double>");
+    if (precision_ >= 17)
+    {
+        // the shortest digits that read back as the same value never need more than 17 digits
+        p = internal::DoubleToString(d, p);
+    }
+    else if (precision_ > 0)
     {
-        char buffer[100];
-        int length = snprintf(buffer, sizeof(buffer), "%.*g", precision_, d);
-        os_.Put( buffer, length );
+        p += snprintf(p, 100, "%.*g", precision_, d);
     }
     else
     {
-        WriteStringStream ws;
-        DoubleToStream(ws, d);
-        os_.Put( ws.GetBuffer(), ws.Length() );
+        p = internal::DoubleToFixedString(d, p);
     }
-
-    os_.Put("</double></value>");
+    p = AppendString(p, "</double></value>");
+    os_.Put( buffer, p - buffer );
 }
 
 void XmlWriter::DateTime(time_t dt)
@@ -151,35 +173,38 @@ void XmlWriter::StringData(const char* str, size_t length)
 #undef Z16
     };
 
+    size_t start = 0;
     for (size_t i=0; i<length; i++)
     {
-        unsigned char c = static_cast<unsigned>(*str);
-        if (escape[c])
+        // skip to the next character that needs an escape
+        i += internal::ScanXmlString(str + i, length - i);
+        if (i == length)
+            break;
+        unsigned char c = static_cast<unsigned char>(str[i]);
+
+        // write the run of characters that don't need escaping with a single call
+        if (i > start)
+            os_.Put(str + start, i - start);
+        start = i + 1;
+
+        switch (escape[c])
         {
-            switch (escape[c])
+            case '<' : os_.Put("&lt;", 4); break;
+            case '>' : os_.Put("&gt;", 4); break;
+            case '&' : os_.Put("&amp;", 5); break;
+            case '\'': os_.Put("&apos;", 6); break;
+            case '"' : os_.Put("&quot;", 6); break;
+            case 'u' :
             {
-                case '<' : os_.Put("&lt;"); break;
-                case '>' : os_.Put("&gt;"); break;
-                case '&' : os_.Put("&amp;"); break;
-                case '\'': os_.Put("&apos;"); break;
-                case '"' : os_.Put("&quot;"); break;
-                case 'u' :
-                {
-                    os_.Put("&#x");
-                    os_.Put(hexDigits[(unsigned char)c >> 4]);
-                    os_.Put(hexDigits[(unsigned char)c & 0xF]);
-                    os_.Put(';');
-                    break;
-                }
-                case 'i' : anyrpc_throw(AnyRpcErrorNullInString, "Null value detection in string");
+                char hex[6] = { '&', '#', 'x', hexDigits[c >> 4], hexDigits[c & 0xF], ';' };
+                os_.Put(hex, 6);
+                break;
             }
+            case 'i' : anyrpc_throw(AnyRpcErrorNullInString, "Null value detection in string");
         }
-        else
-        {
-            os_.Put(c);
-        }
-        str++;
     }
+    if (length > start)
+        os_.Put(str + start, length - start);
 }
 
 void XmlWriter::Binary(const unsigned char* str, size_t length, bool copy)
@@ -274,67 +299,4 @@ void XmlWriter::EndToken(const char* pToken)
     os_.Put(pToken);
 }
 
-void XmlWriter::DoubleToStream(Stream& os, double value)
-{
-    if (value == 0.0)
-    {
-        os.Put('0');
-        return;
-    }
-    if (value < 0.0)
-    {
-        os.Put('-');
-        value = -value;
-    }
-
-    int power;
-    internal::DoubleExtractPower(value, power);
-    double precision = std::numeric_limits<double>::epsilon();
-    if (power >= 0)
-    {
-        // Generate digits before the decimal point
-        for ( ; power >= 0; power--)
-        {
-            unsigned digit = LeadDigit(value, precision);
-            os.Put('0' + digit);
-            value = (value - digit) * 10.0;
-            precision *= 10.0;
-            if (value < precision)
-            {
-                // Past the precision of the number - zeros from here
-                value = 0;
-                for ( ;power > 0; power--)
-                    os.Put('0');
-            }
-        }
-        if (value > precision)
-        {
-            os.Put('.');
-            // Output digits until precision reached
-            while (value > precision)
-            {
-                unsigned digit = LeadDigit(value, precision);
-                os.Put('0' + digit);
-                value = (value - digit) * 10.0;
-                precision *= 10.0;
-            }
-        }
-    }
-    else
-    {
-        os.Put("0.");
-        // Do the leading zeroes, which eat no precision
-        for(int i=0; i<-(power+1); i++)
-            os.Put('0');
-        // Output digits until precision reached
-        while (value > precision)
-        {
-            unsigned digit = LeadDigit(value, precision);
-            os.Put('0' + digit);
-            value = (value - digit) * 10.0;
-            precision *= 10.0;
-        }
-    }
-}
-
 }
@@ -46,6 +46,24 @@ TEST(HttpHeader,RequestSingleRead)
     EXPECT_STREQ(request.GetHost().c_str(), "192.168.1.1:5000");
     EXPECT_EQ(request.GetContentLength(), 47);
     EXPECT_TRUE(request.GetKeepAlive());
+    EXPECT_EQ(request.GetTimeout(), -1);
+}
+
+TEST(HttpHeader,RequestTimeout)
+{
+    const char* inString =  "POST /RPC2 HTTP/1.1\r\n"
+                            " Host: 192.168.1.1:5000\r\n"
+                            " Content-length: 47\r\n"
+                            " X-AnyRpc-Timeout: 2500\r\n"
+                            "\r\n";
+
+    HttpRequest request;
+    bool eof=false;
+    EXPECT_EQ(request.ProcessHeaderData(inString, strlen(inString), eof), HttpHeader::HEADER_COMPLETE);
+    EXPECT_EQ(request.GetTimeout(), 2500);
+
+    request.Initialize();
+    EXPECT_EQ(request.GetTimeout(), -1);
 }
 
 TEST(HttpHeader,RequestMultipleRead)
@@ -19,6 +19,7 @@
 // THE SOFTWARE.
 
 #include "anyrpc/anyrpc.h"
+#include "anyrpc/internal/strscan.h"
 
 #include <gtest/gtest.h>
 #include <fstream>
@@ -40,7 +41,7 @@ static string ReadWriteData(char* inString)
     return os.GetString();
 }
 
-static void WriteReadValue(Value& value, Value& outValue)
+static void WriteReadValue(Value& value, Value& outValue, bool convertTypedArrays=false)
 {
     WriteStringStream os;
     JsonWriter writer(os);
@@ -51,6 +52,7 @@ static void WriteReadValue(Value& value, Value& outValue)
     ReadStringStream is(os.GetBuffer());
     JsonReader reader(is);
     Document doc;
+    doc.ConvertTypedArrays(convertTypedArrays);
     reader >> doc;
     outValue.Assign(doc.GetValue());
 }
@@ -107,6 +109,24 @@ static string ParseData(char* filename, string& inString)
     return os.GetString();
 }
 
+static string PushParseData(const string& json, size_t pieceSize, int& errorCode)
+{
+    Document doc;
+    JsonPushParser parser(doc);
+    for (size_t pos=0; pos<json.length(); pos+=pieceSize)
+        parser.Parse(json.data() + pos, min(pieceSize, json.length() - pos));
+    parser.Finish();
+    errorCode = parser.GetParseErrorCode();
+    if (errorCode != 0)
+        return "";
+
+    WriteStringStream os;
+    JsonWriter writer(os,ASCII);
+    writer << doc.GetValue();
+
+    return os.GetString();
+}
+
 static int CheckParseError(const char* inString)
 {
     ReadStringStream is(inString);
@@ -116,6 +136,17 @@ static int CheckParseError(const char* inString)
     return reader.GetParseErrorCode();
 }
 
+static double ReadDouble(const char* inString)
+{
+    ReadStringStream is(inString);
+    JsonReader reader(is);
+    Document doc;
+    reader >> doc;
+    if (reader.HasParseError() || !doc.GetValue().IsDouble())
+        return -1;
+    return doc.GetValue().GetDouble();
+}
+
 TEST(Json,Number)
 {
     char inString[] = "5736298";
@@ -123,6 +154,55 @@ TEST(Json,Number)
     EXPECT_STREQ( outString.c_str(), inString);
 }
 
+TEST(Json,Double)
+{
+    char inString[] = "[0.1,-2.5,0.30000000000000004,1e+300,5e-324,1.7976931348623157e+308,123456.789]";
+    string outString = ReadWriteData(inString);
+    EXPECT_STREQ( outString.c_str(), inString);
+
+    // the shortest string must read back as exactly the same value
+    const double values[] = { 1.0/3.0, 2.0/3.0, 0.1 + 0.2, 1e23, 9007199254740993.0, 2.2250738585072011e-308,
+                              4.9406564584124654e-324, 8.98846567431158e307, -7.192939e-300, 12345678.9012345678 };
+    for (size_t i=0; i<sizeof(values)/sizeof(values[0]); i++)
+    {
+        Value value, outValue;
+        value.SetDouble(values[i]);
+        WriteReadValue(value, outValue);
+        EXPECT_EQ(value.GetDouble(), outValue.GetDouble());
+    }
+
+    // subnormal and normal numbers with bit patterns spread over the whole range
+    uint64_t bits = 1;
+    for (int i=0; i<2000; i++)
+    {
+        bits = bits * ANYRPC_UINT64_C2(0x5851F42D, 0x4C957F2D) + ANYRPC_UINT64_C2(0x14057B7E, 0xF767814F);
+        uint64_t valueBits = (i % 2) ? (bits >> 12) : (bits & ANYRPC_UINT64_C2(0x7FEFFFFF, 0xFFFFFFFF));
+        double d;
+        memcpy(&d, &valueBits, sizeof(d));
+        Value value, outValue;
+        value.SetDouble(d);
+        WriteReadValue(value, outValue);
+        EXPECT_EQ(value.GetDouble(), outValue.GetDouble()) << setprecision(17) << d;
+    }
+
+    // numbers that need more than the leading digits to round correctly
+    const char* strings[] = { "9.82961505958888e-309", "2.2250738585072011e-308", "123456789012345678901234567890e-10",
+                              "2.4703282292062327e-324", "2.4703282292062328e-324", "7.2057594037927933e16",
+                              "1.7976931348623158e308", "0.000000000000000000000000000000000000000000001e-300",
+                              "3.141592653589793238462643383279502884197169399375105820974944592307816406286" };
+    for (size_t i=0; i<sizeof(strings)/sizeof(strings[0]); i++)
+    {
+        EXPECT_EQ(ReadDouble(strings[i]), strtod(strings[i], 0)) << strings[i];
+    }
+
+    // halfway points between two doubles with more digits than are kept, rounded by the digits after them
+    string halfway = "9007199254740993." + string(799, '0');
+    EXPECT_EQ(ReadDouble(halfway.c_str()), 9007199254740992.0);
+    halfway += '1';
+    EXPECT_EQ(ReadDouble(halfway.c_str()), 9007199254740994.0);
+    EXPECT_EQ(CheckParseError("1.7976931348623159e308"), AnyRpcErrorNumberTooBig);
+}
+
 TEST(Json,String)
 {
     char inString[] = "\"Test string data\"";
@@ -130,6 +210,163 @@ TEST(Json,String)
     EXPECT_STREQ( outString.c_str(), inString);
 }
 
+// scanned during static initialization, possibly before the library's own statics
+static const char staticScanText[] = "a string that is longer than the vector width\\";
+static const size_t staticScanLength = internal::ScanJsonString(staticScanText, strlen(staticScanText));
+
+TEST(Json,LongString)
+{
+    EXPECT_EQ(staticScanLength, strlen(staticScanText) - 1);
+
+    // runs longer than the vector width with escapes and multibyte characters at different offsets
+    string text;
+    string expected;
+    for (int i=0; i<200; i++)
+    {
+        text += "plain text \xc3\xa9";
+        expected += "plain text \xc3\xa9";
+        if (i % 7 == 0)
+        {
+            text += "\\n\\\"";
+            expected += "\n\"";
+        }
+    }
+    string json = "[\"" + text + "\",\"" + text + "\"]";
+
+    for (int mode=0; mode<3; mode++)
+    {
+        vector<char> buffer(json.begin(), json.end());
+        InSituStringStream is(&buffer[0], buffer.size(), (mode == 0), (mode == 1));
+        JsonReader reader(is);
+        Document doc;
+        reader >> doc;
+        ASSERT_FALSE(reader.HasParseError()) << reader.GetParseErrorStr();
+        EXPECT_EQ(string(doc.GetValue()[0].GetString(), doc.GetValue()[0].GetStringLength()), expected);
+        EXPECT_EQ(string(doc.GetValue()[1].GetString(), doc.GetValue()[1].GetStringLength()), expected);
+    }
+
+    EXPECT_EQ(internal::ScanJsonString(text.c_str(), text.length()), text.find('\\'));
+    string control(40, 'a');
+    control[33] = '\x1f';
+    EXPECT_EQ(internal::ScanJsonString(control.c_str(), control.length()), (size_t)33);
+    control[33] = '\x7f';
+    EXPECT_EQ(internal::ScanJsonString(control.c_str(), control.length()), (size_t)40);
+
+    char missingQuote[] = "\"0123456789012345678901234567890123456789";
+    InSituStringStream is(missingQuote, strlen(missingQuote));
+    JsonReader reader(is);
+    Document doc;
+    reader >> doc;
+    EXPECT_EQ(reader.GetParseErrorCode(), AnyRpcErrorStringMissingQuotationMark);
+}
+
+TEST(Json,WriteLongString)
+{
+    // escapes at every offset within and across the vector width
+    string text;
+    string expectedUtf8 = "\"";
+    string expectedAscii = "\"";
+    for (int i=0; i<300; i++)
+    {
+        string run(i % 41, 'a' + i % 26);
+        text += run;
+        expectedUtf8 += run;
+        expectedAscii += run;
+        switch (i % 5)
+        {
+            case 0: text += '\"';       expectedUtf8 += "\\\"";    expectedAscii += "\\\"";    break;
+            case 1: text += '\\';      expectedUtf8 += "\\\\";   expectedAscii += "\\\\";   break;
+            case 2: text += '\n';       expectedUtf8 += "\\n";     expectedAscii += "\\n";     break;
+            case 3: text += '\x1f';     expectedUtf8 += "\\u001F"; expectedAscii += "\\u001F"; break;
+            case 4: text += "\xc3\xa9"; expectedUtf8 += "\xc3\xa9"; expectedAscii += "\\u00E9"; break;
+        }
+    }
+    expectedUtf8 += '\"';
+    expectedAscii += '\"';
+
+    WriteStringStream utf8Stream;
+    JsonWriter utf8Writer(utf8Stream);
+    utf8Writer.String(text.c_str(), text.length());
+    EXPECT_EQ(utf8Stream.GetString(), expectedUtf8);
+
+    WriteStringStream asciiStream;
+    JsonWriter asciiWriter(asciiStream, ASCII);
+    asciiWriter.String(text.c_str(), text.length());
+    EXPECT_EQ(asciiStream.GetString(), expectedAscii);
+
+    string ascii(40, 'a');
+    ascii[37] = '\x80';
+    EXPECT_EQ(internal::ScanJsonString(ascii.c_str(), ascii.length()), (size_t)40);
+    EXPECT_EQ(internal::ScanJsonStringAscii(ascii.c_str(), ascii.length()), (size_t)37);
+}
+
+TEST(Json,ContiguousInput)
+{
+    // the buffer and stream inputs must produce the same results and error offsets
+    const char* inStrings[] = { "{\"a\":[1,-2,3.5e2,true,false,null],\"b\":\"x\\ty\"}", " \v\f[18446744073709551615, -9223372036854775808] ",
+                                "[1,2,x]", "{\"a\" 1}", "[\"abc" };
+    for (size_t i=0; i<sizeof(inStrings)/sizeof(inStrings[0]); i++)
+    {
+        ReadStringStream is(inStrings[i]);
+        JsonReader reader(is);
+        Document doc;
+        reader >> doc;
+
+        vector<char> buffer(inStrings[i], inStrings[i] + strlen(inStrings[i]));
+        InSituStringStream bufferStream(&buffer[0], buffer.size());
+        JsonReader bufferReader(bufferStream);
+        Document bufferDoc;
+        bufferReader >> bufferDoc;
+
+        EXPECT_EQ(reader.GetParseErrorCode(), bufferReader.GetParseErrorCode());
+        EXPECT_EQ(reader.GetErrorOffset(), bufferReader.GetErrorOffset());
+        if (!reader.HasParseError())
+        {
+            WriteStringStream os;
+            JsonWriter writer(os);
+            writer << doc.GetValue();
+            WriteStringStream bufferOs;
+            JsonWriter bufferWriter(bufferOs);
+            bufferWriter << bufferDoc.GetValue();
+            EXPECT_STREQ(os.GetBuffer(), bufferOs.GetBuffer());
+        }
+    }
+}
+
+TEST(Json,PushParser)
+{
+    // the document split at every position gives the same result as the JsonReader
+    string json = "{\"text\" : \"esc\\\"aped \\\\ \\u00e9 \\uD83D\\uDE02 with a long run of plain characters\", "
+                  "\"numbers\":[0, -12, 4294967296, 1.5e-3, -0.25 ,true,false,null],"
+                  " \"nested\" : {\"empty\":{}, \"list\":[[], [1, [2]]]}, \"last\":\"end\"}  ";
+    vector<char> buffer(json.begin(), json.end());
+    buffer.push_back(0);
+    string expected = ReadWriteData(&buffer[0]);
+    int errorCode;
+    for (size_t pieceSize=1; pieceSize<=json.length(); pieceSize++)
+    {
+        EXPECT_EQ(PushParseData(json, pieceSize, errorCode), expected) << "pieceSize=" << pieceSize;
+        EXPECT_EQ(errorCode, 0);
+    }
+
+    // scalars at the top level are only complete at the end of the data
+    EXPECT_EQ(PushParseData("-123", 1, errorCode), "-123");
+    EXPECT_EQ(PushParseData("true", 3, errorCode), "true");
+    EXPECT_EQ(PushParseData("\"str\"", 2, errorCode), "\"str\"");
+
+    // incomplete and invalid documents report the same errors as the JsonReader
+    const char* errors[] = { "[1,2", "{\"a\" 1}", "[1 2]", "{\"a\":1,}", "\"abc", "[tru]", "{\"a\":", "[1,", "{" };
+    for (size_t i=0; i<sizeof(errors)/sizeof(errors[0]); i++)
+    {
+        string error = errors[i];
+        for (size_t pieceSize=1; pieceSize<=error.length(); pieceSize++)
+        {
+            PushParseData(error, pieceSize, errorCode);
+            EXPECT_EQ(errorCode, CheckParseError(errors[i])) << error << ", pieceSize=" << pieceSize;
+        }
+    }
+}
+
 TEST(Json,Unicode)
 {
     char inString[] = "\"\\uD83D\\uDE02\"";
@@ -147,6 +384,226 @@ TEST(Json,Array)
     EXPECT_STREQ( outString.c_str(), inString);
 }
 
+TEST(Json,TypedArray)
+{
+    char inString[] = "[0.5,1.5,2.5,3.5,4.5,5.5,6.5,7.5,8.5,9.5,10.5,11.5,12.5,13.5,14.5,15.5]";
+    string outString = ReadWriteData(inString);
+    EXPECT_STREQ( outString.c_str(), inString);
+
+    Value value;
+    value.SetTypedArray(TypedInt64, 20);
+    static_cast<int64_t*>(value.GetTypedArrayData())[19] = -(static_cast<int64_t>(1) << 40);
+    Value outValue;
+    WriteReadValue(value, outValue);
+    EXPECT_FALSE(outValue.IsTypedArray());
+    EXPECT_EQ(outValue[19].GetInt64(), -(static_cast<int64_t>(1) << 40));
+
+    // the arrays are only packed when parsing if it is enabled
+    WriteReadValue(value, outValue, true);
+    EXPECT_TRUE(outValue.IsTypedArray());
+    EXPECT_EQ(outValue.GetTypedArrayType(), TypedInt64);
+    EXPECT_EQ(outValue[19].GetInt64(), -(static_cast<int64_t>(1) << 40));
+}
+
+struct JsonPoint
+{
+    double x;
+    double y;
+    std::string label;
+};
+
+struct JsonShape
+{
+    int id;
+    bool closed;
+    std::vector<JsonPoint> points;
+    std::vector<int> tags;
+    JsonPoint center;
+};
+
+TEST(Json,StructBinding)
+{
+    StructDescriptor<JsonPoint> pointType("Point");
+    pointType.AddField("x", &JsonPoint::x).AddField("y", &JsonPoint::y).AddField("label", &JsonPoint::label);
+    StructDescriptor<JsonShape> shapeType("Shape");
+    shapeType.AddField("id", &JsonShape::id).AddField("closed", &JsonShape::closed)
+             .AddField("points", &JsonShape::points, pointType).AddField("tags", &JsonShape::tags)
+             .AddField("center", &JsonShape::center, pointType);
+
+    char inString[] = "{\"id\":7,\"extra\":{\"a\":[1,{\"b\":2}]},\"closed\":true,"
+                      "\"points\":[{\"x\":1,\"y\":2.5,\"label\":\"a\"},{\"y\":-1,\"x\":0.5}],"
+                      "\"tags\":[3,4,5],\"center\":{\"x\":1.5,\"y\":2,\"label\":\"c\"}}";
+    JsonShape shape;
+    shape.id = 0;
+    shape.closed = false;
+    ReadStringStream is(inString);
+    JsonReader reader(is);
+    StructReader structReader(shapeType, shape);
+    reader >> structReader;
+    EXPECT_FALSE(reader.HasParseError());
+    EXPECT_EQ(shape.id, 7);
+    EXPECT_TRUE(shape.closed);
+    ASSERT_EQ(shape.points.size(), (size_t)2);
+    EXPECT_DOUBLE_EQ(shape.points[0].y, 2.5);
+    EXPECT_STREQ(shape.points[0].label.c_str(), "a");
+    EXPECT_DOUBLE_EQ(shape.points[1].x, 0.5);
+    EXPECT_DOUBLE_EQ(shape.points[1].y, -1);
+    ASSERT_EQ(shape.tags.size(), (size_t)3);
+    EXPECT_EQ(shape.tags[2], 5);
+    EXPECT_STREQ(shape.center.label.c_str(), "c");
+
+    WriteStringStream os;
+    JsonWriter writer(os);
+    WriteStruct(writer, shapeType, shape);
+    EXPECT_STREQ(os.GetString().c_str(), "{\"id\":7,\"closed\":true,"
+                 "\"points\":[{\"x\":1,\"y\":2.5,\"label\":\"a\"},{\"x\":0.5,\"y\":-1,\"label\":\"\"}],"
+                 "\"tags\":[3,4,5],\"center\":{\"x\":1.5,\"y\":2,\"label\":\"c\"}}");
+
+    // type mismatch is reported as a parse error
+    char badString[] = "{\"id\":\"seven\"}";
+    ReadStringStream badStream(badString);
+    JsonReader badReader(badStream);
+    StructReader badStructReader(shapeType, shape);
+    badReader >> badStructReader;
+    EXPECT_TRUE(badReader.HasParseError());
+    EXPECT_EQ(badReader.GetParseErrorCode(), AnyRpcErrorInvalidParams);
+}
+
+static string CheckParamSchema(const ParamSchema& schema, const char* inString)
+{
+    ReadStringStream is(inString);
+    JsonReader reader(is);
+    Document doc;
+    SchemaValidator validator(schema, &doc);
+    reader >> validator;
+    if (!reader.HasParseError())
+        return "";
+    EXPECT_EQ(reader.GetParseErrorCode(), AnyRpcErrorInvalidParams);
+    return reader.GetParseErrorStr();
+}
+
+TEST(Json,ParamSchema)
+{
+    ParamSchema point(ParamSchema::MapType);
+    point.Member("x", ParamSchema(ParamSchema::NumberType))
+         .Member("y", ParamSchema(ParamSchema::NumberType))
+         .Member("label", ParamSchema(ParamSchema::StringType).Length(1, 8), false);
+    ParamSchema params(ParamSchema::ArrayType);
+    params.Element(ParamSchema(ParamSchema::IntegerType).Range(0, 100))
+          .Element(ParamSchema(ParamSchema::ArrayType).Elements(point).Length(0, 3))
+          .Elements(ParamSchema(ParamSchema::AnyType));
+
+    EXPECT_EQ(CheckParamSchema(params, "[5, [{\"x\":1,\"y\":2.5}, {\"label\":\"a\",\"y\":0,\"x\":-1}]]"), "");
+    EXPECT_EQ(CheckParamSchema(params, "[5, [], {\"any\":[1,\"two\"]}, null]"), "");
+    EXPECT_EQ(CheckParamSchema(params, "[5.5, []]"), "Invalid parameter params[0], expected integer, found number");
+    EXPECT_EQ(CheckParamSchema(params, "[101, []]"), "Invalid parameter params[0], out of range");
+    EXPECT_EQ(CheckParamSchema(params, "[5]"), "Invalid parameter params, too few elements");
+    EXPECT_EQ(CheckParamSchema(params, "{\"a\":5}"), "Invalid parameter params, expected array, found map");
+    EXPECT_EQ(CheckParamSchema(params, "[5, [{\"x\":1}]]"), "Invalid parameter params[1][0], missing member y");
+    EXPECT_EQ(CheckParamSchema(params, "[5, [{\"x\":1,\"y\":\"2\"}]]"), "Invalid parameter params[1][0].y, expected number, found string");
+    EXPECT_EQ(CheckParamSchema(params, "[5, [{\"x\":1,\"y\":2,\"z\":3}]]"), "Invalid parameter params[1][0], unexpected member z");
+    EXPECT_EQ(CheckParamSchema(params, "[5, [{\"x\":1,\"y\":2,\"label\":\"too long label\"}]]"),
+              "Invalid parameter params[1][0].label, length out of range");
+    EXPECT_EQ(CheckParamSchema(params, "[5, [{\"x\":1,\"y\":2},{\"x\":1,\"y\":2},{\"x\":1,\"y\":2},{\"x\":1,\"y\":2}]]"),
+              "Invalid parameter params[1][3], too many elements");
+
+    // the values are checked while they are added to the document
+    char inString[] = "[7, [{\"x\":1,\"y\":2}], \"extra\"]";
+    Document doc;
+    SchemaValidator validator(params, &doc);
+    ReadStringStream is(inString);
+    JsonReader reader(is);
+    reader >> validator;
+    EXPECT_FALSE(reader.HasParseError());
+    EXPECT_TRUE(validator.IsComplete());
+    ASSERT_TRUE(doc.GetValue().IsArray());
+    EXPECT_EQ(doc.GetValue()[0].GetInt(), 7);
+    EXPECT_STREQ(doc.GetValue()[2].GetString(), "extra");
+
+    // the same schema checks a Value
+    SchemaValidator valueValidator(params);
+    Value value;
+    value.SetArray();
+    value[0] = 200;
+    value[1].SetArray();
+    try
+    {
+        value.Traverse(valueValidator);
+        FAIL() << "Expected invalid params";
+    }
+    catch (const AnyRpcException& fault)
+    {
+        EXPECT_EQ(fault.GetCode(), AnyRpcErrorInvalidParams);
+    }
+}
+
+TEST(Json,LazyValue)
+{
+    char inString[] = " {\"method\":\"forward\", \"params\":[1, {\"k\\\"ey\":\"a]}\\\"\", \"n\":null}, [2.5, true]], \"id\":7}";
+    JsonLazyValue message(inString, strlen(inString));
+    ASSERT_TRUE(message.IsMap());
+    EXPECT_EQ(message.Size(), 3);
+    EXPECT_TRUE(message.Get("missing") == 0);
+
+    JsonLazyValue* params = message.Get("params");
+    ASSERT_TRUE(params != 0);
+    ASSERT_TRUE(params->IsArray());
+    EXPECT_EQ(params->Size(), 3);
+    EXPECT_FALSE(params->IsParsed());
+
+    // the text of a part is available until it is parsed
+    size_t length;
+    const char* text = (*params)[2].GetText(length);
+    ASSERT_TRUE(text != 0);
+    EXPECT_EQ(string(text, length), "[2.5, true]");
+
+    JsonLazyValue& element = (*params)[1];
+    ASSERT_TRUE(element.IsMap());
+    JsonLazyValue* escaped = element.Get("k\"ey");
+    ASSERT_TRUE(escaped != 0);
+    EXPECT_STREQ(escaped->GetValue().GetString(), "a]}\"");
+    EXPECT_TRUE(element.Get("n")->GetValue().IsNull());
+    EXPECT_TRUE(params->GetText(length) == 0);
+    EXPECT_EQ(message.Get("id")->GetValue().GetInt(), 7);
+
+    // the parsed parts are kept when the containing value is created
+    Value& value = params->GetValue();
+    ASSERT_TRUE(value.IsArray());
+    EXPECT_EQ(value.Size(), 3);
+    EXPECT_EQ(value[0].GetInt(), 1);
+    EXPECT_STREQ(value[1]["k\"ey"].GetString(), "a]}\"");
+    EXPECT_DOUBLE_EQ(value[2][0].GetDouble(), 2.5);
+    EXPECT_TRUE(escaped->GetValue().IsString());
+    EXPECT_EQ(&(*params)[2].GetValue(), &value[2]);
+
+    // errors are found in the parts that are accessed
+    char badString[] = "{\"a\":[1,2], \"b\" 3}";
+    JsonLazyValue bad(badString, strlen(badString));
+    try
+    {
+        bad.Get("b");
+        FAIL() << "Expected parse error";
+    }
+    catch (const AnyRpcException& error)
+    {
+        EXPECT_EQ(error.GetCode(), AnyRpcErrorObjectMissColon);
+    }
+    char truncatedString[] = "{\"a\":\"abc";
+    JsonLazyValue truncated(truncatedString, strlen(truncatedString));
+    EXPECT_THROW(truncated.Get("a"), AnyRpcException);
+    char unfinishedString[] = "[1, 2";
+    JsonLazyValue unfinished(unfinishedString, strlen(unfinishedString));
+    EXPECT_THROW(unfinished.Size(), AnyRpcException);
+
+    // an already parsed value has the same interface
+    Value parsed;
+    parsed["x"] = 3;
+    JsonLazyValue lazyParsed(parsed);
+    ASSERT_TRUE(lazyParsed.IsParsed());
+    ASSERT_TRUE(lazyParsed.Get("x") != 0);
+    EXPECT_EQ(lazyParsed.Get("x")->GetValue().GetInt(), 3);
+}
+
 TEST(Json,Map)
 {
     char inString[] = "{\"item1\":57,\"item2\":89,\"item3\":3.45}";
@@ -26,7 +26,7 @@
 using namespace std;
 using namespace anyrpc;
 
-static void WriteReadValue(Value& value, Value& outValue)
+static void WriteReadValue(Value& value, Value& outValue, bool convertTypedArrays=false)
 {
     // Use file streams since binary data may contain embedded NULLs
     WriteFileStream os("test.bin");
@@ -37,6 +37,7 @@ static void WriteReadValue(Value& value, Value& outValue)
     ReadFileStream is("test.bin");
     MessagePackReader reader(is);
     Document doc;
+    doc.ConvertTypedArrays(convertTypedArrays);
     reader >> doc;
     outValue.Assign(doc.GetValue());
     EXPECT_FALSE(reader.HasParseError());
@@ -125,6 +126,72 @@ TEST(MessagePack,Array)
     EXPECT_DOUBLE_EQ(outValue[2].GetDouble(), value[2].GetDouble());
 }
 
+TEST(MessagePack,TypedArray)
+{
+    Value value;
+    for (int i=0; i<100; i++)
+        value[i] = i * 1.25;
+    ASSERT_TRUE(value.PackTypedArray());
+    Value outValue;
+    WriteReadValue(value, outValue);
+    EXPECT_FALSE(outValue.IsTypedArray());
+    EXPECT_DOUBLE_EQ(outValue[99].GetDouble(), 99 * 1.25);
+
+    // the arrays are only packed when parsing if it is enabled
+    WriteReadValue(value, outValue, true);
+    EXPECT_TRUE(outValue.IsTypedArray());
+    EXPECT_EQ(outValue.GetTypedArrayType(), TypedDouble);
+    EXPECT_EQ(outValue.Size(), (size_t)100);
+    EXPECT_DOUBLE_EQ(outValue[99].GetDouble(), 99 * 1.25);
+
+    value.SetTypedArray(TypedInt32, 50);
+    static_cast<int32_t*>(value.GetTypedArrayData())[10] = -70000;
+    WriteReadValue(value, outValue, true);
+    EXPECT_EQ(outValue.GetTypedArrayType(), TypedInt32);
+    EXPECT_EQ(outValue[10].GetInt(), -70000);
+    EXPECT_EQ(outValue[11].GetInt(), 0);
+}
+
+struct MsgPackSample
+{
+    int64_t time;
+    unsigned count;
+    std::string name;
+    std::vector<double> samples;
+};
+
+TEST(MessagePack,StructBinding)
+{
+    StructDescriptor<MsgPackSample> sampleType("Sample");
+    sampleType.AddField("time", &MsgPackSample::time).AddField("count", &MsgPackSample::count)
+              .AddField("name", &MsgPackSample::name).AddField("samples", &MsgPackSample::samples);
+
+    MsgPackSample sample;
+    sample.time = static_cast<int64_t>(1) << 40;
+    sample.count = 3;
+    sample.name = "sensor";
+    sample.samples.push_back(1.5);
+    sample.samples.push_back(-2.25);
+    sample.samples.push_back(1e10);
+
+    WriteStringStream os;
+    MessagePackWriter writer(os);
+    WriteStruct(writer, sampleType, sample);
+
+    InSituStringStream is((char*)os.GetBuffer(), os.Length());
+    MessagePackReader reader(is);
+    MsgPackSample outSample;
+    StructReader structReader(sampleType, outSample);
+    reader >> structReader;
+    EXPECT_FALSE(reader.HasParseError());
+    EXPECT_EQ(outSample.time, sample.time);
+    EXPECT_EQ(outSample.count, sample.count);
+    EXPECT_STREQ(outSample.name.c_str(), "sensor");
+    ASSERT_EQ(outSample.samples.size(), (size_t)3);
+    EXPECT_DOUBLE_EQ(outSample.samples[1], -2.25);
+    EXPECT_DOUBLE_EQ(outSample.samples[2], 1e10);
+}
+
 TEST(MessagePack,Map)
 {
     Value value;
@@ -1,4 +1,5 @@
 #include "anyrpc/anyrpc.h"
+#include "anyrpc/internal/time.h"
 
 #include <gtest/gtest.h>
 
@@ -79,3 +80,291 @@ TEST(MethodMap,General)
     methodManager.ExecuteMethod(METHOD_HELP,params,result);
     EXPECT_STREQ(result.GetString(),"Add two numbers");
 }
+
+TEST(MethodMap,Deadline)
+{
+    MethodManager methodManager;
+    methodManager.AddFunction( &Add, "add", "Add two numbers");
+
+    Value params;
+    Value result;
+    params.SetArray(2);
+    params[0] = 5;
+    params[1] = 3;
+
+    struct timeval deadline;
+    gettimeofday( &deadline, 0 );
+    deadline.tv_sec -= 1;
+    MethodManager::SetDeadline(deadline);
+    EXPECT_TRUE(MethodManager::DeadlineExpired());
+    try
+    {
+        methodManager.ExecuteMethod("add",params,result);
+        FAIL() << "Expected deadline exceeded";
+    }
+    catch (const AnyRpcException& fault)
+    {
+        EXPECT_EQ(fault.GetCode(), AnyRpcErrorDeadlineExceeded);
+    }
+
+    MethodManager::ClearDeadline();
+    EXPECT_FALSE(MethodManager::DeadlineExpired());
+    methodManager.ExecuteMethod("add",params,result);
+    EXPECT_DOUBLE_EQ(result.GetDouble(), 8);
+
+    // the scope removes the deadline when the execution throws
+    try
+    {
+        DeadlineScope deadlineScope(deadline);
+        methodManager.ExecuteMethod("add",params,result);
+        FAIL() << "Expected deadline exceeded";
+    }
+    catch (const AnyRpcException& fault)
+    {
+        EXPECT_EQ(fault.GetCode(), AnyRpcErrorDeadlineExceeded);
+    }
+    EXPECT_FALSE(MethodManager::DeadlineExpired());
+}
+
+static Value keptValue;
+
+void Keep(Value& params, Value& result)
+{
+    keptValue["name"].SetString("a value kept by the method");
+    keptValue["params"].Copy(params);
+    result = true;
+}
+
+TEST(MethodMap,Arena)
+{
+    MethodManager methodManager;
+    methodManager.AddFunction( &Keep, "keep", "Keep the params");
+
+    MemoryArena arena(256);
+    {
+        ArenaScope arenaScope(&arena);
+        Value params;
+        Value result;
+        params.SetArray();
+        params[0].SetString("a param copied by the method");
+        size_t paramsUsed = arena.GetUsed();
+        EXPECT_GT(paramsUsed, 0u);
+
+        // the method is executed with the heap so only the params are in the arena
+        methodManager.ExecuteMethod("keep",params,result);
+        EXPECT_EQ(arena.GetUsed(), paramsUsed);
+        EXPECT_TRUE(result.GetBool());
+    }
+
+    // reuse the space in the arena after the request
+    arena.Reset();
+    {
+        ArenaScope arenaScope(&arena);
+        Value other;
+        other.SetString("other data in the space that is reused after the reset");
+    }
+    EXPECT_STREQ(keptValue["name"].GetString(), "a value kept by the method");
+    EXPECT_STREQ(keptValue["params"][0].GetString(), "a param copied by the method");
+    keptValue.SetNull();
+}
+
+TEST(MethodMap,ParamSchema)
+{
+    MethodManager methodManager;
+    methodManager.AddFunction( &Add, "add", "Add two numbers");
+    EXPECT_FALSE(methodManager.HasParamSchemas());
+    EXPECT_THROW(methodManager.SetParamSchema("divide", ParamSchema()), AnyRpcException);
+
+    ParamSchema number(ParamSchema::NumberType);
+    number.Range(-1000, 1000);
+    ParamSchema schema(ParamSchema::ArrayType);
+    schema.Element(number).Element(number);
+    methodManager.SetParamSchema("add", schema);
+    EXPECT_TRUE(methodManager.HasParamSchemas());
+    EXPECT_TRUE(methodManager.FindParamSchema("add") != 0);
+    EXPECT_TRUE(methodManager.FindParamSchema("subtract") == 0);
+
+    Value params;
+    Value result;
+    params.SetArray(2);
+    params[0] = 5;
+    params[1] = 3.5;
+    methodManager.ExecuteMethod("add",params,result);
+    EXPECT_DOUBLE_EQ(result.GetDouble(), 8.5);
+
+    params[1] = 2000;
+    try
+    {
+        methodManager.ExecuteMethod("add",params,result);
+        FAIL() << "Expected invalid params";
+    }
+    catch (const AnyRpcException& fault)
+    {
+        EXPECT_EQ(fault.GetCode(), AnyRpcErrorInvalidParams);
+        EXPECT_STREQ(fault.GetMessage().c_str(), "Invalid parameter params[1], out of range");
+    }
+
+    // params that were checked while they were parsed aren't checked again
+    EXPECT_TRUE(methodManager.ExecuteMethod("add",params,result,true));
+    EXPECT_DOUBLE_EQ(result.GetDouble(), 2005);
+}
+
+#if defined(ANYRPC_INCLUDE_JSON)
+static string JsonHandlerResponse(MethodManager& methodManager, const char* request)
+{
+    string buffer(request);
+    WriteStringStream response;
+    JsonRpcHandler(&methodManager, &buffer[0], buffer.length(), response);
+    return response.GetString();
+}
+
+TEST(MethodMap,ParamSchemaRepeatedEnvelope)
+{
+    MethodManager methodManager;
+    methodManager.AddFunction( &Add, "add", "Add two numbers");
+    methodManager.AddFunction( &Subtract, "subtract", "Subtract two numbers");
+    ParamSchema numbers(ParamSchema::ArrayType);
+    numbers.Element(ParamSchema(ParamSchema::NumberType)).Element(ParamSchema(ParamSchema::NumberType));
+    ParamSchema strings(ParamSchema::ArrayType);
+    strings.Elements(ParamSchema(ParamSchema::StringType));
+    methodManager.SetParamSchema("add", numbers);
+    methodManager.SetParamSchema("subtract", strings);
+
+    EXPECT_EQ(JsonHandlerResponse(methodManager, "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"add\",\"params\":[5,3]}"),
+              "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":8}");
+
+    // the first params are executed so they must be checked even though the second ones match
+    string response = JsonHandlerResponse(methodManager,
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"params\":[\"x\",\"y\"],\"method\":\"add\",\"params\":[5,3]}");
+    EXPECT_NE(response.find("-32602"), string::npos) << response;
+
+    // the first method is executed so its schema must be used
+    response = JsonHandlerResponse(methodManager,
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"subtract\",\"method\":\"add\",\"params\":[5,3]}");
+    EXPECT_NE(response.find("-32602"), string::npos) << response;
+}
+
+//! Lazy method that isn't a JsonLazyMethod
+class LazySizeMethod : public Method
+{
+public:
+    LazySizeMethod() : Method("size", "Number of params") {}
+    virtual bool LazyParams() const { return true; }
+    virtual void ExecuteLazy(JsonLazyValue& params, Value& result) { result = static_cast<int>(params.Size()); }
+};
+
+TEST(MethodMap,LazyMethod)
+{
+    MethodManager methodManager;
+    methodManager.AddFunction( &Add, "add", "Add two numbers");
+    methodManager.AddMethod(new LazySizeMethod());
+    ParamSchema numbers(ParamSchema::ArrayType);
+    numbers.Elements(ParamSchema(ParamSchema::NumberType));
+    methodManager.SetParamSchema("size", numbers);
+
+    EXPECT_EQ(JsonHandlerResponse(methodManager, "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"size\",\"params\":[5,3,1]}"),
+              "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":3}");
+    EXPECT_EQ(JsonHandlerResponse(methodManager, "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"add\",\"params\":[5,3]}"),
+              "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":8}");
+    string response = JsonHandlerResponse(methodManager, "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"size\",\"params\":[5,\"x\"]}");
+    EXPECT_NE(response.find("-32602"), string::npos) << response;
+
+    // the deadline is checked the same as for other methods
+    Value params;
+    Value result;
+    params.SetArray(2);
+    params[0] = 5;
+    params[1] = 3;
+    JsonLazyValue lazyParams(params);
+    struct timeval deadline;
+    gettimeofday( &deadline, 0 );
+    deadline.tv_sec -= 1;
+    {
+        DeadlineScope deadlineScope(deadline);
+        EXPECT_THROW(methodManager.ExecuteLazyMethod("size", lazyParams, result), AnyRpcException);
+    }
+    EXPECT_TRUE(methodManager.ExecuteLazyMethod("size", lazyParams, result));
+    EXPECT_EQ(result.GetInt(), 2);
+    EXPECT_FALSE(methodManager.ExecuteLazyMethod("unknown", lazyParams, result));
+}
+#endif // defined(ANYRPC_INCLUDE_JSON)
+
+#if ANYRPC_HAS_VARIADIC_TEMPLATES
+static int Scale(double factor, const std::string& text)
+{
+    return static_cast<int>(factor * text.size());
+}
+
+static std::string Repeat(const std::string& text, unsigned count)
+{
+    std::string repeated;
+    for (unsigned i=0; i<count; i++)
+        repeated += text;
+    return repeated;
+}
+
+static double Sum(const std::vector<double>& values)
+{
+    double sum = 0;
+    for (std::size_t i=0; i<values.size(); i++)
+        sum += values[i];
+    return sum;
+}
+
+TEST(MethodMap,Typed)
+{
+    MethodManager methodManager;
+    methodManager.AddFunction<int(double, const std::string&)>( &Scale, "scale", "Scale the text length");
+    methodManager.AddFunction( &Repeat, "repeat", "Repeat the text");
+    methodManager.AddFunction( &Sum, "sum", "Sum the values");
+
+    Value params;
+    Value result;
+    params.SetArray(2);
+    params[0] = 2.5;
+    params[1] = "abcd";
+    methodManager.ExecuteMethod("scale",params,result);
+    EXPECT_EQ(result.GetInt(), 10);
+
+    params[0] = "ab";
+    params[1] = 3;
+    methodManager.ExecuteMethod("repeat",params,result);
+    EXPECT_STREQ(result.GetString(), "ababab");
+
+    params.SetArray(1);
+    params[0].SetArray(3);
+    params[0][0] = 1;
+    params[0][1] = 2.5;
+    params[0][2] = 3;
+    methodManager.ExecuteMethod("sum",params,result);
+    EXPECT_DOUBLE_EQ(result.GetDouble(), 6.5);
+
+    // wrong parameter type
+    params.SetArray(2);
+    params[0] = 2.5;
+    params[1] = 7;
+    try
+    {
+        methodManager.ExecuteMethod("scale",params,result);
+        FAIL() << "Expected invalid params";
+    }
+    catch (const AnyRpcException& fault)
+    {
+        EXPECT_EQ(fault.GetCode(), AnyRpcErrorInvalidParams);
+        EXPECT_NE(std::string(fault.GetMessage()).find("expected string"), std::string::npos);
+    }
+
+    // wrong number of parameters
+    params.SetArray(1);
+    params[0] = 2.5;
+    try
+    {
+        methodManager.ExecuteMethod("scale",params,result);
+        FAIL() << "Expected invalid params";
+    }
+    catch (const AnyRpcException& fault)
+    {
+        EXPECT_EQ(fault.GetCode(), AnyRpcErrorInvalidParams);
+    }
+}
+#endif // ANYRPC_HAS_VARIADIC_TEMPLATES
@@ -61,6 +61,14 @@ static void Echo(Value& params, Value& result)
     result = params;
 }
 
+static Value sharedConfig;
+
+static void Config(Value& /* params */, Value& result)
+{
+    // only adds a reference to the shared data
+    result = sharedConfig;
+}
+
 static void ServerSetup(Server& server)
 {
     server.BindAndListen(ServerPort);
@@ -70,6 +78,7 @@ static void ServerSetup(Server& server)
     methodManager->AddFunction( &Add, "add", "Add two numbers");
     methodManager->AddFunction( &Subtract, "subtract", "Subtract two numbers");
     methodManager->AddFunction( &Echo, "echo", "Return the same data that was sent");
+    methodManager->AddFunction( &Config, "config", "Return the shared configuration");
 }
 
 static void TestClient(Client &client)
@@ -128,7 +137,154 @@ static void TestClient(Client &client)
 			ASSERT_STREQ(result[i].GetString(), abcString.c_str());
 		}
     }
+
+    // The results keep referencing the response data after more calls when the buffer owns it
+    {
+        ResponseBuffer largeBuffer;
+        Value largeResult;
+        params.SetSize(numValues);
+        for (int i=0; i<numValues; i++)
+            params[i] = abcString;
+        success = client.Call("echo", params, largeResult, largeBuffer);
+        EXPECT_TRUE(success);
+        EXPECT_FALSE(largeBuffer.IsEmpty());
+
+        ResponseBuffer smallBuffer;
+        Value smallResult;
+        params.SetArray();
+        params[0] = abcString;
+        success = client.Call("echo", params, smallResult, smallBuffer);
+        EXPECT_TRUE(success);
+        EXPECT_FALSE(smallBuffer.IsEmpty());
+
+        success = client.Call("echo", params, result);
+        EXPECT_TRUE(success);
+        ASSERT_TRUE(largeResult.IsArray());
+        ASSERT_EQ(largeResult.Size(), (size_t)numValues);
+        for (int i=0; i<numValues; i++)
+            ASSERT_STREQ(largeResult[i].GetString(), abcString.c_str());
+        ASSERT_TRUE(smallResult.IsArray());
+        EXPECT_STREQ(smallResult[0].GetString(), abcString.c_str());
+    }
+
+    // Send several calls in a single batch including one that fails
+    Batch batch;
+    params.SetArray();
+    params[0] = 5;
+    params[1] = 6;
+    batch.Add("add", params);
+    batch.Add("divide", params);
+    batch.Add("subtract", params);
+    params.SetArray();
+    params[0] = abcString;
+    batch.Add("echo", params);
+    success = client.BatchCall(batch);
+    EXPECT_FALSE(success);
+    ASSERT_EQ(batch.GetSize(), 4u);
+    EXPECT_TRUE(batch.GetSuccess(0));
+    EXPECT_DOUBLE_EQ(batch.GetResult(0).GetDouble(), 11);
+    EXPECT_FALSE(batch.GetSuccess(1));
+    EXPECT_TRUE(batch.GetResult(1).HasMember("code"));
+    EXPECT_TRUE(batch.GetSuccess(2));
+    EXPECT_DOUBLE_EQ(batch.GetResult(2).GetDouble(), -1);
+    EXPECT_TRUE(batch.GetSuccess(3));
+
+    // The params are still available after the batch
+    ASSERT_TRUE(batch.GetParams(0).IsArray());
+    ASSERT_EQ(batch.GetParams(0).Size(), 2u);
+    EXPECT_EQ(batch.GetParams(0)[1].GetInt(), 6);
+    ASSERT_TRUE(batch.GetParams(3).IsArray());
+    EXPECT_STREQ(batch.GetParams(3)[0].GetString(), abcString.c_str());
+
+    // The connection is still usable after the batch and the results don't use the receive buffer
+    params.SetArray();
+    for (int i=0; i<20; i++)
+        params[i] = string(60, 'z');
+    success = client.Call("echo", params, result);
+    EXPECT_TRUE(success);
+    ASSERT_TRUE(batch.GetResult(3).IsArray());
+    EXPECT_STREQ(batch.GetResult(3)[0].GetString(), abcString.c_str());
+}
+
+static void ParamSchemaSetup(Server& server)
+{
+    ServerSetup(server);
+
+    // echo only accepts an array of short strings
+    ParamSchema echo(ParamSchema::ArrayType);
+    echo.Elements(ParamSchema(ParamSchema::StringType).Length(0, 64));
+    server.GetMethodManager()->SetParamSchema("echo", echo);
+}
+
+static void TestParamSchemaClient(Client &client)
+{
+    TestClient(client);
+
+    Value params;
+    Value result;
+    params.SetArray();
+    params[0] = abcString;
+    params[1] = 5;
+    EXPECT_FALSE(client.Call("echo", params, result));
+    ASSERT_TRUE(result.IsMap());
+    EXPECT_EQ(result["code"].GetInt(), AnyRpcErrorInvalidParams);
+    EXPECT_STREQ(result["message"].GetString(), "Invalid parameter params[1], expected string, found integer");
+
+    // the connection is still usable after the rejected call
+    params.SetArray();
+    params[0] = abcString;
+    EXPECT_TRUE(client.Call("echo", params, result));
+}
+
+#if defined(ANYRPC_INCLUDE_JSON)
+// Return the first element and the length of the text of the rest without parsing it
+static void LazyFirst(JsonLazyValue& params, Value& result)
+{
+    if (!params.IsArray() || (params.Size() < 2))
+        throw AnyRpcException(AnyRpcErrorInvalidParams, "Invalid parameters");
+    size_t length;
+    const char* text = params[1].GetText(length);
+    result.SetMap();
+    result["first"] = params[0].GetValue();
+    result["restLength"] = (text != 0) ? static_cast<int>(length) : -1;
+}
+
+static void LazySetup(Server& server)
+{
+    ServerSetup(server);
+
+    MethodManager *methodManager = server.GetMethodManager();
+    methodManager->AddMethod(new JsonLazyMethod(&LazyFirst, "first", "Return the first element"));
+    ParamSchema first(ParamSchema::ArrayType);
+    first.Element(ParamSchema(ParamSchema::StringType)).Elements(ParamSchema(ParamSchema::AnyType));
+    methodManager->SetParamSchema("first", first);
+}
+
+static void TestLazyClient(Client &client)
+{
+    // the other methods are still parsed completely
+    TestClient(client);
+
+    Value params;
+    Value result;
+    params.SetArray();
+    params[0] = abcString;
+    params[1].SetArray();
+    params[1][0] = 1;
+    params[1][1] = 2;
+    EXPECT_TRUE(client.Call("first", params, result));
+    ASSERT_TRUE(result.IsMap());
+    EXPECT_STREQ(result["first"].GetString(), abcString.c_str());
+    EXPECT_EQ(result["restLength"].GetInt(), 5);
+
+    params.SetArray();
+    params[0] = 5;
+    params[1] = 6;
+    EXPECT_FALSE(client.Call("first", params, result));
+    ASSERT_TRUE(result.IsMap());
+    EXPECT_EQ(result["code"].GetInt(), AnyRpcErrorInvalidParams);
 }
+#endif // defined(ANYRPC_INCLUDE_JSON)
 
 #if defined(ANYRPC_INCLUDE_JSON)
 TEST(Server, JsonHttp)
@@ -195,6 +351,63 @@ TEST(Server, JsonHttpMTMultiple)
     server.StopThread();
 }
 
+TEST(Server, JsonHttpArena)
+{
+    log_time(WARN, "JsonHttpArena");
+    JsonHttpServer server;
+    JsonHttpClient client;
+
+    server.SetArenaBlockSize(256);
+    ServerSetup(server);
+    server.StartThread();
+    TestClient(client);
+    server.StopThread();
+}
+
+static void TestSharedClient(Client* client, int* successes)
+{
+    Value params;
+    Value result;
+    client->SetServer(ServerIpAddress, ServerPort);
+    client->SetTimeout(2000);
+    for (int i=0; i<20; i++)
+    {
+        params.SetArray();
+        if (client->Call("config", params, result) &&
+            result.IsMap() && result["values"].IsArray() && (result["values"].Size() == 100))
+            (*successes)++;
+    }
+}
+
+TEST(Server, JsonHttpTPShared)
+{
+    log_time(WARN, "JsonHttpTPShared");
+    Value config;
+    for (int i=0; i<100; i++)
+        config["values"][i] = i * 0.5;
+    config["name"] = abcString;
+    sharedConfig.SetShared(new SharedValue(config));
+
+    JsonHttpServerTP server;
+    ServerSetup(server);
+    server.StartThread();
+    MilliSleep(50);
+
+    // several worker threads return the same shared data at once
+    JsonHttpClient client[4];
+    int successes[4] = { 0, 0, 0, 0 };
+    std::vector<std::thread> threads;
+    for (int i=0; i<4; i++)
+        threads.push_back(std::thread(TestSharedClient, &client[i], &successes[i]));
+    for (int i=0; i<4; i++)
+    {
+        threads[i].join();
+        EXPECT_EQ(successes[i], 20);
+    }
+    server.StopThread();
+    sharedConfig.SetNull();
+}
+
 TEST(Server, JsonTcpMT)
 {
 	log_time(WARN, "JsonTcpMT");
@@ -206,6 +419,265 @@ TEST(Server, JsonTcpMT)
     TestClient(client);
     server.StopThread();
 }
+
+//! Balanced client that can check the number of calls in progress
+static bool clientThrows = false;
+
+//! Client that throws from the call to the server when clientThrows is set
+class ThrowingJsonHttpClient : public JsonHttpClient
+{
+public:
+    ThrowingJsonHttpClient() {}
+    ThrowingJsonHttpClient(const char* host, int port) : JsonHttpClient(host, port) {}
+
+protected:
+    virtual bool CallServer(const char* method, Value& params, Value& result)
+    {
+        if (clientThrows)
+            anyrpc_throw(AnyRpcErrorTransportError, "Client failure for method " << method);
+        return JsonHttpClient::CallServer(method, params, result);
+    }
+};
+
+class CountingBalancedClient : public JsonHttpBalancedClient
+{
+public:
+    virtual Client* CreateClient(const char* host, int port) { return new ThrowingJsonHttpClient(host, port); }
+    unsigned GetOutstanding() const
+    {
+        unsigned outstanding = 0;
+        for (std::size_t i=0; i<endpoints_.size(); i++)
+            outstanding += endpoints_[i].outstanding_;
+        return outstanding;
+    }
+};
+
+TEST(Server, JsonHttpBalanced)
+{
+    log_time(WARN, "JsonHttpBalanced");
+    JsonHttpServer server;
+    CountingBalancedClient client;
+
+    ServerSetup(server);
+    server.StartThread();
+    MilliSleep(50);
+
+    // The second endpoint doesn't have a server so it should be ejected after two failures
+    client.AddEndpoint(ServerIpAddress, ServerPort);
+    client.AddEndpoint(ServerIpAddress, ServerPort+1);
+    client.SetTimeout(2000);
+    client.SetEjection(2, 60000);
+
+    Value params;
+    Value result;
+    params.SetArray();
+    params[0] = 5;
+    params[1] = 6;
+
+    int failures = 0;
+    for (int i=0; i<10; i++)
+    {
+        if (!client.Call("add", params, result))
+            failures++;
+    }
+    EXPECT_EQ(failures, 2);
+
+    // Only the working endpoint should be used for the rest of the calls
+    client.SetPolicy(BalanceLeastOutstanding);
+    EXPECT_TRUE(client.Call("add", params, result));
+    client.SetPolicy(BalancePowerOfTwoChoices);
+    EXPECT_TRUE(client.Call("add", params, result));
+
+    // a call that throws is no longer outstanding
+    clientThrows = true;
+    EXPECT_THROW(client.Call("add", params, result), AnyRpcException);
+    clientThrows = false;
+    EXPECT_EQ(client.GetOutstanding(), 0u);
+    EXPECT_TRUE(client.Call("add", params, result));
+    server.StopThread();
+}
+
+TEST(Server, JsonHttpCache)
+{
+    log_time(WARN, "JsonHttpCache");
+    JsonHttpServer server;
+    ThrowingJsonHttpClient client;
+    ResponseCache cache(2);
+
+    ServerSetup(server);
+    server.StartThread();
+    MilliSleep(50);
+    client.SetServer(ServerIpAddress, ServerPort);
+    client.SetTimeout(2000);
+    client.SetCache(&cache);
+    cache.AddMethod("add", 60000);
+
+    Value params;
+    Value result;
+    params.SetArray();
+    params[0] = 5;
+    params[1] = 6;
+    EXPECT_TRUE(client.Call("add", params, result));
+    EXPECT_TRUE(client.Call("subtract", params, result));
+    EXPECT_EQ(cache.GetSize(), 1u);
+
+    // a call that throws doesn't leave its entry pending for the next identical call
+    Value otherParams;
+    otherParams.SetArray();
+    otherParams[0] = 5;
+    otherParams[1] = 7;
+    clientThrows = true;
+    for (int i=0; i<2; i++)
+        EXPECT_THROW(client.Call("add", otherParams, result), AnyRpcException);
+    clientThrows = false;
+    EXPECT_EQ(cache.GetSize(), 1u);
+    EXPECT_TRUE(client.Call("add", params, result));
+    server.StopThread();
+    client.Close();
+
+    // The cached method doesn't need the server but the others do
+    EXPECT_TRUE(client.Call("add", params, result));
+    EXPECT_DOUBLE_EQ(result.GetDouble(), 11);
+    EXPECT_FALSE(client.Call("subtract", params, result));
+    params[1] = 7;
+    EXPECT_FALSE(client.Call("add", params, result));
+    EXPECT_EQ(cache.GetSize(), 1u);
+
+    cache.RemoveMethod("add");
+    EXPECT_EQ(cache.GetSize(), 0u);
+}
+
+TEST(Server, CacheCanonicalParams)
+{
+    ResponseCache cache(2);
+    cache.AddMethod("lookup", 60000);
+
+    Value params;
+    Value result;
+    std::string cacheKey;
+    params["b"] = 2;
+    params["a"] = "one";
+    EXPECT_FALSE(cache.Lookup(ServerIpAddress, ServerPort, "lookup", params, result, cacheKey));
+    EXPECT_FALSE(cacheKey.empty());
+    result = "found";
+    cache.Complete(cacheKey, result, true);
+
+    // The member order doesn't matter
+    Value sameParams;
+    sameParams["a"] = "one";
+    sameParams["b"] = 2;
+    result.SetNull();
+    EXPECT_TRUE(cache.Lookup(ServerIpAddress, ServerPort, "lookup", sameParams, result, cacheKey));
+    EXPECT_STREQ(result.GetString(), "found");
+
+    // Different endpoint or methods that aren't cached are not found
+    EXPECT_FALSE(cache.Lookup(ServerIpAddress, ServerPort+1, "lookup", sameParams, result, cacheKey));
+    cache.Complete(cacheKey, result, false);
+    EXPECT_FALSE(cache.Lookup(ServerIpAddress, ServerPort, "other", sameParams, result, cacheKey));
+    EXPECT_TRUE(cacheKey.empty());
+
+    // The least recently used result is removed when over capacity
+    for (int i=0; i<3; i++)
+    {
+        params["b"] = i + 10;
+        EXPECT_FALSE(cache.Lookup(ServerIpAddress, ServerPort, "lookup", params, result, cacheKey));
+        result = i;
+        cache.Complete(cacheKey, result, true);
+    }
+    EXPECT_EQ(cache.GetSize(), 2u);
+    EXPECT_FALSE(cache.Lookup(ServerIpAddress, ServerPort, "lookup", sameParams, result, cacheKey));
+    cache.Complete(cacheKey, result, false);
+
+    // Shared params are matched by their contents, not by the shared data that holds them
+    Value config;
+    config["mode"] = "first";
+    Value sharedParams;
+    sharedParams.SetShared(new SharedValue(config));
+    EXPECT_FALSE(cache.Lookup(ServerIpAddress, ServerPort, "lookup", sharedParams, result, cacheKey));
+    result = "first";
+    cache.Complete(cacheKey, result, true);
+    for (int i=0; i<4; i++)
+    {
+        // a new shared value may reuse the address of the freed one
+        Value otherConfig;
+        otherConfig["mode"] = i;
+        sharedParams.SetShared(new SharedValue(otherConfig));
+        EXPECT_FALSE(cache.Lookup(ServerIpAddress, ServerPort, "lookup", sharedParams, result, cacheKey));
+        cache.Complete(cacheKey, result, false);
+    }
+    sharedParams.SetShared(new SharedValue(config));
+    EXPECT_TRUE(cache.Lookup(ServerIpAddress, ServerPort, "lookup", sharedParams, result, cacheKey));
+    EXPECT_STREQ(result.GetString(), "first");
+}
+
+TEST(Server, JsonHttpHedged)
+{
+    log_time(WARN, "JsonHttpHedged");
+    JsonHttpServerMT server;
+    JsonHttpBalancedClient client;
+
+    ServerSetup(server);
+    server.StartThread();
+    MilliSleep(50);
+
+    // Both endpoints use the same server so hedged requests always have a second choice
+    client.AddEndpoint(ServerIpAddress, ServerPort);
+    client.AddEndpoint(ServerIpAddress, ServerPort);
+    client.SetTimeout(2000);
+    client.SetHedging(true, 50);
+
+    Value params;
+    Value result;
+    params.SetArray();
+    params[0] = 5;
+    params[1] = 6;
+
+    for (int i=0; i<50; i++)
+    {
+        ASSERT_TRUE(client.Call("add", params, result));
+        if (result.IsInt())
+            EXPECT_EQ(result.GetInt(), 11);
+        else
+            EXPECT_DOUBLE_EQ(result.GetDouble(), 11);
+    }
+    server.StopThread();
+}
+
+TEST(Server, JsonHttpParamSchema)
+{
+    log_time(WARN, "JsonHttpParamSchema");
+    JsonHttpServer server;
+    JsonHttpClient client;
+
+    ParamSchemaSetup(server);
+    server.StartThread();
+    TestParamSchemaClient(client);
+    server.StopThread();
+}
+
+TEST(Server, JsonHttpLazy)
+{
+    log_time(WARN, "JsonHttpLazy");
+    JsonHttpServer server;
+    JsonHttpClient client;
+
+    LazySetup(server);
+    server.StartThread();
+    TestLazyClient(client);
+    server.StopThread();
+}
+
+TEST(Server, JsonTcpLazy)
+{
+    log_time(WARN, "JsonTcpLazy");
+    JsonTcpServer server;
+    JsonTcpClient client;
+
+    LazySetup(server);
+    server.StartThread();
+    TestLazyClient(client);
+    server.StopThread();
+}
 #endif // defined(ANYRPC_INCLUDE_JSON)
 #if defined(ANYRPC_INCLUDE_XML)
 TEST(Server, XmlHttp)
@@ -281,6 +753,18 @@ TEST(Server, MessagePackTcp)
     server.StopThread();
 }
 
+TEST(Server, MessagePackTcpParamSchema)
+{
+    log_time(WARN, "MessagePackTcpParamSchema");
+    MessagePackTcpServer server;
+    MessagePackTcpClient client;
+
+    ParamSchemaSetup(server);
+    server.StartThread();
+    TestParamSchemaClient(client);
+    server.StopThread();
+}
+
 TEST(Server, MessagePackHttpMT)
 {
 	log_time(WARN, "MessagePackHttpMT");
@@ -304,5 +788,18 @@ TEST(Server, MessagePackTcpMT)
     TestClient(client);
     server.StopThread();
 }
+
+TEST(Server, MessagePackTcpMTArena)
+{
+    log_time(WARN, "MessagePackTcpMTArena");
+    MessagePackTcpServerMT server;
+    MessagePackTcpClient client;
+
+    server.SetArenaBlockSize(256);
+    ServerSetup(server);
+    server.StartThread();
+    TestClient(client);
+    server.StopThread();
+}
 #endif // defined(ANYRPC_INCLUDE_MESSAGEPACK)
 #endif // defined(ANYRPC_THREADING)
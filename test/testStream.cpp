@@ -65,6 +65,63 @@ TEST(Stream,WriteStringStream)
     EXPECT_STREQ(outString.c_str(), inString.c_str());
 }
 
+TEST(Stream,Integers)
+{
+    WriteStringStream wstream;
+    wstream << 0 << ' ' << -1 << ' ' << 99 << ' ' << 100 << ' ' << (-2147483647 - 1) << ' ' << 4294967295u << ' ';
+    wstream << static_cast<long long int>(-9223372036854775807LL - 1) << ' ' << 18446744073709551615ULL << ' ';
+    wstream << static_cast<unsigned long int>(10000000000UL) << ' ' << 12345678901234LL;
+
+    EXPECT_STREQ(wstream.GetString().c_str(), "0 -1 99 100 -2147483648 4294967295 "
+                 "-9223372036854775808 18446744073709551615 10000000000 12345678901234");
+
+    string expected;
+    wstream.Clear();
+    for (uint64_t u=1; u<ANYRPC_UINT64_C2(0x19999999, 0x99999999); u=u*10+u%7)
+    {
+        wstream << u << ',';
+        expected += to_string(u) + ',';
+    }
+    EXPECT_STREQ(wstream.GetString().c_str(), expected.c_str());
+}
+
+TEST(Stream,Reserve)
+{
+    WriteSegmentedStream segStream;
+    WriteStringStream strStream;
+    WriteBufferedStream* streams[] = { &segStream, &strStream };
+    for (size_t n=0; n<2; n++)
+    {
+        // reserved space that doesn't fit in the current segment must start a new one
+        string inString;
+        for (int i=0; i<500; i++)
+        {
+            StreamReservation<40> out(*streams[n]);
+            char* p = out.Begin();
+            memcpy(p, abcString.c_str(), i % 27);
+            out.Commit(p + i % 27);
+            streams[n]->Put('|');
+            inString += abcString.substr(0, i % 27) + '|';
+        }
+        char* p = streams[n]->Reserve(5000);
+        ASSERT_TRUE(p != 0);
+        memset(p, 'x', 5000);
+        streams[n]->Commit(4000);
+        inString += string(4000, 'x');
+
+        string outString;
+        size_t offset = 0;
+        size_t length;
+        while (offset < streams[n]->Length())
+        {
+            const char* segment = streams[n]->GetBuffer(offset, length);
+            outString.append(segment, length);
+            offset += length;
+        }
+        EXPECT_EQ(outString, inString);
+    }
+}
+
 TEST(Stream,FileStream)
 {
     char binFile[] = "test.bin";
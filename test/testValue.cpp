@@ -87,6 +87,310 @@ TEST(Value, Map)
     EXPECT_EQ(iter, value.MemberEnd());
 }
 
+TEST(Value, Size)
+{
+#if defined(ANYRPC_PACKED_VALUE) || !ANYRPC_64BIT
+    EXPECT_EQ(sizeof(Value), (size_t)16);
+#else
+    EXPECT_EQ(sizeof(Value), (size_t)24);
+#endif
+
+    // large capacities may be rounded up to fit the layout
+    Value value;
+    value.SetArray();
+    value.Reserve(40000);
+    EXPECT_GE(value.Capacity(), (size_t)40000);
+    value.SetSize(50001);
+    EXPECT_GE(value.Capacity(), (size_t)50001);
+    value[50000] = 1.5;
+    EXPECT_EQ(value.Size(), (size_t)50001);
+    EXPECT_DOUBLE_EQ(value[50000].GetDouble(), 1.5);
+}
+
+TEST(Value, TypedArray)
+{
+    double data[20];
+    for (int i=0; i<20; i++)
+        data[i] = i * 0.5;
+    Value value;
+    value.SetTypedArray(TypedDouble, data, 20);
+    EXPECT_TRUE(value.IsArray());
+    EXPECT_TRUE(value.IsTypedArray());
+    EXPECT_EQ(value.GetTypedArrayType(), TypedDouble);
+    EXPECT_EQ(value.Size(), (size_t)20);
+    EXPECT_DOUBLE_EQ(static_cast<const double*>(value.GetTypedArrayData())[3], 1.5);
+
+    // copying and traversing keep the typed representation
+    Value copy;
+    copy.Copy(value);
+    EXPECT_TRUE(copy.IsTypedArray());
+    Document doc;
+    doc.StartDocument();
+    copy.Traverse(doc);
+    EXPECT_TRUE(doc.GetValue().IsTypedArray());
+
+    // element access expands to a standard array
+    EXPECT_DOUBLE_EQ(value[19].GetDouble(), 9.5);
+    EXPECT_FALSE(value.IsTypedArray());
+    EXPECT_EQ(value.Size(), (size_t)20);
+
+    // pack standard arrays when all elements have the same number type
+    EXPECT_TRUE(value.PackTypedArray());
+    EXPECT_EQ(value.GetTypedArrayType(), TypedDouble);
+    Value ints;
+    for (int i=0; i<20; i++)
+        ints[i] = i;
+    EXPECT_TRUE(ints.PackTypedArray());
+    EXPECT_EQ(ints.GetTypedArrayType(), TypedInt32);
+    ints.ExpandTypedArray();
+    ints.PushBack(Value(static_cast<int64_t>(1) << 32));
+    EXPECT_TRUE(ints.PackTypedArray());
+    EXPECT_EQ(ints.GetTypedArrayType(), TypedInt64);
+    EXPECT_EQ(ints[20].GetInt64(), static_cast<int64_t>(1) << 32);
+    ints[21] = "string";
+    EXPECT_FALSE(ints.PackTypedArray());
+}
+
+TEST(Value, Shared)
+{
+    Value config;
+    config["name"] = "a string that is too long to be stored inside the value";
+    config["values"][0] = 3.5;
+    SharedValue* shared = new SharedValue(config);
+
+    Value value;
+    value.SetShared(shared);
+    EXPECT_TRUE(value.IsShared());
+    EXPECT_EQ(shared->GetRefCount(), 1u);
+    EXPECT_TRUE(value.GetShared().IsMap());
+    EXPECT_EQ(value.GetShared().MemberCount(), (size_t)2);
+
+    // copies only add references to the same data
+    Value result;
+    result["config"].Copy(value);
+    result["again"] = value;
+    EXPECT_EQ(shared->GetRefCount(), 3u);
+    EXPECT_EQ(&result["config"].GetShared(), &value.GetShared());
+
+    // traversing the result includes the shared data
+    WriteStringStream os;
+    JsonWriter writer(os);
+    writer << result["config"];
+    WriteStringStream os2;
+    JsonWriter writer2(os2);
+    writer2 << config;
+    EXPECT_STREQ(os.GetBuffer(), os2.GetBuffer());
+
+    result.SetNull();
+    EXPECT_EQ(shared->GetRefCount(), 1u);
+
+#if defined(ANYRPC_THREADING)
+    // references can be added and removed from several threads at once
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; t++)
+        threads.push_back(std::thread([&value]() {
+            for (int i=0; i<1000; i++)
+            {
+                Value copy;
+                copy.Copy(value);
+            }
+        }));
+    for (size_t t=0; t<threads.size(); t++)
+        threads[t].join();
+    EXPECT_EQ(shared->GetRefCount(), 1u);
+#endif
+}
+
+TEST(Value, InternedKeys)
+{
+    // the protocol keys are interned at startup
+    const char* method = KeyTable::Find("method", 6);
+    ASSERT_TRUE(method != 0);
+    EXPECT_EQ(KeyTable::Intern("method"), method);
+    EXPECT_TRUE(KeyTable::Find("notInterned", 11) == 0);
+
+    Value map;
+    map["params"] = 5;
+    map["notInterned"] = 6;
+    EXPECT_TRUE(map.MemberBegin().GetKey().IsInterned());
+    EXPECT_EQ(map.MemberBegin().GetKey().GetString(), KeyTable::Find("params", 6));
+    EXPECT_FALSE((++map.MemberBegin()).GetKey().IsInterned());
+
+    // members added before the key was interned are still found
+    const char* schemaKey = KeyTable::Intern("aSchemaKeyLongerThanShortStrings");
+    ASSERT_TRUE(schemaKey != 0);
+    EXPECT_EQ(KeyTable::GetHash(schemaKey), KeyTable::Hash(schemaKey, strlen(schemaKey)));
+    EXPECT_EQ(map["notInterned"].GetInt(), 6);
+    Value key(schemaKey, false);
+    Value seven(7);
+    map.AddMember(key, seven);
+    EXPECT_EQ(map.MemberCount(), (size_t)3);
+    EXPECT_EQ(map["aSchemaKeyLongerThanShortStrings"].GetInt(), 7);
+
+    // copies keep the interned keys and large maps use the hash index with them
+    Value copy;
+    copy.Copy(map);
+    for (int i=0; i<100; i++)
+    {
+        char name[10];
+        snprintf(name, sizeof(name), "%d", i);
+        copy[name] = i;
+    }
+    EXPECT_TRUE(copy.FindMember("params").GetKey().IsInterned());
+    EXPECT_EQ(copy["params"].GetInt(), 5);
+    EXPECT_EQ(copy["aSchemaKeyLongerThanShortStrings"].GetInt(), 7);
+    EXPECT_EQ(copy["99"].GetInt(), 99);
+    EXPECT_EQ(copy.MemberCount(), (size_t)103);
+}
+
+TEST(Value, Get)
+{
+    Value map;
+    map["method"] = "add";
+    map["id"] = 5;
+    map["name"] = "value";
+
+    // missing keys are not added
+    const Value& constMap = map;
+    ASSERT_TRUE(constMap.Get("id") != 0);
+    EXPECT_EQ(constMap.Get("id")->GetInt(), 5);
+    EXPECT_TRUE(constMap.Get("params") == 0);
+    EXPECT_TRUE(map.Get(std::string("missing")) == 0);
+    EXPECT_EQ(map.MemberCount(), (size_t)3);
+    map.Get("name")->SetInt(7);
+    EXPECT_EQ(map["name"].GetInt(), 7);
+
+    static const char* const keys[] = { "params", "name", "method", "id" };
+    const Value* values[4];
+    EXPECT_EQ(constMap.GetMembers(keys, 4, values), (size_t)3);
+    EXPECT_TRUE(values[0] == 0);
+    EXPECT_EQ(values[1]->GetInt(), 7);
+    EXPECT_STREQ(values[2]->GetString(), "add");
+    EXPECT_EQ(values[3]->GetInt(), 5);
+    EXPECT_EQ(map.MemberCount(), (size_t)3);
+
+    // more keys than are resolved at once
+    Value members;
+    std::vector<std::string> names;
+    for (int k=0; k<40; k++)
+        names.push_back("key" + std::to_string(k));
+    for (int k=0; k<40; k+=2)
+        members[names[k]] = k;
+    const char* manyKeys[40];
+    const Value* manyValues[40];
+    for (size_t k=0; k<40; k++)
+        manyKeys[k] = names[k].c_str();
+    EXPECT_EQ(members.GetMembers(manyKeys, 40, manyValues), (size_t)20);
+    EXPECT_TRUE(manyValues[37] == 0);
+    ASSERT_TRUE(manyValues[38] != 0);
+    EXPECT_EQ(manyValues[38]->GetInt(), 38);
+
+    // other types don't have members
+    Value array;
+    array[0] = 1;
+    EXPECT_TRUE(array.Get("id") == 0);
+    EXPECT_EQ(array.GetMembers(keys, 4, values), (size_t)0);
+    EXPECT_TRUE(values[3] == 0);
+
+    // large maps use the hash index when it is complete
+    Value large;
+    for (int i=0; i<100; i++)
+    {
+        char name[10];
+        snprintf(name, sizeof(name), "%d", i);
+        large[name] = i;
+    }
+    EXPECT_EQ(large.Get("42")->GetInt(), 42);
+    large.FindMember("0");
+    EXPECT_EQ(large.Get("99")->GetInt(), 99);
+    EXPECT_TRUE(large.Get("100") == 0);
+    EXPECT_EQ(large.MemberCount(), (size_t)100);
+}
+
+TEST(Value, LargeMap)
+{
+    const int numMembers = 5000;
+    Value value;
+    for (int i=0; i<numMembers; i++)
+    {
+        std::stringstream key;
+        key << "key" << i;
+        value[key.str()] = i;
+        // interleave searches with additions so the index is extended as the map grows
+        if ((i % 100) == 0)
+        {
+            EXPECT_TRUE(value.HasMember("key0"));
+        }
+    }
+
+    EXPECT_EQ(value.MemberCount(), (size_t)numMembers);
+    for (int i=0; i<numMembers; i++)
+    {
+        std::stringstream key;
+        key << "key" << i;
+        ASSERT_TRUE(value.HasMember(key.str()));
+        EXPECT_EQ(value[key.str()].GetInt(), i);
+    }
+    EXPECT_FALSE(value.HasMember("key5000"));
+
+    // The first member is found with duplicate keys
+    Value duplicate(7);
+    value.AddMember("key10", duplicate);
+    EXPECT_EQ(value["key10"].GetInt(), 10);
+    EXPECT_EQ(value.MemberCount(), (size_t)numMembers+1);
+
+    // The copy has its own index
+    Value copy(value);
+    EXPECT_EQ(copy["key4999"].GetInt(), 4999);
+    EXPECT_EQ(copy["key10"].GetInt(), 10);
+}
+
+TEST(Value, Arena)
+{
+    MemoryArena arena(256);
+    {
+        ArenaScope scope(&arena);
+        Value value;
+        for (int i=0; i<100; i++)
+        {
+            std::stringstream key;
+            key << "key" << i;
+            value[key.str()] = "a string that is too long to be stored inside the value";
+            value["array"][i] = i;
+        }
+        EXPECT_GT(arena.GetUsed(), (size_t)0);
+        EXPECT_EQ(value.MemberCount(), (size_t)101);
+        EXPECT_EQ(value["array"].Size(), (size_t)100);
+        EXPECT_EQ(value["array"][99].GetInt(), 99);
+        EXPECT_STREQ(value["key42"].GetString(), "a string that is too long to be stored inside the value");
+
+        // a copy made without an arena must survive the reset
+        Value copy;
+        {
+            ArenaScope heapScope(0);
+            copy.Copy(value["array"]);
+            // growing arena data without an arena moves it to the heap
+            value["array"][200] = 200;
+        }
+        EXPECT_EQ(MemoryArena::GetCurrent(), &arena);
+
+        std::size_t capacity = arena.GetCapacity();
+        value.SetNull();
+        arena.Reset();
+        EXPECT_EQ(arena.GetUsed(), (size_t)0);
+        // the blocks are combined into one large enough for the data
+        EXPECT_EQ(arena.GetCapacity(), capacity);
+        EXPECT_EQ(copy.Size(), (size_t)100);
+        EXPECT_EQ(copy[50].GetInt(), 50);
+    }
+    EXPECT_EQ(MemoryArena::GetCurrent(), (MemoryArena*)0);
+
+    // the last allocation is extended in place
+    char* data = static_cast<char*>(arena.Malloc(10));
+    EXPECT_EQ(arena.Realloc(data, 10, 100), data);
+    EXPECT_NE(arena.Realloc(arena.Malloc(10), 10, 100), data);
+}
+
 TEST(Value, Copy)
 {
     Value value;
@@ -110,6 +414,49 @@ TEST(Value, Assign)
     EXPECT_EQ(value2.GetInt(), 10);
 }
 
+#if ANYRPC_HAS_RVALUE_REFS
+TEST(Value, Move)
+{
+    const char* longString = "a string that is too long to be stored inside the value";
+    Value value(longString);
+    const char* data = value.GetString();
+
+    Value value2(std::move(value));
+    EXPECT_TRUE(value.IsNull());
+    EXPECT_EQ(value2.GetString(), data);
+
+    value = std::move(value2);
+    EXPECT_TRUE(value2.IsNull());
+    EXPECT_EQ(value.GetString(), data);
+
+    Value map;
+    map.AddMember("string", std::move(value));
+    map.AddMember(std::string("int"), Value(5));
+    Value key("key");
+    map.AddMember(key, Value(6));
+    map.AddMember(Value("key2"), Value(7));
+    EXPECT_TRUE(value.IsNull());
+    EXPECT_EQ(map["string"].GetString(), data);
+    EXPECT_EQ(map["int"].GetInt(), 5);
+    EXPECT_EQ(map["key"].GetInt(), 6);
+    EXPECT_EQ(map["key2"].GetInt(), 7);
+
+    Value array;
+    array.SetArray();
+    array.PushBack(Value(1)).PushBack(std::move(map["string"]));
+    EXPECT_EQ(array.Size(), (size_t)2);
+    EXPECT_EQ(array[1].GetString(), data);
+
+    // growing the vector moves the values instead of copying them
+    std::vector<Value> values;
+    values.push_back(Value(longString));
+    data = values[0].GetString();
+    for (int i=0; i<100; i++)
+        values.push_back(Value(i));
+    EXPECT_EQ(values[0].GetString(), data);
+}
+#endif
+
 #if defined(ANYRPC_WCHAR)
 TEST(Value, Unicode)
 {
@@ -19,6 +19,7 @@
 // THE SOFTWARE.
 
 #include "anyrpc/anyrpc.h"
+#include "anyrpc/internal/strscan.h"
 
 #include <gtest/gtest.h>
 #include <fstream>
@@ -178,6 +179,28 @@ TEST(Xml,Double)
     EXPECT_DOUBLE_EQ(value.GetDouble(), outValue.GetDouble());
 }
 
+TEST(Xml,DoubleRoundTrip)
+{
+    const double values[] = { 0.1, 1.0/3.0, 0.1 + 0.2, 1e23, -9.999e307, 4.9406564584124654e-324, 123456.789,
+                              9.82961505958888e-309, 2.2250738585072011e-308, 1.2345678901234567e-315 };
+    for (size_t i=0; i<sizeof(values)/sizeof(values[0]); i++)
+    {
+        Value value, outValue;
+        value.SetDouble(values[i]);
+        WriteReadValue(value, outValue);
+        EXPECT_EQ(value.GetDouble(), outValue.GetDouble());
+    }
+
+    WriteStringStream os;
+    XmlWriter writer(os);
+    writer.Double(0.1);
+    writer.Double(-1.5e-7);
+    writer.SetScientificPrecision();
+    writer.Double(1.5e-7);
+    EXPECT_STREQ(os.GetBuffer(), "<value><double>0.1</double></value><value><double>-0.00000015</double></value>"
+                                 "<value><double>1.5e-07</double></value>");
+}
+
 TEST(Xml,String1)
 {
     string outString = ReadWriteData("<value>Test string data</value>");
@@ -214,6 +237,38 @@ TEST(Xml,String7)
     EXPECT_STREQ( outString.c_str(), "<value></value>");
 }
 
+TEST(Xml,WriteLongString)
+{
+    // escapes at every offset within and across the vector width
+    string text;
+    string expected = "<value>";
+    for (int i=0; i<300; i++)
+    {
+        string run(i % 41, 'a' + i % 26);
+        text += run;
+        expected += run;
+        switch (i % 6)
+        {
+            case 0: text += '<';    expected += "&lt;";   break;
+            case 1: text += '&';    expected += "&amp;";  break;
+            case 2: text += '\'';   expected += "&apos;"; break;
+            case 3: text += '\x1f'; expected += "&#x1F;"; break;
+            case 4: text += "\t\n"; expected += "\t\n";   break;
+            case 5: text += '>';    expected += "&gt;";   break;
+        }
+    }
+    expected += "</value>";
+
+    WriteStringStream os;
+    XmlWriter writer(os);
+    writer.String(text.c_str(), text.length());
+    EXPECT_EQ(os.GetString(), expected);
+
+    string quote(40, ' ');
+    quote[35] = '\"';
+    EXPECT_EQ(internal::ScanXmlString(quote.c_str(), quote.length()), (size_t)35);
+}
+
 TEST(Xml,Array)
 {
     char inString[] = "<value><array><data>"